@@ -0,0 +1,111 @@
+// create/get/free throughput of HandledCache with 100k live objects. Run with `zig build bench_handles`.
+// The paged cache is compared against the original flat layout: one preallocated array that can never grow. The flat
+// cache is widened to u32 handles here since the original u16/u8/u8 layout tops out at 254 objects.
+const std = @import("std");
+const renderkit = @import("renderkit");
+
+const live_objects: usize = 100_000;
+const rounds: usize = 10;
+
+const Sprite = struct {
+    x: f32 = 0,
+    y: f32 = 0,
+    tex: u32 = 0,
+    color: u32 = 0xFFFFFFFF,
+};
+
+fn FlatHandledCache(comptime T: type) type {
+    return struct {
+        items: []T,
+        handles: renderkit.Handles(u32, u20, u12),
+
+        pub fn init(allocator: *std.mem.Allocator, capacity: usize) @This() {
+            return .{
+                .items = allocator.alloc(T, capacity) catch unreachable,
+                .handles = renderkit.Handles(u32, u20, u12).init(allocator, capacity),
+            };
+        }
+
+        pub fn deinit(self: @This()) void {
+            self.handles.allocator.free(self.items);
+            self.handles.deinit();
+        }
+
+        pub fn append(self: *@This(), item: T) u32 {
+            var handle = self.handles.create();
+            self.items[self.handles.extractIndex(handle)] = item;
+            return handle;
+        }
+
+        pub fn get(self: @This(), handle: u32) *T {
+            std.debug.assert(self.handles.alive(handle));
+            return &self.items[self.handles.extractIndex(handle)];
+        }
+
+        pub fn free(self: *@This(), handle: u32) *T {
+            std.debug.assert(self.handles.alive(handle));
+            var obj = &self.items[self.handles.extractIndex(handle)];
+            self.handles.destroy(handle);
+            return obj;
+        }
+    };
+}
+
+const Results = struct {
+    create_ns: u64 = 0,
+    get_ns: u64 = 0,
+    free_ns: u64 = 0,
+    checksum: u64 = 0,
+};
+
+fn run(comptime Cache: type, initial_capacity: usize, handles: []u32, order: []usize) !Results {
+    var results = Results{};
+    var timer = try std.time.Timer.start();
+
+    var cache = Cache.init(std.heap.page_allocator, initial_capacity);
+    defer cache.deinit();
+
+    var round: usize = 0;
+    while (round < rounds) : (round += 1) {
+        timer.reset();
+        for (handles) |*h, i| h.* = cache.append(.{ .x = @intToFloat(f32, i), .tex = @intCast(u32, i) });
+        results.create_ns += timer.lap();
+
+        // random access pattern, which is what applyBindings/draw look like for a real frame
+        for (order) |i| results.checksum +%= cache.get(handles[i]).tex;
+        results.get_ns += timer.lap();
+
+        for (order) |i| results.checksum +%= cache.free(handles[i]).tex;
+        results.free_ns += timer.lap();
+    }
+
+    return results;
+}
+
+fn report(name: []const u8, results: Results) void {
+    const ops = @intToFloat(f64, live_objects * rounds);
+    std.debug.print("{}: create {d:.2} ns/op, get {d:.2} ns/op, free {d:.2} ns/op (checksum {})\n", .{
+        name,
+        @intToFloat(f64, results.create_ns) / ops,
+        @intToFloat(f64, results.get_ns) / ops,
+        @intToFloat(f64, results.free_ns) / ops,
+        results.checksum,
+    });
+}
+
+pub fn main() !void {
+    var handles = try std.heap.page_allocator.alloc(u32, live_objects);
+    defer std.heap.page_allocator.free(handles);
+
+    var order = try std.heap.page_allocator.alloc(usize, live_objects);
+    defer std.heap.page_allocator.free(order);
+    for (order) |*o, i| o.* = i;
+
+    var prng = std.rand.DefaultPrng.init(0x1234);
+    prng.random.shuffle(usize, order);
+
+    std.debug.print("{} live objects, {} rounds\n", .{ live_objects, rounds });
+    report("flat (preallocated)", try run(FlatHandledCache(Sprite), live_objects + 1, handles, order));
+    report("paged (preallocated)", try run(renderkit.HandledCache(Sprite), live_objects + 1, handles, order));
+    report("paged (grown from 64)", try run(renderkit.HandledCache(Sprite), 64, handles, order));
+}
@@ -0,0 +1,81 @@
+// CPU mip generation throughput in source megapixels per second. Run with `zig build bench_mip_downsample`. The scalar
+// baseline averages every channel byte by byte, the renderkit box filter works on four texels at a time and both
+// filters are measured on one thread and on every core.
+const std = @import("std");
+const renderkit = @import("renderkit");
+const mipmaps = renderkit.mipmaps;
+
+const size: u32 = 2048;
+const runs: usize = 8;
+
+fn scalarBox(src: []const u32, width: u32, height: u32, dst: []u32) void {
+    const dst_width = width / 2;
+    var y: u32 = 0;
+    while (y < height / 2) : (y += 1) {
+        var x: u32 = 0;
+        while (x < dst_width) : (x += 1) {
+            const texels = [4]u32{
+                src[2 * y * width + 2 * x],
+                src[2 * y * width + 2 * x + 1],
+                src[(2 * y + 1) * width + 2 * x],
+                src[(2 * y + 1) * width + 2 * x + 1],
+            };
+            var result: u32 = 0;
+            var shift: u5 = 0;
+            while (true) : (shift += 8) {
+                var sum: u32 = 2;
+                for (texels) |texel| sum += (texel >> shift) & 0xFF;
+                result |= (sum / 4) << shift;
+                if (shift == 24) break;
+            }
+            dst[y * dst_width + x] = result;
+        }
+    }
+}
+
+fn report(name: []const u8, ns: u64) void {
+    const megapixels = @intToFloat(f64, size * size) / 1_000_000;
+    const ms = @intToFloat(f64, ns) / std.time.ns_per_ms;
+    std.debug.print("{}: {d:.2} ms per level, {d:.0} MP/s\n", .{ name, ms, megapixels / (ms / 1000) });
+}
+
+/// fastest of `runs` runs, which filters out scheduling noise
+fn measure(filter: ?mipmaps.Filter, src: []const u32, dst: []u32, num_threads: usize) u64 {
+    var best: u64 = std.math.maxInt(u64);
+    var i: usize = 0;
+    while (i < runs) : (i += 1) {
+        var timer = std.time.Timer.start() catch unreachable;
+        if (filter) |f| {
+            mipmaps.downsampleParallel(f, src, size, size, dst, num_threads);
+        } else {
+            scalarBox(src, size, size, dst);
+        }
+        best = std.math.min(best, timer.read());
+    }
+    return best;
+}
+
+pub fn main() !void {
+    const allocator = std.heap.page_allocator;
+    var src = try allocator.alloc(u32, size * size);
+    defer allocator.free(src);
+    var dst = try allocator.alloc(u32, size * size / 4);
+    defer allocator.free(dst);
+
+    var rng = std.rand.DefaultPrng.init(0);
+    for (src) |*texel| texel.* = rng.random.int(u32);
+
+    const cores = std.Thread.cpuCount() catch 1;
+    std.debug.print("{}x{} rgba8 to {}x{}, {} cores\n", .{ size, size, size / 2, size / 2, cores });
+
+    report("scalar box", measure(null, src, dst, 1));
+    report("box, 1 thread", measure(.box, src, dst, 1));
+    report("box, all cores", measure(.box, src, dst, cores));
+    report("kaiser, 1 thread", measure(.kaiser, src, dst, 1));
+    report("kaiser, all cores", measure(.kaiser, src, dst, cores));
+
+    var timer = try std.time.Timer.start();
+    const chain = mipmaps.MipChain.init(allocator, src, size, size, .box, cores);
+    defer chain.deinit();
+    std.debug.print("full box chain of {} levels: {d:.2} ms\n", .{ chain.num_levels, @intToFloat(f64, timer.read()) / std.time.ns_per_ms });
+}
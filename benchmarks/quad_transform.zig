@@ -0,0 +1,93 @@
+// quad transform and color packing throughput in sprites per second per core. Run with `zig build bench_quad_transform`.
+// Both the scalar fallback and the vector path expand the same sprites into four vertices each. The all cores run
+// splits the sprites into one band per core and divides the total rate by the core count.
+const std = @import("std");
+const renderkit = @import("renderkit");
+const quads = renderkit.quads;
+
+const num_sprites: usize = 1 << 20;
+const runs: usize = 8;
+const max_threads = 16;
+
+const Band = struct {
+    vector: bool,
+    sprites: quads.Sprites,
+    verts: []quads.Vertex,
+
+    fn run(self: *const Band) void {
+        const matrix = quads.Mat32.ortho(1920, 1080);
+        if (self.vector) {
+            quads.transform(matrix, self.sprites, self.verts);
+        } else {
+            quads.transformScalar(matrix, self.sprites, self.verts);
+        }
+    }
+};
+
+fn slice(sprites: quads.Sprites, start: usize, end: usize) quads.Sprites {
+    var result = sprites;
+    inline for (std.meta.fields(quads.Sprites)) |field| {
+        @field(result, field.name) = @field(sprites, field.name)[start..end];
+    }
+    return result;
+}
+
+fn expand(vector: bool, sprites: quads.Sprites, verts: []quads.Vertex, num_threads: usize) void {
+    var bands: [max_threads]Band = undefined;
+    var threads = [_]?*std.Thread{null} ** max_threads;
+    for (bands[0..num_threads]) |*band, i| {
+        const start = sprites.len() * i / num_threads;
+        const end = sprites.len() * (i + 1) / num_threads;
+        band.* = .{ .vector = vector, .sprites = slice(sprites, start, end), .verts = verts[start * 4 .. end * 4] };
+        if (i > 0) threads[i] = std.Thread.spawn(@as(*const Band, band), Band.run) catch null;
+    }
+
+    for (bands[0..num_threads]) |*band, i| {
+        if (threads[i] == null) band.run();
+    }
+    for (threads[0..num_threads]) |thread| {
+        if (thread) |t| t.wait();
+    }
+}
+
+fn report(name: []const u8, ns: u64, num_threads: usize) void {
+    const ms = @intToFloat(f64, ns) / std.time.ns_per_ms;
+    const per_core = @intToFloat(f64, num_sprites) / (ms / 1000) / @intToFloat(f64, num_threads);
+    std.debug.print("{}: {d:.2} ms, {d:.1} M sprites/s per core\n", .{ name, ms, per_core / 1_000_000 });
+}
+
+/// fastest of `runs` runs, which filters out scheduling noise
+fn measure(vector: bool, sprites: quads.Sprites, verts: []quads.Vertex, num_threads: usize) u64 {
+    var best: u64 = std.math.maxInt(u64);
+    var i: usize = 0;
+    while (i < runs) : (i += 1) {
+        var timer = std.time.Timer.start() catch unreachable;
+        expand(vector, sprites, verts, num_threads);
+        best = std.math.min(best, timer.read());
+    }
+    return best;
+}
+
+pub fn main() !void {
+    const allocator = std.heap.page_allocator;
+    var fields = try allocator.alloc(f32, num_sprites * 12);
+    defer allocator.free(fields);
+    var verts = try allocator.alloc(quads.Vertex, num_sprites * 4);
+    defer allocator.free(verts);
+
+    var rng = std.rand.DefaultPrng.init(0);
+    for (fields) |*value| value.* = rng.random.float(f32);
+
+    var sprites: quads.Sprites = undefined;
+    inline for (std.meta.fields(quads.Sprites)) |field, i| {
+        @field(sprites, field.name) = fields[i * num_sprites ..][0..num_sprites];
+    }
+
+    const cores = std.math.min(std.Thread.cpuCount() catch 1, max_threads);
+    std.debug.print("{} sprites, {} byte vertices, {} lanes, {} cores\n", .{ num_sprites, @sizeOf(quads.Vertex), quads.lanes, cores });
+
+    report("scalar, 1 thread", measure(false, sprites, verts, 1), 1);
+    report("vector, 1 thread", measure(true, sprites, verts, 1), 1);
+    report("scalar, all cores", measure(false, sprites, verts, cores), cores);
+    report("vector, all cores", measure(true, sprites, verts, cores), cores);
+}
@@ -0,0 +1,141 @@
+// CPU cost and upload bytes of submitting sprites, in sprites per second. Run with `zig build bench_sprite_batch`. The
+// naive path rotates and expands every sprite into four vertices on the CPU and appends them, the SpriteBatch appends
+// one 52 byte instance per sprite and leaves the expansion to the vertex shader. Both append into one CPU buffer that
+// is reused every frame, so the byte count is the bus traffic a real stream buffer would see.
+const std = @import("std");
+const renderkit = @import("renderkit");
+
+const runs: usize = 8;
+const num_textures: u32 = 4;
+
+const FakeRenderer = struct {
+    var stream: []u8 = undefined;
+    var appended: usize = 0;
+    var draws: u32 = 0;
+
+    pub fn createBuffer(comptime T: type, desc: renderkit.BufferDesc(T)) renderkit.Buffer {
+        return 1;
+    }
+
+    pub fn destroyBuffer(buffer: renderkit.Buffer) void {}
+
+    pub fn appendBuffer(comptime T: type, buffer: renderkit.Buffer, verts: []const T) u32 {
+        const bytes = std.mem.sliceAsBytes(verts);
+        const offset = appended;
+        std.mem.copy(u8, stream[offset..], bytes);
+        appended += bytes.len;
+        return @intCast(u32, offset);
+    }
+
+    pub fn applyBindings(bindings: renderkit.BufferBindings) void {}
+
+    pub fn drawElements(cmd: renderkit.DrawCommand) void {
+        draws += 1;
+    }
+
+    fn beginFrame() void {
+        appended = 0;
+        draws = 0;
+    }
+};
+
+const Vertex = extern struct {
+    pos: extern struct { x: f32, y: f32 },
+    uv: extern struct { x: f32, y: f32 },
+    col: u32,
+};
+
+/// what a batcher without instancing does: four transformed vertices per sprite, flushed on every texture change
+fn naiveFrame(sprites: []const renderkit.Sprite, verts: []Vertex) void {
+    var count: usize = 0;
+    for (sprites) |sprite, i| {
+        const c = std.math.cos(sprite.rotation);
+        const s = std.math.sin(sprite.rotation);
+        const corners = [4][2]f32{ .{ 0, 0 }, .{ 1, 0 }, .{ 1, 1 }, .{ 0, 1 } };
+        for (corners) |corner, j| {
+            const lx = (corner[0] - sprite.origin_x) * sprite.width;
+            const ly = (corner[1] - sprite.origin_y) * sprite.height;
+            verts[count + j] = .{
+                .pos = .{ .x = sprite.x + lx * c - ly * s, .y = sprite.y + lx * s + ly * c },
+                .uv = .{ .x = sprite.uv[0] + corner[0] * sprite.uv[2], .y = sprite.uv[1] + corner[1] * sprite.uv[3] },
+                .col = sprite.color,
+            };
+        }
+        count += 4;
+
+        if (i + 1 == sprites.len or textureOf(i + 1) != textureOf(i) or count == verts.len) {
+            _ = FakeRenderer.appendBuffer(Vertex, 1, verts[0..count]);
+            FakeRenderer.drawElements(.{ .element_count = @intCast(c_int, count / 4 * 6) });
+            count = 0;
+        }
+    }
+}
+
+/// sprites come in runs of 16 per texture so the naive path flushes often and the batch never runs out of slots
+fn textureOf(sprite: usize) renderkit.Image {
+    return @intCast(renderkit.Image, (sprite / 16) % num_textures + 1);
+}
+
+fn report(name: []const u8, num_sprites: usize, ns: u64) void {
+    const ms = @intToFloat(f64, ns) / std.time.ns_per_ms;
+    const megabytes = @intToFloat(f64, FakeRenderer.appended) / (1024 * 1024);
+    std.debug.print("{}: {d:.2} ms per frame, {d:.1} M sprites/s, {d:.1} MB uploaded, {} draws\n", .{
+        name,
+        ms,
+        @intToFloat(f64, num_sprites) / (ms / 1000) / 1_000_000,
+        megabytes,
+        FakeRenderer.draws,
+    });
+}
+
+/// fastest of `runs` frames, which filters out scheduling noise
+fn measure(sprites: []const renderkit.Sprite, batch: ?*renderkit.SpriteBatch(FakeRenderer), verts: []Vertex) u64 {
+    var best: u64 = std.math.maxInt(u64);
+    var i: usize = 0;
+    while (i < runs) : (i += 1) {
+        FakeRenderer.beginFrame();
+        var timer = std.time.Timer.start() catch unreachable;
+        if (batch) |b| {
+            for (sprites) |sprite, j| b.draw(textureOf(j), sprite);
+            b.flush();
+        } else {
+            naiveFrame(sprites, verts);
+        }
+        best = std.math.min(best, timer.read());
+    }
+    return best;
+}
+
+pub fn main() !void {
+    const allocator = std.heap.page_allocator;
+    const max_sprites: usize = 1_000_000;
+
+    var sprites = try allocator.alloc(renderkit.Sprite, max_sprites);
+    defer allocator.free(sprites);
+    var rng = std.rand.DefaultPrng.init(0);
+    for (sprites) |*sprite| sprite.* = .{
+        .x = rng.random.float(f32) * 1920,
+        .y = rng.random.float(f32) * 1080,
+        .width = 32,
+        .height = 32,
+        .rotation = rng.random.float(f32) * std.math.pi * 2,
+        .origin_x = 0.5,
+        .origin_y = 0.5,
+        .color = rng.random.int(u32),
+    };
+
+    FakeRenderer.stream = try allocator.alloc(u8, max_sprites * 4 * @sizeOf(Vertex));
+    defer allocator.free(FakeRenderer.stream);
+    var verts = try allocator.alloc(Vertex, 4 * 16 * 1024);
+    defer allocator.free(verts);
+
+    var batch = renderkit.SpriteBatch(FakeRenderer).init(allocator, 16 * 1024);
+    defer batch.deinit();
+
+    for ([_]usize{ 100_000, 1_000_000 }) |num_sprites| {
+        std.debug.print("{} sprites, {} textures\n", .{ num_sprites, num_textures });
+        const frame = sprites[0..num_sprites];
+        report("  naive quads", num_sprites, measure(frame, null, verts));
+        report("  sprite batch", num_sprites, measure(frame, &batch, verts));
+    }
+}
@@ -0,0 +1,129 @@
+// first-frame latency and per-frame hitch size when loading a level's worth of textures. Run with
+// `zig build bench_texture_streaming`. The synchronous path decodes and uploads every texture on the render thread
+// before the first frame, like createImage does today. The streamed path uses TextureStreamer with its worker pool and
+// per-frame upload budget. There is no GPU in the loop, FakeBackend memcpys each upload into a CPU side texture,
+// which is roughly what the driver does with the data before updateImageRegion returns.
+const std = @import("std");
+const renderkit = @import("renderkit");
+
+const num_textures: usize = 128;
+const texture_size: u32 = 512;
+
+const FakeBackend = struct {
+    var textures: std.AutoHashMap(renderkit.Image, []u32) = undefined;
+    var next_image: renderkit.Image = 1;
+
+    pub fn createImage(desc: renderkit.ImageDesc) renderkit.Image {
+        const pixels = std.heap.page_allocator.alloc(u32, @intCast(usize, desc.width * desc.height)) catch unreachable;
+        textures.put(next_image, pixels) catch unreachable;
+        next_image += 1;
+        return next_image - 1;
+    }
+
+    pub fn destroyImage(image: renderkit.Image) void {
+        if (textures.remove(image)) |entry| std.heap.page_allocator.free(entry.value);
+    }
+
+    pub fn updateImageRegion(comptime T: type, image: renderkit.Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) void {
+        const pixels = textures.get(image).?;
+        const start = @intCast(usize, y * width + x);
+        std.mem.copy(u32, pixels[start .. start + content.len], content);
+    }
+};
+
+/// stands in for png decoding: a few integer ops per pixel, roughly the cost of inflate + unfiltering
+fn decodeProcedural(context: usize, out: []u32) bool {
+    var state = @truncate(u32, context) | 1;
+    for (out) |*px| {
+        var i: u32 = 0;
+        while (i < 8) : (i += 1) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+        }
+        px.* = state | 0xFF000000;
+    }
+    return true;
+}
+
+const Results = struct {
+    first_frame_ns: u64 = 0,
+    max_frame_ns: u64 = 0,
+    total_ns: u64 = 0,
+    frames: usize = 0,
+};
+
+fn runSynchronous() Results {
+    var timer = std.time.Timer.start() catch unreachable;
+    var pixels = std.heap.page_allocator.alloc(u32, texture_size * texture_size) catch unreachable;
+    defer std.heap.page_allocator.free(pixels);
+
+    var images: [num_textures]renderkit.Image = undefined;
+    for (images) |*image, i| {
+        _ = decodeProcedural(i, pixels);
+        image.* = FakeBackend.createImage(.{ .width = texture_size, .height = texture_size });
+        FakeBackend.updateImageRegion(u32, image.*, 0, 0, texture_size, texture_size, 0, pixels);
+    }
+
+    const elapsed = timer.read();
+    for (images) |image| FakeBackend.destroyImage(image);
+    return .{ .first_frame_ns = elapsed, .max_frame_ns = elapsed, .total_ns = elapsed, .frames = 1 };
+}
+
+fn runStreamed(budget: u32) Results {
+    var results = Results{};
+    var streamer = renderkit.TextureStreamer(FakeBackend).init(std.heap.page_allocator);
+    defer streamer.deinit();
+    streamer.upload_budget = budget;
+
+    var images: [num_textures]renderkit.Image = undefined;
+    var total = std.time.Timer.start() catch unreachable;
+    var timer = std.time.Timer.start() catch unreachable;
+
+    for (images) |*image, i| {
+        image.* = streamer.createImageAsync(.{ .width = texture_size, .height = texture_size }, .{
+            .decoder = .{ .context = i, .decodeFn = decodeProcedural },
+        });
+    }
+
+    var all_ready = false;
+    while (!all_ready) {
+        streamer.update();
+        const frame_ns = timer.lap();
+        if (results.frames == 0) results.first_frame_ns = frame_ns;
+        results.max_frame_ns = std.math.max(results.max_frame_ns, frame_ns);
+        results.frames += 1;
+
+        all_ready = true;
+        for (images) |image| all_ready = all_ready and streamer.isReady(image);
+
+        // the rest of a 60hz frame, during which the workers keep decoding
+        std.time.sleep(16 * std.time.ns_per_ms - std.math.min(frame_ns, 16 * std.time.ns_per_ms));
+        _ = timer.lap();
+    }
+
+    results.total_ns = total.read();
+    for (images) |image| FakeBackend.destroyImage(image);
+    return results;
+}
+
+fn report(name: []const u8, results: Results) void {
+    std.debug.print("{}: first frame {d:.2} ms, worst frame {d:.2} ms, all ready after {} frames / {d:.1} ms\n", .{
+        name,
+        @intToFloat(f64, results.first_frame_ns) / std.time.ns_per_ms,
+        @intToFloat(f64, results.max_frame_ns) / std.time.ns_per_ms,
+        results.frames,
+        @intToFloat(f64, results.total_ns) / std.time.ns_per_ms,
+    });
+}
+
+pub fn main() !void {
+    FakeBackend.textures = std.AutoHashMap(renderkit.Image, []u32).init(std.heap.page_allocator);
+    defer FakeBackend.textures.deinit();
+
+    std.debug.print("{} textures of {}x{}, {} cores\n", .{ num_textures, texture_size, texture_size, std.Thread.cpuCount() catch 1 });
+    report("synchronous", runSynchronous());
+
+    report("streamed (2 MB/frame)", runStreamed(2 * 1024 * 1024));
+    report("streamed (8 MB/frame)", runStreamed(8 * 1024 * 1024));
+}
@@ -14,6 +14,24 @@ pub fn getRenderKitPackage(comptime prefix_path: []const u8) Pkg {
     };
 }
 
+/// builds and runs the benchmarks in the benchmarks folder. Each one gets its own step (`zig build bench_handles` for
+/// example) and `zig build bench` runs them all. Benchmarks are always built in ReleaseFast mode.
+pub fn build(b: *Builder) void {
+    const benchmarks = [_][]const u8{ "handles", "texture_streaming", "mip_downsample", "sprite_batch", "quad_transform" };
+
+    const bench_all = b.step("bench", "Run all benchmarks");
+    for (benchmarks) |name| {
+        const exe = b.addExecutable(b.fmt("bench_{}", .{name}), b.fmt("benchmarks/{}.zig", .{name}));
+        exe.setBuildMode(.ReleaseFast);
+        exe.addPackage(getRenderKitPackage(""));
+
+        const run_cmd = exe.run();
+        const bench_step = b.step(b.fmt("bench_{}", .{name}), b.fmt("Run the {} benchmark", .{name}));
+        bench_step.dependOn(&run_cmd.step);
+        bench_all.dependOn(&run_cmd.step);
+    }
+}
+
 /// prefix_path is the path to the gfx build.zig file relative to your build.zig.
 /// prefix_path is used to add package paths. It should be the the same path used to include this build file and end with a slash.
 pub fn addRenderKitToArtifact(b: *Builder, exe: *std.build.LibExeObjStep, target: std.build.Target, comptime prefix_path: []const u8) void {
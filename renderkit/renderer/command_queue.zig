@@ -0,0 +1,545 @@
+const std = @import("std");
+usingnamespace @import("types.zig");
+
+/// records draws for a pass so they can be sorted by state and replayed through the backend at `endPass`. Each draw
+/// captures the shader, render state, bindings and uniform blocks that were current when it was recorded so the replay
+/// can reorder draws freely. Adjacent draws with identical state and contiguous index ranges are merged into one.
+/// Backend is the backend namespace (opengl/backend.zig etc). Replay only goes through its state, binding, uniform and
+/// draw calls, never the GL directly.
+pub fn CommandQueue(comptime Backend: type) type {
+    return struct {
+        const Self = @This();
+        const none = std.math.maxInt(u32);
+
+        const UniformApplyFn = fn (shader: ShaderProgram, stage: ShaderStage, bytes: []const u8) void;
+
+        const UniformRecord = struct {
+            shader: ShaderProgram,
+            stage: ShaderStage,
+            apply: UniformApplyFn,
+            offset: u32,
+            len: u32,
+        };
+
+        /// the latest uniform record for each stage of a shader
+        const ShaderUniforms = struct {
+            shader: ShaderProgram,
+            records: [2]u32 = [_]u32{ none, none },
+        };
+
+        const Draw = struct {
+            shader: ShaderProgram,
+            state: u32,
+            bindings: u32,
+            uniforms: [2]u32,
+            cmd: DrawCommand,
+        };
+
+        const SortItem = struct {
+            key: u64,
+            index: u32,
+        };
+
+        pub const Stats = struct {
+            draws_recorded: u32 = 0,
+            draws_submitted: u32 = 0,
+            shader_changes: u32 = 0,
+            binding_changes: u32 = 0,
+        };
+
+        order: DrawOrder = .sorted,
+        in_pass: bool = false,
+        pass_index: u4 = 0,
+        stats: Stats = .{},
+
+        // state as seen by the caller
+        shader: ShaderProgram = 0,
+        state: u32 = none,
+        bindings: u32 = none,
+
+        // state as last sent to the backend
+        applied_shader: ShaderProgram = 0,
+        applied_state: u32 = none,
+        applied_bindings: u32 = none,
+        applied_uniforms: std.ArrayList(ShaderUniforms),
+
+        render_states: std.ArrayList(RenderState),
+        bindings_list: std.ArrayList(BufferBindings),
+        uniform_records: std.ArrayList(UniformRecord),
+        uniform_data: std.ArrayList(u8),
+        shader_uniforms: std.ArrayList(ShaderUniforms),
+        draws: std.ArrayList(Draw),
+        sort_items: std.ArrayList(SortItem),
+        sort_scratch: std.ArrayList(SortItem),
+
+        pub fn init(allocator: *std.mem.Allocator) Self {
+            return .{
+                .applied_uniforms = std.ArrayList(ShaderUniforms).init(allocator),
+                .render_states = std.ArrayList(RenderState).init(allocator),
+                .bindings_list = std.ArrayList(BufferBindings).init(allocator),
+                .uniform_records = std.ArrayList(UniformRecord).init(allocator),
+                .uniform_data = std.ArrayList(u8).init(allocator),
+                .shader_uniforms = std.ArrayList(ShaderUniforms).init(allocator),
+                .draws = std.ArrayList(Draw).init(allocator),
+                .sort_items = std.ArrayList(SortItem).init(allocator),
+                .sort_scratch = std.ArrayList(SortItem).init(allocator),
+            };
+        }
+
+        pub fn deinit(self: Self) void {
+            self.applied_uniforms.deinit();
+            self.render_states.deinit();
+            self.bindings_list.deinit();
+            self.uniform_records.deinit();
+            self.uniform_data.deinit();
+            self.shader_uniforms.deinit();
+            self.draws.deinit();
+            self.sort_items.deinit();
+            self.sort_scratch.deinit();
+        }
+
+        /// switching between sorted and stable order replays anything recorded in the old order first
+        pub fn setOrder(self: *Self, order: DrawOrder) void {
+            std.debug.assert(order != .immediate);
+            if (order != self.order) self.flush();
+            self.order = order;
+        }
+
+        /// forgets what was sent to the backend so that everything is resent before the next draw
+        pub fn resetApplied(self: *Self) void {
+            self.applied_shader = 0;
+            self.applied_state = none;
+            self.applied_bindings = none;
+            self.applied_uniforms.items.len = 0;
+        }
+
+        /// drops the bindings so a destroyed buffer or image isn't rebound at the next flush. Call after `flush`.
+        pub fn forgetBindings(self: *Self) void {
+            std.debug.assert(self.draws.items.len == 0);
+            self.bindings = none;
+            self.applied_bindings = none;
+            self.bindings_list.items.len = 0;
+        }
+
+        /// drops the uniforms recorded for a shader that is being destroyed. Call after `flush`.
+        pub fn forgetShader(self: *Self, shader: ShaderProgram) void {
+            std.debug.assert(self.draws.items.len == 0);
+            for ([_]*std.ArrayList(ShaderUniforms){ &self.shader_uniforms, &self.applied_uniforms }) |list| {
+                for (list.items) |su, i| {
+                    if (su.shader == shader) {
+                        _ = list.swapRemove(i);
+                        break;
+                    }
+                }
+            }
+            if (self.shader == shader) self.shader = 0;
+            if (self.applied_shader == shader) self.applied_shader = 0;
+        }
+
+        pub fn beginPass(self: *Self) void {
+            std.debug.assert(!self.in_pass);
+            self.in_pass = true;
+        }
+
+        pub fn endPass(self: *Self) void {
+            std.debug.assert(self.in_pass);
+            self.flush();
+            self.in_pass = false;
+            self.pass_index +%= 1;
+        }
+
+        pub fn useShaderProgram(self: *Self, shader: ShaderProgram) void {
+            self.shader = shader;
+            if (!self.in_pass) self.applyShader(shader);
+        }
+
+        pub fn setRenderState(self: *Self, state: RenderState) void {
+            self.state = self.internRenderState(state);
+            if (!self.in_pass) self.applyState(self.state);
+        }
+
+        pub fn applyBindings(self: *Self, bindings: BufferBindings) void {
+            const last = self.bindings_list.items.len;
+            if (last == 0 or !self.bindings_list.items[last - 1].eq(bindings)) {
+                self.bindings_list.append(bindings) catch unreachable;
+            }
+            self.bindings = @intCast(u32, self.bindings_list.items.len - 1);
+            if (!self.in_pass) self.applyBindingsIndex(self.bindings);
+        }
+
+        pub fn setShaderProgramUniformBlock(self: *Self, comptime UniformT: type, shader: ShaderProgram, stage: ShaderStage, value: *UniformT) void {
+            const offset = @intCast(u32, self.uniform_data.items.len);
+            self.uniform_data.appendSlice(std.mem.asBytes(value)) catch unreachable;
+            self.uniform_records.append(.{
+                .shader = shader,
+                .stage = stage,
+                .apply = uniformApplyFn(UniformT),
+                .offset = offset,
+                .len = @sizeOf(UniformT),
+            }) catch unreachable;
+
+            const record = @intCast(u32, self.uniform_records.items.len - 1);
+            findOrAddShaderUniforms(&self.shader_uniforms, shader).records[@enumToInt(stage)] = record;
+            if (!self.in_pass) self.applyUniform(record);
+        }
+
+        pub fn draw(self: *Self, cmd: DrawCommand) void {
+            if (!self.in_pass) {
+                Backend.draw(cmd);
+                return;
+            }
+
+            const uniforms = if (findShaderUniforms(self.shader_uniforms.items, self.shader)) |su| su.records else [_]u32{ none, none };
+            self.draws.append(.{
+                .shader = self.shader,
+                .state = self.state,
+                .bindings = self.bindings,
+                .uniforms = uniforms,
+                .cmd = cmd,
+            }) catch unreachable;
+            self.stats.draws_recorded += 1;
+        }
+
+        /// sorts and replays all recorded draws, then leaves the backend with the latest state the caller set. Called at
+        /// endPass and before any call that can't be reordered (viewport, named uniforms, buffer updates, destroys).
+        pub fn flush(self: *Self) void {
+            if (self.draws.items.len > 0) {
+                self.sort_items.resize(self.draws.items.len) catch unreachable;
+                for (self.draws.items) |d, i| {
+                    self.sort_items.items[i] = .{ .key = self.sortKey(d), .index = @intCast(u32, i) };
+                }
+
+                if (self.order == .sorted) {
+                    self.sort_scratch.resize(self.draws.items.len) catch unreachable;
+                    radixSort(self.sort_items.items, self.sort_scratch.items);
+                }
+
+                // runs of draws that can't be merged but share their state go out as one multi draw
+                Backend.beginDrawBatch();
+                defer Backend.endDrawBatch();
+
+                var pending = self.draws.items[self.sort_items.items[0].index];
+                for (self.sort_items.items[1..]) |item| {
+                    const d = self.draws.items[item.index];
+                    if (self.canMerge(pending, d)) {
+                        pending.cmd.element_count += d.cmd.element_count;
+                    } else {
+                        self.submit(pending);
+                        pending = d;
+                    }
+                }
+                self.submit(pending);
+                self.draws.items.len = 0;
+            }
+
+            // leave the backend in the state the caller expects
+            for (self.shader_uniforms.items) |su| {
+                for (su.records) |record| {
+                    if (record != none) self.applyUniform(record);
+                }
+            }
+            if (self.shader != 0) self.applyShader(self.shader);
+            if (self.state != none) self.applyState(self.state);
+            if (self.bindings != none) self.applyBindingsIndex(self.bindings);
+
+            self.compact();
+        }
+
+        /// drops everything but the current state so the lists don't grow without bound
+        fn compact(self: *Self) void {
+            if (self.state != none) {
+                self.render_states.items[0] = self.render_states.items[self.state];
+                self.render_states.items.len = 1;
+                self.state = 0;
+                self.applied_state = 0;
+            }
+
+            if (self.bindings != none) {
+                self.bindings_list.items[0] = self.bindings_list.items[self.bindings];
+                self.bindings_list.items.len = 1;
+                self.bindings = 0;
+                self.applied_bindings = 0;
+            }
+
+            // keep only the latest record per shader stage. Walking in record order means each kept record only ever
+            // moves down so it can be done in place.
+            var data_len: u32 = 0;
+            var record_count: u32 = 0;
+            for (self.uniform_records.items) |rec, i| {
+                // records of destroyed shaders have no entry and are dropped
+                const su = findShaderUniforms(self.shader_uniforms.items, rec.shader) orelse continue;
+                var latest = &su.records[@enumToInt(rec.stage)];
+                if (latest.* != i) continue;
+
+                std.mem.copy(u8, self.uniform_data.items[data_len .. data_len + rec.len], self.uniform_data.items[rec.offset .. rec.offset + rec.len]);
+                self.uniform_records.items[record_count] = rec;
+                self.uniform_records.items[record_count].offset = data_len;
+                latest.* = record_count;
+
+                data_len += rec.len;
+                record_count += 1;
+            }
+            self.uniform_data.items.len = data_len;
+            self.uniform_records.items.len = record_count;
+
+            // everything in the backend is now up to date with the latest records
+            self.applied_uniforms.resize(self.shader_uniforms.items.len) catch unreachable;
+            std.mem.copy(ShaderUniforms, self.applied_uniforms.items, self.shader_uniforms.items);
+        }
+
+        fn canMerge(self: Self, a: Draw, b: Draw) bool {
+            return a.shader == b.shader and
+                a.state == b.state and
+                a.uniforms[0] == b.uniforms[0] and
+                a.uniforms[1] == b.uniforms[1] and
+                mergeable(a.cmd, b.cmd) and
+                self.sameBindings(a.bindings, b.bindings);
+        }
+
+        /// contiguous lists with the same base vertex and instance can be drawn as one. Strips can't be joined.
+        fn mergeable(a: DrawCommand, b: DrawCommand) bool {
+            return a.primitive_type == b.primitive_type and
+                a.primitive_type != .line_strip and a.primitive_type != .triangle_strip and
+                a.instance_count <= 1 and b.instance_count <= 1 and
+                a.base_vertex == b.base_vertex and a.base_instance == b.base_instance and
+                a.base_element + a.element_count == b.base_element;
+        }
+
+        fn sameBindings(self: Self, a: u32, b: u32) bool {
+            if (a == b) return true;
+            if (a == none or b == none) return false;
+            return self.bindings_list.items[a].eq(self.bindings_list.items[b]);
+        }
+
+        fn submit(self: *Self, d: Draw) void {
+            if (d.shader != 0) self.applyShader(d.shader);
+            for (d.uniforms) |record| {
+                if (record != none) self.applyUniform(record);
+            }
+            if (d.state != none) self.applyState(d.state);
+            if (d.bindings != none) self.applyBindingsIndex(d.bindings);
+
+            Backend.draw(d.cmd);
+            self.stats.draws_submitted += 1;
+        }
+
+        fn applyShader(self: *Self, shader: ShaderProgram) void {
+            if (self.applied_shader == shader) return;
+            Backend.useShaderProgram(shader);
+            self.applied_shader = shader;
+            self.stats.shader_changes += 1;
+        }
+
+        fn applyState(self: *Self, state: u32) void {
+            // states are interned so equal indices mean equal states
+            if (self.applied_state == state) return;
+            Backend.setRenderState(self.render_states.items[state]);
+            self.applied_state = state;
+        }
+
+        fn applyBindingsIndex(self: *Self, bindings: u32) void {
+            if (self.sameBindings(self.applied_bindings, bindings)) return;
+            Backend.applyBindings(self.bindings_list.items[bindings]);
+            self.applied_bindings = bindings;
+            self.stats.binding_changes += 1;
+        }
+
+        fn applyUniform(self: *Self, record: u32) void {
+            const rec = self.uniform_records.items[record];
+            var applied = findOrAddShaderUniforms(&self.applied_uniforms, rec.shader);
+            if (applied.records[@enumToInt(rec.stage)] == record) return;
+
+            // uniforms are set on the bound program
+            self.applyShader(rec.shader);
+            rec.apply(rec.shader, rec.stage, self.uniform_data.items[rec.offset .. rec.offset + rec.len]);
+            applied.records[@enumToInt(rec.stage)] = record;
+        }
+
+        fn internRenderState(self: *Self, state: RenderState) u32 {
+            for (self.render_states.items) |existing, i| {
+                if (std.meta.eql(existing, state)) return @intCast(u32, i);
+            }
+            self.render_states.append(state) catch unreachable;
+            return @intCast(u32, self.render_states.items.len - 1);
+        }
+
+        /// pass (4 bits) | shader (16) | render state (8) | first image (16) | first vertex buffer (20). Handles are
+        /// truncated to their low index bits which is enough to group identical state together.
+        fn sortKey(self: Self, d: Draw) u64 {
+            var key: u64 = @as(u64, self.pass_index) << 60;
+            key |= @as(u64, @truncate(u16, d.shader)) << 44;
+            key |= @as(u64, @truncate(u8, d.state)) << 36;
+            if (d.bindings != none) {
+                const bindings = self.bindings_list.items[d.bindings];
+                key |= @as(u64, @truncate(u16, bindings.images[0])) << 20;
+                key |= @as(u64, @truncate(u20, bindings.vert_buffers[0]));
+            }
+            return key;
+        }
+
+        fn uniformApplyFn(comptime UniformT: type) UniformApplyFn {
+            return struct {
+                fn apply(shader: ShaderProgram, stage: ShaderStage, bytes: []const u8) void {
+                    // the recorded bytes are not aligned for UniformT so copy them out
+                    var value: UniformT = undefined;
+                    std.mem.copy(u8, std.mem.asBytes(&value), bytes);
+                    Backend.setShaderProgramUniformBlock(UniformT, shader, stage, &value);
+                }
+            }.apply;
+        }
+
+        fn findShaderUniforms(list: []ShaderUniforms, shader: ShaderProgram) ?*ShaderUniforms {
+            for (list) |*su| {
+                if (su.shader == shader) return su;
+            }
+            return null;
+        }
+
+        fn findOrAddShaderUniforms(list: *std.ArrayList(ShaderUniforms), shader: ShaderProgram) *ShaderUniforms {
+            if (findShaderUniforms(list.items, shader)) |su| return su;
+            list.append(.{ .shader = shader }) catch unreachable;
+            return &list.items[list.items.len - 1];
+        }
+    };
+}
+
+/// stable LSD radix sort on the 64 bit key, one byte per pass. Bytes that are the same for every key are skipped, which
+/// is the common case for the pass and render state bits.
+fn radixSort(items: anytype, scratch: @TypeOf(items)) void {
+    std.debug.assert(items.len == scratch.len);
+    if (items.len < 2) return;
+
+    var histograms = std.mem.zeroes([8][256]u32);
+    for (items) |item| {
+        comptime var digit = 0;
+        inline while (digit < 8) : (digit += 1) {
+            histograms[digit][@truncate(u8, item.key >> (digit * 8))] += 1;
+        }
+    }
+
+    var src = items;
+    var dst = scratch;
+    for (histograms) |*histogram, digit| {
+        const shift = @intCast(u6, digit * 8);
+        if (histogram[@truncate(u8, items[0].key >> shift)] == items.len) continue;
+
+        var offset: u32 = 0;
+        for (histogram) |*count| {
+            const c = count.*;
+            count.* = offset;
+            offset += c;
+        }
+
+        for (src) |item| {
+            const bucket = &histogram[@truncate(u8, item.key >> shift)];
+            dst[bucket.*] = item;
+            bucket.* += 1;
+        }
+
+        const tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src.ptr != items.ptr) std.mem.copy(@TypeOf(items[0]), items, src);
+}
+
+test "radix sort" {
+    const Item = struct { key: u64, index: u32 };
+
+    var items: [1000]Item = undefined;
+    var scratch: [1000]Item = undefined;
+    var prng = std.rand.DefaultPrng.init(42);
+    for (items) |*item, i| item.* = .{ .key = prng.random.int(u64) & 0xFFFF00000000FFFF, .index = @intCast(u32, i) };
+    items[10].key = items[20].key;
+
+    radixSort(items[0..], scratch[0..]);
+    for (items[1..]) |item, i| {
+        std.testing.expect(items[i].key <= item.key);
+        // stability
+        if (items[i].key == item.key) std.testing.expect(items[i].index < item.index);
+    }
+}
+
+const FakeBackend = struct {
+    var draws: u32 = 0;
+    var elements: c_int = 0;
+    var shader_binds: u32 = 0;
+    var last_shader: ShaderProgram = 0;
+    var last_uniform: f32 = 0;
+
+    fn reset() void {
+        draws = 0;
+        elements = 0;
+        shader_binds = 0;
+    }
+
+    pub fn useShaderProgram(shader: ShaderProgram) void {
+        shader_binds += 1;
+        last_shader = shader;
+    }
+
+    pub fn setRenderState(state: RenderState) void {}
+    pub fn applyBindings(bindings: BufferBindings) void {}
+    pub fn beginDrawBatch() void {}
+    pub fn endDrawBatch() void {}
+
+    pub fn setShaderProgramUniformBlock(comptime UniformT: type, shader: ShaderProgram, stage: ShaderStage, value: *UniformT) void {
+        std.testing.expectEqual(shader, last_shader);
+        last_uniform = value.tint;
+    }
+
+    pub fn draw(cmd: DrawCommand) void {
+        draws += 1;
+        elements += cmd.element_count;
+    }
+};
+
+test "sorted queue groups shaders and merges contiguous draws" {
+    FakeBackend.reset();
+    var queue = CommandQueue(FakeBackend).init(std.testing.allocator);
+    defer queue.deinit();
+
+    var vert_buffers = [_]Buffer{2};
+    queue.applyBindings(BufferBindings.init(1, &vert_buffers));
+
+    queue.beginPass();
+    var i: c_int = 0;
+    while (i < 10) : (i += 1) {
+        // alternate shaders, each shader's draws are contiguous in the index buffer
+        queue.useShaderProgram(if (@mod(i, 2) == 0) 1 else 2);
+        queue.draw(.{ .base_element = @divTrunc(i, 2) * 6, .element_count = 6 });
+    }
+    queue.endPass();
+
+    std.testing.expectEqual(@as(u32, 2), FakeBackend.draws);
+    std.testing.expectEqual(@as(c_int, 60), FakeBackend.elements);
+    std.testing.expectEqual(@as(u32, 10), queue.stats.draws_recorded);
+}
+
+test "stable queue keeps order and replays uniforms per draw" {
+    const Uniforms = struct { tint: f32 };
+
+    FakeBackend.reset();
+    var queue = CommandQueue(FakeBackend).init(std.testing.allocator);
+    defer queue.deinit();
+    queue.setOrder(.stable);
+
+    queue.beginPass();
+    queue.useShaderProgram(1);
+    var u = Uniforms{ .tint = 1 };
+    queue.setShaderProgramUniformBlock(Uniforms, 1, .fs, &u);
+    queue.draw(.{ .element_count = 6 });
+    queue.useShaderProgram(2);
+    queue.draw(.{ .element_count = 6 });
+    queue.useShaderProgram(1);
+    u.tint = 2;
+    queue.setShaderProgramUniformBlock(Uniforms, 1, .fs, &u);
+    queue.draw(.{ .base_element = 6, .element_count = 6 });
+    queue.endPass();
+
+    // the uniform change prevents merging the two shader 1 draws and order is kept, so shader 1 is bound twice
+    std.testing.expectEqual(@as(u32, 3), FakeBackend.draws);
+    std.testing.expectEqual(@as(u32, 3), FakeBackend.shader_binds);
+    std.testing.expectEqual(@as(f32, 2), FakeBackend.last_uniform);
+}
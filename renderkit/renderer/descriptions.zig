@@ -6,30 +6,95 @@ pub const MetalSetup = extern struct {
 };
 
 pub const RendererDesc = extern struct {
+    /// initial capacity of each resource pool. Pools grow as needed so these only avoid reallocations.
     const PoolSizes = extern struct {
-        texture: u8 = 64,
-        offscreen_pass: u8 = 8,
-        buffers: u8 = 16,
-        shaders: u8 = 16,
+        texture: u32 = 64,
+        offscreen_pass: u32 = 8,
+        buffers: u32 = 16,
+        shaders: u32 = 16,
     };
 
     allocator: *std.mem.Allocator,
     gl_loader: ?fn ([*c]const u8) callconv(.C) ?*c_void = null,
     pool_sizes: PoolSizes = .{},
     metal: MetalSetup = .{},
+    /// directory for linked program binaries, created if missing. Programs load from there instead of being compiled
+    /// when the shader sources and driver haven't changed. OpenGL only, null turns the cache off.
+    shader_cache_dir: ?[*:0]const u8 = null,
 };
 
 pub const ImageDesc = extern struct {
     render_target: bool = false,
     width: i32,
     height: i32,
+    /// number of mip levels to allocate, `mipCount` gives a full chain. `content` fills level 0, the others are filled
+    /// with `updateImageLevel` or `generateMipmaps`.
+    num_mipmaps: i32 = 1,
     usage: renderkit.Usage = .immutable,
     pixel_format: renderkit.PixelFormat = .rgba8,
     min_filter: renderkit.TextureFilter = .nearest,
     mag_filter: renderkit.TextureFilter = .nearest,
+    mip_filter: renderkit.MipFilter = .none,
     wrap_u: renderkit.TextureWrap = .clamp,
     wrap_v: renderkit.TextureWrap = .clamp,
+    /// anisotropic filtering samples when minifying, clamped to what the device supports. 1 turns it off.
+    max_anisotropy: i32 = 1,
     content: ?*const c_void = null,
+
+    pub fn sampler(self: ImageDesc) renderkit.SamplerDesc {
+        return .{
+            .min_filter = self.min_filter,
+            .mag_filter = self.mag_filter,
+            .mip_filter = self.mip_filter,
+            .wrap_u = self.wrap_u,
+            .wrap_v = self.wrap_v,
+            .max_anisotropy = self.max_anisotropy,
+        };
+    }
+};
+
+/// sampler state of an image created with `createImageFromFile`. Size, format and mip levels come from the file.
+pub const ImageFileDesc = struct {
+    min_filter: renderkit.TextureFilter = .linear,
+    mag_filter: renderkit.TextureFilter = .linear,
+    mip_filter: renderkit.MipFilter = .linear,
+    wrap_u: renderkit.TextureWrap = .clamp,
+    wrap_v: renderkit.TextureWrap = .clamp,
+    max_anisotropy: i32 = 1,
+};
+
+/// pixel layouts `ImageSource.pixels` can be converted from. Images are always rgba8.
+pub const SourceFormat = enum {
+    rgba8,
+    bgra8,
+    rgb8,
+    luminance8, // opaque gray
+    alpha8, // white with alpha, for font atlases
+
+    pub fn bytesPerPixel(self: SourceFormat) u32 {
+        return switch (self) {
+            .rgba8, .bgra8 => 4,
+            .rgb8 => 3,
+            .luminance8, .alpha8 => 1,
+        };
+    }
+};
+
+/// where the pixels of an image created with `createImageAsync` come from. Both kinds are processed on a worker thread.
+/// Memory referenced by the source must stay valid until the image is ready or destroyed.
+pub const ImageSource = union(enum) {
+    /// pixels in another layout, converted to rgba8
+    pixels: struct {
+        data: []const u8,
+        format: SourceFormat = .rgba8,
+        row_pitch: u32 = 0, // bytes between rows, 0 if tightly packed
+    },
+    /// a custom decoder (png, procedural...) that fills `out` with `width * height` rgba8 pixels. Returning false
+    /// leaves the image transparent.
+    decoder: struct {
+        context: usize = 0,
+        decodeFn: fn (context: usize, out: []u32) bool,
+    },
 };
 
 pub const PassDesc = struct {
@@ -50,6 +115,10 @@ pub fn BufferDesc(comptime T: type) type {
         usage: renderkit.Usage = .immutable,
         content: ?[]const T = null,
         step_func: VertexStep = .per_vertex, // step function used for instanced drawing
+        /// appendBuffer growth policy for stream/dynamic buffers. When a frame appends more than `size` bytes the excess
+        /// of that frame spills into an overflow block and the buffer is reallocated at the next frame boundary, doubling
+        /// until it holds the high-water mark. Without it the excess is dropped.
+        grow: bool = false,
 
         pub fn getSize(self: @This()) c_long {
             std.debug.assert(self.usage != .immutable or self.content != null);
@@ -66,3 +135,76 @@ pub const ShaderDesc = struct {
     fs: [:0]const u8,
     images: []const [:0]const u8 = &[_][:0]const u8{},
 };
+
+pub const VertexFormat = extern enum {
+    float,
+    float2,
+    float3,
+    float4,
+    u_byte_4n,
+};
+
+pub const VertexAttribute = extern struct {
+    format: VertexFormat = .float,
+    offset: u32 = 0,
+    buffer: u32 = 0, // vertex buffer slot the attribute is read from
+};
+
+pub const VertexBufferLayout = extern struct {
+    stride: u32 = 0,
+    step_func: VertexStep = .per_vertex,
+};
+
+/// the vertex attributes a pipeline reads, derived from the vertex structs of each buffer slot. u32 fields are colors,
+/// f32 and structs of 2-4 f32 are floats, the same rules `createBuffer` uses.
+pub const VertexLayout = extern struct {
+    attributes: [8]VertexAttribute = [_]VertexAttribute{.{}} ** 8,
+    num_attributes: u32 = 0,
+    buffers: [4]VertexBufferLayout = [_]VertexBufferLayout{.{}} ** 4,
+
+    pub fn init(comptime vertex_types: []const type) VertexLayout {
+        comptime {
+            var layout = VertexLayout{};
+            for (vertex_types) |T, slot| {
+                layout.buffers[slot].stride = @sizeOf(T);
+                for (@typeInfo(T).Struct.fields) |field| {
+                    layout.attributes[layout.num_attributes] = .{
+                        .format = vertexFormat(field.field_type),
+                        .offset = @byteOffsetOf(T, field.name),
+                        .buffer = slot,
+                    };
+                    layout.num_attributes += 1;
+                }
+            }
+            return layout;
+        }
+    }
+
+    /// marks the buffer in `slot` as stepping once per instance
+    pub fn instanced(self: VertexLayout, slot: usize) VertexLayout {
+        var layout = self;
+        layout.buffers[slot].step_func = .per_instance;
+        return layout;
+    }
+
+    fn vertexFormat(comptime T: type) VertexFormat {
+        return switch (@typeInfo(T)) {
+            .Int => |info| if (!info.is_signed and info.bits == 32) .u_byte_4n else @compileError("only u32 colors are supported: " ++ @typeName(T)),
+            .Float => .float,
+            .Struct => |info| switch (info.fields.len) {
+                2 => .float2,
+                3 => .float3,
+                4 => .float4,
+                else => @compileError("Structs of f32 must be 2/3/4 elements: " ++ @typeName(T)),
+            },
+            else => @compileError("unsupported vertex field type: " ++ @typeName(T)),
+        };
+    }
+};
+
+/// everything that has to be known up front to build a backend pipeline state object. See `createPipeline`.
+pub const PipelineDesc = struct {
+    shader: renderkit.ShaderProgram,
+    layout: VertexLayout = .{},
+    render_state: renderkit.RenderState = .{},
+};
@@ -3,9 +3,23 @@ usingnamespace @import("../types.zig");
 usingnamespace @import("../descriptions.zig");
 
 // the dummy backend defines the interface that all other backends need to implement for renderer compliance
-pub fn setup(desc: RendererDesc) void {}
-pub fn shutdown() void {}
+var allocator: *std.mem.Allocator = undefined;
+// backs reserveAppend so callers have somewhere to write. Every reservation gets its own memory since several buffers
+// can have one open, all of it is freed at the end of the frame.
+var reservations: std.ArrayList([]align(16) u8) = undefined;
+
+pub fn setup(desc: RendererDesc) void {
+    allocator = desc.allocator;
+    reservations = std.ArrayList([]align(16) u8).init(allocator);
+}
+pub fn shutdown() void {
+    freeReservations();
+    reservations.deinit();
+}
 pub fn setRenderState(state: RenderState) void {}
+pub fn resetStateCache() void {}
+pub fn getVertexArrayCacheStats() VertexArrayCacheStats { return .{}; }
+pub fn getShaderCacheStats() ShaderCacheStats { return .{}; }
 pub fn viewport(x: c_int, y: c_int, width: c_int, height: c_int) void {}
 pub fn scissor(x: c_int, y: c_int, width: c_int, height: c_int) void {}
 
@@ -13,6 +27,12 @@ pub fn scissor(x: c_int, y: c_int, width: c_int, height: c_int) void {}
 pub fn createImage(desc: ImageDesc) Image { return 0; }
 pub fn destroyImage(image: Image) void {}
 pub fn updateImage(comptime T: type, image: Image, content: []const T) void {}
+pub fn updateImageRegion(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) void {}
+pub fn updateImageRegionAsync(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) UploadToken { return .{}; }
+pub fn isUploadComplete(token: UploadToken) bool { return true; }
+pub fn updateImageLevel(comptime T: type, image: Image, level: i32, row_pitch: u32, content: []const T) void {}
+pub fn generateMipmaps(image: Image) void {}
+pub fn isPixelFormatSupported(format: PixelFormat) bool { return true; }
 pub fn getImageNativeId(image: Image) u32 { return 0; }
 
 // passes
@@ -21,23 +41,43 @@ pub fn destroyPass(pass: Pass) void {}
 pub fn beginDefaultPass(action: ClearCommand, width: c_int, height: c_int) void {}
 pub fn beginPass(pass: Pass, action: ClearCommand) void {}
 pub fn endPass() void {}
-pub fn commitFrame() void {}
+pub fn commitFrame() void { freeReservations(); }
+
+fn freeReservations() void {
+    for (reservations.items) |memory| allocator.free(memory);
+    reservations.items.len = 0;
+}
 
 // buffers
 pub fn createBuffer(comptime T: type, desc: BufferDesc(T)) Buffer { return 0; }
 pub fn destroyBuffer(buffer: Buffer) void {}
 pub fn updateBuffer(comptime T: type, buffer: Buffer, verts: []const T) void {}
-pub fn appendBuffer(comptime T: type, buffer: Buffer, verts: []const T) int {}
+pub fn appendBuffer(comptime T: type, buffer: Buffer, verts: []const T) u32 { return 0; }
+pub fn reserveAppend(comptime T: type, buffer: Buffer, count: usize) []T {
+    const memory = allocator.alignedAlloc(u8, 16, count * @sizeOf(T)) catch unreachable;
+    reservations.append(memory) catch unreachable;
+    return @ptrCast([*]T, @alignCast(@alignOf(T), memory.ptr))[0..count];
+}
+pub fn commitAppend(comptime T: type, buffer: Buffer, count: usize) u32 { return 0; }
+pub fn getBufferStats(buffer: Buffer) BufferStats { return .{}; }
 
-// buffer bindings
-pub fn createBufferBindings(index_buffer: Buffer, vert_buffers: []Buffer) BufferBindings { return 0; }
-pub fn destroyBufferBindings(bindings: BufferBindings) void {}
-pub fn bindImageToBufferBindings(buffer_bindings: BufferBindings, image: Image, slot: c_uint) void {}
-pub fn drawBufferBindings(bindings: BufferBindings, base_element: c_int, element_count: c_int, instance_count: c_int) void {}
+// bindings and drawing
+pub fn applyBindings(bindings: BufferBindings) void {}
+pub fn draw(cmd: DrawCommand) void {}
+pub fn beginDrawBatch() void {}
+pub fn endDrawBatch() void {}
 
 // shaders
-pub fn createShaderProgram(desc: ShaderDesc) ShaderProgram { return 0; }
+pub fn createShaderProgram(comptime FragUniformT: type, desc: ShaderDesc) ShaderProgram { return 0; }
+pub fn createShaderPrograms(comptime FragUniformT: type, descs: []const ShaderDesc, programs: []ShaderProgram) void {}
+pub fn isShaderProgramReady(shader: ShaderProgram) bool { return true; }
 pub fn destroyShaderProgram(shader: ShaderProgram) void {}
 pub fn useShaderProgram(shader: ShaderProgram) void {}
-pub fn setShaderProgramUniformBlock(comptime FragUniformT: type, shader: ShaderProgram, stage: ShaderStage, value: FragUniformT) void {}
-pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, name: [:0]const u8, value: T) void {}
+pub fn setShaderProgramUniformBlock(comptime UniformT: type, shader: ShaderProgram, stage: ShaderStage, value: *UniformT) void {}
+pub fn setFrameUniformBlock(comptime UniformT: type, value: *UniformT) void {}
+pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, comptime name: [:0]const u8, value: T) void {}
+
+// pipelines
+pub fn createPipeline(desc: PipelineDesc) u32 { return 0; }
+pub fn destroyPipeline(pipeline: u32) void {}
+pub fn usePipeline(pipeline: u32) void {}
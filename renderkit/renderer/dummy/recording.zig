@@ -0,0 +1,65 @@
+const std = @import("std");
+usingnamespace @import("../types.zig");
+usingnamespace @import("../descriptions.zig");
+
+// a test backend for the modules that take a Backend or Renderer type parameter. Like the dummy backend it draws
+// nothing, but it hands out distinct handles and records what reaches it so tests can check uploads, appends and
+// draws. The counters are global, call `reset` at the start of a test.
+pub var next_handle: u32 = 1;
+
+pub var last_image_desc: ImageDesc = .{ .width = 0, .height = 0 };
+pub var uploads: u32 = 0;
+pub var uploaded_bytes: usize = 0;
+pub var max_upload: usize = 0;
+
+pub var appended: usize = 0;
+pub var last_bindings: BufferBindings = std.mem.zeroes(BufferBindings);
+pub var draws: u32 = 0;
+pub var last_cmd: DrawCommand = .{ .element_count = 0 };
+
+pub fn reset() void {
+    next_handle = 1;
+    last_image_desc = .{ .width = 0, .height = 0 };
+    uploads = 0;
+    uploaded_bytes = 0;
+    max_upload = 0;
+    appended = 0;
+    last_bindings = std.mem.zeroes(BufferBindings);
+    draws = 0;
+    last_cmd = .{ .element_count = 0 };
+}
+
+fn nextHandle() u32 {
+    next_handle += 1;
+    return next_handle - 1;
+}
+
+// images
+pub fn createImage(desc: ImageDesc) Image {
+    last_image_desc = desc;
+    return nextHandle();
+}
+pub fn destroyImage(image: Image) void {}
+pub fn updateImageRegion(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) void {
+    const bytes = content.len * @sizeOf(T);
+    uploads += 1;
+    uploaded_bytes += bytes;
+    max_upload = std.math.max(max_upload, bytes);
+}
+
+// buffers, appends are laid out back to back from offset 0
+pub fn createBuffer(comptime T: type, desc: BufferDesc(T)) Buffer { return nextHandle(); }
+pub fn destroyBuffer(buffer: Buffer) void {}
+pub fn appendBuffer(comptime T: type, buffer: Buffer, verts: []const T) u32 {
+    const offset = @intCast(u32, appended);
+    appended += verts.len * @sizeOf(T);
+    return offset;
+}
+
+// bindings and drawing, `drawElements` is the renderer level name of `draw`
+pub fn applyBindings(bindings: BufferBindings) void { last_bindings = bindings; }
+pub fn draw(cmd: DrawCommand) void {
+    draws += 1;
+    last_cmd = cmd;
+}
+pub fn drawElements(cmd: DrawCommand) void { draw(cmd); }
@@ -21,6 +21,7 @@ pub fn Handles(comptime HandleType: type, comptime IndexType: type, comptime Ver
 
         const invalid_id = std.math.maxInt(IndexType);
 
+        /// capacity is only the initial size of the handle storage, it will grow as needed until IndexType is exhausted
         pub fn init(allocator: *std.mem.Allocator, capacity: usize) Self {
             return Self{
                 .handles = allocator.alloc(HandleType, capacity) catch unreachable,
@@ -46,8 +47,8 @@ pub fn Handles(comptime HandleType: type, comptime IndexType: type, comptime Ver
 
         pub fn create(self: *Self) HandleType {
             if (self.last_destroyed == null) {
-                // ensure capacity
-                std.debug.assert(self.handles.len - 1 != self.append_cursor);
+                if (self.append_cursor == invalid_id) @panic("Handles exhausted the IndexType range");
+                if (self.append_cursor >= self.handles.len) self.grow();
 
                 const id = self.append_cursor;
                 const handle = forge(self.append_cursor, 0);
@@ -68,6 +69,13 @@ pub fn Handles(comptime HandleType: type, comptime IndexType: type, comptime Ver
             return handle;
         }
 
+        /// doubles the handle storage. Handles are plain values so the storage is free to move.
+        fn grow(self: *Self) void {
+            const max_len = @as(usize, invalid_id);
+            const new_len = std.math.min(max_len, std.math.max(16, self.handles.len * 2));
+            self.handles = self.allocator.realloc(self.handles, new_len) catch unreachable;
+        }
+
         pub fn destroy(self: *Self, handle: HandleType) void {
             const id = self.extractIndex(handle);
             const next_id = self.last_destroyed orelse invalid_id;
@@ -86,44 +94,89 @@ pub fn Handles(comptime HandleType: type, comptime IndexType: type, comptime Ver
     };
 }
 
-/// Fixed size object cache that uses versioned Handles to identify resources. All objects are stored in a preallocated array
-/// so they do not need to be stack allocated outside of the HandledCache.
+/// Growable object cache that uses versioned Handles to identify resources. All objects are stored in fixed size pages
+/// that are never moved or freed until deinit so pointers returned by `get` and `free` stay valid while the cache grows.
+/// Handles are u32 with a 20 bit index and 12 bit version. Use `HandledCacheWithLayout` for a different split.
 pub fn HandledCache(comptime T: type) type {
-    const HandleType = u16;
+    return HandledCacheWithLayout(T, u32, u20, u12);
+}
 
+pub fn HandledCacheWithLayout(comptime T: type, comptime HandleType: type, comptime IndexType: type, comptime VersionType: type) type {
     return struct {
-        items: []T,
-        handles: Handles(u16, u8, u8),
+        const Self = @This();
+        const page_shift = 8;
+        const page_size = 1 << page_shift;
+        const Page = [page_size]T;
 
-        pub fn init(allocator: *std.mem.Allocator, capacity: usize) @This() {
-            return .{
-                .items = allocator.alloc(T, capacity) catch unreachable,
-                .handles = Handles(u16, u8, u8).init(allocator, capacity),
+        pages: std.ArrayList(*Page),
+        handles: Handles(HandleType, IndexType, VersionType),
+
+        pub fn init(allocator: *std.mem.Allocator, capacity: usize) Self {
+            var self = Self{
+                .pages = std.ArrayList(*Page).init(allocator),
+                .handles = Handles(HandleType, IndexType, VersionType).init(allocator, capacity),
             };
+            self.ensureCapacity(capacity);
+            return self;
         }
 
-        pub fn deinit(self: @This()) void {
-            self.handles.allocator.free(self.items);
+        pub fn deinit(self: Self) void {
+            for (self.pages.items) |page| self.handles.allocator.destroy(page);
+            self.pages.deinit();
             self.handles.deinit();
         }
 
-        pub fn append(self: *@This(), item: T) HandleType {
+        fn ensureCapacity(self: *Self, capacity: usize) void {
+            while (self.pages.items.len * page_size < capacity) {
+                const page = self.handles.allocator.create(Page) catch unreachable;
+                self.pages.append(page) catch unreachable;
+            }
+        }
+
+        fn itemPtr(self: Self, index: IndexType) *T {
+            return &self.pages.items[index >> page_shift][index & (page_size - 1)];
+        }
+
+        pub fn append(self: *Self, item: T) HandleType {
             var handle = self.handles.create();
-            self.items[self.handles.extractIndex(handle)] = item;
+            const index = self.handles.extractIndex(handle);
+            self.ensureCapacity(@as(usize, index) + 1);
+            self.itemPtr(index).* = item;
             return handle;
         }
 
-        pub fn get(self: @This(), handle: HandleType) *T {
+        pub fn get(self: Self, handle: HandleType) *T {
             std.debug.assert(self.handles.alive(handle));
-            return &self.items[self.handles.extractIndex(handle)];
+            return self.itemPtr(self.handles.extractIndex(handle));
         }
 
-        pub fn free(self: *@This(), handle: HandleType) *T {
+        pub fn free(self: *Self, handle: HandleType) *T {
             std.debug.assert(self.handles.alive(handle));
-            var obj = &self.items[self.handles.extractIndex(handle)];
+            var obj = self.itemPtr(self.handles.extractIndex(handle));
             self.handles.destroy(handle);
             return obj;
         }
+
+        pub const Iterator = struct {
+            cache: *const Self,
+            index: usize = 1,
+
+            pub fn next(it: *Iterator) ?*T {
+                const handles = &it.cache.handles;
+                while (it.index < handles.append_cursor) {
+                    const index = @intCast(IndexType, it.index);
+                    it.index += 1;
+                    // a freed slot holds the index of the next free one, never its own
+                    if (handles.extractIndex(handles.handles[index]) == index) return it.cache.itemPtr(index);
+                }
+                return null;
+            }
+        };
+
+        /// walks the live items in index order
+        pub fn iterator(self: *const Self) Iterator {
+            return .{ .cache = self };
+        }
     };
 }
 
@@ -141,6 +194,14 @@ test "cache" {
 
     h1 = cache.append(6);
     std.debug.assert(cache.get(h1).* == 6);
+
+    const h2 = cache.append(7);
+    const h3 = cache.append(8);
+    _ = cache.free(h2);
+    var sum: u32 = 0;
+    var iter = cache.iterator();
+    while (iter.next()) |item| sum += item.*;
+    std.testing.expectEqual(@as(u32, 6 + 8), sum);
 }
 
 test "handles" {
@@ -179,3 +240,37 @@ test "handles" {
     e_tmp = hm.create();
     std.debug.assert(hm.alive(e_tmp));
 }
+
+test "cache grows without moving items" {
+    var cache = HandledCache(u32).init(std.testing.allocator, 2);
+    defer cache.deinit();
+
+    const first = cache.append(1);
+    const first_ptr = cache.get(first);
+
+    var handles: [1000]u32 = undefined;
+    for (handles) |*h, i| h.* = cache.append(@intCast(u32, i));
+
+    std.testing.expect(cache.get(first) == first_ptr);
+    std.testing.expectEqual(@as(u32, 1), first_ptr.*);
+    for (handles) |h, i| std.testing.expectEqual(@intCast(u32, i), cache.get(h).*);
+
+    for (handles) |h| _ = cache.free(h);
+    for (handles) |h| std.testing.expect(!cache.handles.alive(h));
+    std.testing.expect(cache.handles.alive(first));
+}
+
+test "handles layouts" {
+    var hm = Handles(u32, u24, u8).init(std.testing.allocator, 0);
+    defer hm.deinit();
+
+    const e0 = hm.create();
+    std.testing.expectEqual(@as(u24, 1), hm.extractIndex(e0));
+    hm.destroy(e0);
+
+    const e1 = hm.create();
+    std.testing.expectEqual(hm.extractIndex(e0), hm.extractIndex(e1));
+    std.testing.expectEqual(@as(u8, 1), hm.extractVersion(e1));
+    std.testing.expect(!hm.alive(e0));
+    std.testing.expect(hm.alive(e1));
+}
@@ -9,12 +9,14 @@ var image_cache: HandledCache(*MtlImage) = undefined;
 var pass_cache: HandledCache(*MtlPass) = undefined;
 var buffer_cache: HandledCache(*MtlBuffer) = undefined;
 var shader_cache: HandledCache(*MtlShader) = undefined;
+var pipeline_cache: HandledCache(*MtlPipeline) = undefined;
 
 pub fn setup(desc: RendererDesc) void {
     image_cache = HandledCache(*MtlImage).init(desc.allocator, desc.pool_sizes.texture * num_in_flight_frames);
     pass_cache = HandledCache(*MtlPass).init(desc.allocator, desc.pool_sizes.offscreen_pass * num_in_flight_frames);
     buffer_cache = HandledCache(*MtlBuffer).init(desc.allocator, desc.pool_sizes.buffers * num_in_flight_frames);
     shader_cache = HandledCache(*MtlShader).init(desc.allocator, desc.pool_sizes.shaders * num_in_flight_frames);
+    pipeline_cache = HandledCache(*MtlPipeline).init(desc.allocator, desc.pool_sizes.shaders);
 
     mtl_setup(desc);
     setRenderState(.{});
@@ -26,6 +28,7 @@ pub fn shutdown() void {
     pass_cache.deinit();
     buffer_cache.deinit();
     shader_cache.deinit();
+    pipeline_cache.deinit();
     mtl_shutdown();
 }
 
@@ -33,6 +36,16 @@ pub fn setRenderState(state: RenderState) void {
     mtl_set_render_state(state);
 }
 
+pub fn resetStateCache() void {}
+
+pub fn getVertexArrayCacheStats() VertexArrayCacheStats {
+    return .{};
+}
+
+pub fn getShaderCacheStats() ShaderCacheStats {
+    return .{};
+}
+
 pub fn viewport(x: c_int, y: c_int, width: c_int, height: c_int) void {
     mtl_viewport(x, y, width, height);
 }
@@ -57,6 +70,36 @@ pub fn updateImage(comptime T: type, image: Image, content: []const T) void {
     mtl_update_image(img.*, content.ptr);
 }
 
+pub fn updateImageRegion(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) void {
+    // a row pitch of 0 is resolved from the image's pixel format
+    var img = image_cache.get(image);
+    mtl_update_image_region(img.*, x, y, width, height, row_pitch, content.ptr);
+}
+
+/// replaceRegion copies synchronously so the upload is already complete when this returns
+pub fn updateImageRegionAsync(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) UploadToken {
+    updateImageRegion(T, image, x, y, width, height, row_pitch, content);
+    return .{};
+}
+
+pub fn isUploadComplete(token: UploadToken) bool {
+    return true;
+}
+
+pub fn updateImageLevel(comptime T: type, image: Image, level: i32, row_pitch: u32, content: []const T) void {
+    var img = image_cache.get(image);
+    mtl_update_image_level(img.*, level, row_pitch, content.ptr);
+}
+
+pub fn generateMipmaps(image: Image) void {
+    var img = image_cache.get(image);
+    mtl_generate_mipmaps(img.*);
+}
+
+pub fn isPixelFormatSupported(format: PixelFormat) bool {
+    return mtl_is_pixel_format_supported(format);
+}
+
 pub fn getImageNativeId(image: Image) u32 {
     @panic("not implemented");
     return 0;
@@ -111,12 +154,38 @@ pub fn appendBuffer(comptime T: type, buffer: Buffer, verts: []const T) u32 {
     return mtl_append_buffer(buff.*, verts.ptr, @intCast(u32, verts.len * @sizeOf(T)));
 }
 
+/// the slice points into the active slot's `[MTLBuffer contents]` unless the reservation doesn't fit
+pub fn reserveAppend(comptime T: type, buffer: Buffer, count: usize) []T {
+    var buff = buffer_cache.get(buffer);
+    const ptr = mtl_reserve_append(buff.*, @intCast(u32, count * @sizeOf(T)));
+    return @ptrCast([*]T, @alignCast(@alignOf(T), ptr))[0..count];
+}
+
+pub fn commitAppend(comptime T: type, buffer: Buffer, count: usize) u32 {
+    var buff = buffer_cache.get(buffer);
+    return mtl_commit_append(buff.*, @intCast(u32, count * @sizeOf(T)));
+}
+
+pub fn getBufferStats(buffer: Buffer) BufferStats {
+    var buff = buffer_cache.get(buffer);
+    return mtl_get_buffer_stats(buff.*);
+}
+
 // shaders
 pub fn createShaderProgram(comptime FragUniformT: type, desc: ShaderDesc) ShaderProgram {
     const shader = mtl_create_shader(MtlShaderDesc.init(FragUniformT, desc));
     return shader_cache.append(shader);
 }
 
+/// Metal compiles each library when it is created so this is the same as calling `createShaderProgram` per desc
+pub fn createShaderPrograms(comptime FragUniformT: type, descs: []const ShaderDesc, programs: []ShaderProgram) void {
+    for (descs) |desc, i| programs[i] = createShaderProgram(FragUniformT, desc);
+}
+
+pub fn isShaderProgramReady(shader: ShaderProgram) bool {
+    return true;
+}
+
 pub fn destroyShaderProgram(shader: ShaderProgram) void {
     var shd = shader_cache.free(shader);
     mtl_destroy_shader(shd.*);
@@ -133,19 +202,45 @@ pub fn setShaderProgramUniformBlock(comptime UniformT: type, shader: ShaderProgr
     mtl_set_shader_uniform_block(stage, data, @intCast(c_int, @sizeOf(UniformT)));
 }
 
-pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, name: [:0]const u8, value: T) void {
+/// the block is copied and bound with setVertexBytes/setFragmentBytes at buffer index 2 of both stages on every
+/// applyBindings, so it has to stay under Metal's 4KB limit for inline bytes
+pub fn setFrameUniformBlock(comptime UniformT: type, value: *UniformT) void {
+    comptime std.debug.assert(@sizeOf(UniformT) <= 4096);
+    mtl_set_frame_uniform_block(std.mem.asBytes(value), @intCast(c_int, @sizeOf(UniformT)));
+}
+
+pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, comptime name: [:0]const u8, value: T) void {
     var shdr = shader_cache.get(shader);
 }
 
+// pipelines
+/// builds the MTLRenderPipelineState right away so the first draw with it doesn't stall
+pub fn createPipeline(desc: PipelineDesc) u32 {
+    const pipeline = mtl_create_pipeline(shader_cache.get(desc.shader).*, desc.render_state, &desc.layout);
+    return pipeline_cache.append(pipeline);
+}
+
+pub fn destroyPipeline(pipeline: u32) void {
+    mtl_destroy_pipeline(pipeline_cache.free(pipeline).*);
+}
+
+pub fn usePipeline(pipeline: u32) void {
+    mtl_use_pipeline(pipeline_cache.get(pipeline).*);
+}
+
 // bindings and drawing
 pub fn applyBindings(bindings: BufferBindings) void {
     mtl_apply_bindings(MtlBufferBindings.init(bindings));
 }
 
-pub fn draw(base_element: c_int, element_count: c_int, instance_count: c_int) void {
-    mtl_draw(base_element, element_count, instance_count);
+pub fn draw(cmd: DrawCommand) void {
+    mtl_draw(cmd);
 }
 
+/// encoding a draw is already cheap on Metal so batches are simply drawn as they come
+pub fn beginDrawBatch() void {}
+pub fn endDrawBatch() void {}
+
 // C api
 // we need these due to the normal descriptors either being generic or not able to be extern
 const MtlVertexFormat = extern enum {
@@ -180,6 +275,7 @@ const MtlBufferDesc = extern struct {
     index_type: MtlIndexType = .uint16,
     vertex_layout: [4]MtlVertexLayout,
     vertex_attrs: [8]MtlVertexAttribute,
+    grow: bool = false,
 
     var type_id_counter: u8 = 1;
 
@@ -269,6 +365,7 @@ const MtlBufferDesc = extern struct {
             .index_type = if (T == u16) .uint16 else .uint32,
             .vertex_layout = vertex_layout,
             .vertex_attrs = vertex_attrs,
+            .grow = buffer_desc.grow,
         };
     }
 };
@@ -310,6 +407,8 @@ const MtlBufferBindings = extern struct {
     vert_buffers: [4]?*MtlBuffer = [_]?*MtlBuffer{null} ** 4,
     vertex_buffer_offsets: [4]u32 = [_]u32{0} ** 4,
     images: [8]?*MtlImage = [_]?*MtlImage{null} ** 8,
+    sampler_overrides: u32 = 0,
+    samplers: [8]SamplerDesc = [_]SamplerDesc{.{}} ** 8,
 
     pub fn init(bindings: BufferBindings) MtlBufferBindings {
         var mtl_bindings = MtlBufferBindings{
@@ -326,6 +425,10 @@ const MtlBufferBindings = extern struct {
         for (bindings.images) |img, i| {
             if (img == 0) break;
             mtl_bindings.images[i] = image_cache.get(img).*;
+            if (bindings.samplers[i]) |sampler| {
+                mtl_bindings.sampler_overrides |= @as(u32, 1) << @intCast(u5, i);
+                mtl_bindings.samplers[i] = sampler;
+            }
         }
 
         return mtl_bindings;
@@ -337,6 +440,7 @@ const MtlImage = opaque {};
 const MtlBuffer = opaque {};
 const MtlPass = opaque {};
 const MtlShader = opaque {};
+const MtlPipeline = opaque {};
 
 extern fn mtl_setup(desc: RendererDesc) void;
 extern fn mtl_shutdown() void;
@@ -348,6 +452,10 @@ extern fn mtl_scissor(x: c_int, y: c_int, w: c_int, h: c_int) void;
 extern fn mtl_create_image(desc: ImageDesc) *MtlImage;
 extern fn mtl_destroy_image(image: *MtlImage) void;
 extern fn mtl_update_image(image: *MtlImage, arg1: ?*const c_void) void;
+extern fn mtl_update_image_region(image: *MtlImage, x: c_int, y: c_int, w: c_int, h: c_int, bytes_per_row: u32, data: ?*const c_void) void;
+extern fn mtl_update_image_level(image: *MtlImage, level: c_int, bytes_per_row: u32, data: ?*const c_void) void;
+extern fn mtl_generate_mipmaps(image: *MtlImage) void;
+extern fn mtl_is_pixel_format_supported(format: PixelFormat) bool;
 
 extern fn mtl_create_pass(desc: MtlPassDesc) *MtlPass;
 extern fn mtl_destroy_pass(pass: *MtlPass) void;
@@ -359,12 +467,19 @@ extern fn mtl_create_buffer(desc: MtlBufferDesc) *MtlBuffer;
 extern fn mtl_destroy_buffer(buffer: *MtlBuffer) void;
 extern fn mtl_update_buffer(buffer: *MtlBuffer, data: ?*const c_void, data_size: u32) void;
 extern fn mtl_append_buffer(buffer: *MtlBuffer, data: ?*const c_void, data_size: u32) u32;
+extern fn mtl_reserve_append(buffer: *MtlBuffer, data_size: u32) [*]u8;
+extern fn mtl_commit_append(buffer: *MtlBuffer, data_size: u32) u32;
+extern fn mtl_get_buffer_stats(buffer: *MtlBuffer) BufferStats;
 
 extern fn mtl_create_shader(desc: MtlShaderDesc) *MtlShader;
 extern fn mtl_destroy_shader(shader: *MtlShader) void;
 extern fn mtl_use_shader(shader: *MtlShader) void;
+extern fn mtl_create_pipeline(shader: *MtlShader, state: RenderState, layout: *const VertexLayout) *MtlPipeline;
+extern fn mtl_destroy_pipeline(pipeline: *MtlPipeline) void;
+extern fn mtl_use_pipeline(pipeline: *MtlPipeline) void;
 extern fn mtl_set_shader_uniform_block(stage: ShaderStage, data: ?*const c_void, num_bytes: c_int) void;
+extern fn mtl_set_frame_uniform_block(data: ?*const c_void, num_bytes: c_int) void;
 extern fn mtl_set_shader_uniform(shader: *MtlShader, arg1: [*c]u8, arg2: ?*const c_void) void;
 
 extern fn mtl_apply_bindings(bindings: MtlBufferBindings) void;
-extern fn mtl_draw(base_element: c_int, element_count: c_int, instance_count: c_int) void;
+extern fn mtl_draw(cmd: DrawCommand) void;
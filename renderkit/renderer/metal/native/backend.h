@@ -23,21 +23,40 @@ typedef struct {
 	mtl_pipeline_cache_item_t* items;
 } mtl_pipeline_cache_t;
 
-// sampler cache
+// sampler cache, an open addressing hash table keyed by _mtl_sampler_key
 typedef struct {
-    TextureFilter_t min_filter;
-    TextureFilter_t mag_filter;
-    TextureWrap_t wrap_u;
-    TextureWrap_t wrap_v;
+    uint32_t key; // sampler key + 1 so that 0 marks an empty slot
 	uint32_t sampler_handle;
 } mtl_sampler_cache_item_t;
 
 typedef struct {
-    int capacity;
+    int capacity; // always a power of two, kept at least twice num_items
     int num_items;
     mtl_sampler_cache_item_t* items;
 } mtl_sampler_cache_t;
 
+// the slot holding `key` or the empty slot it belongs in
+static mtl_sampler_cache_item_t* _mtl_sampler_cache_slot(mtl_sampler_cache_t* cache, uint32_t key) {
+    const uint32_t mask = (uint32_t)cache->capacity - 1;
+    uint32_t index = (key * 2654435761u) & mask;
+    while (cache->items[index].key != 0 && cache->items[index].key != key)
+        index = (index + 1) & mask;
+    return &cache->items[index];
+}
+
+static void _mtl_sampler_cache_grow(mtl_sampler_cache_t* cache) {
+    mtl_sampler_cache_item_t* old_items = cache->items;
+    const int old_capacity = cache->capacity;
+
+    cache->capacity *= 2;
+    cache->items = (mtl_sampler_cache_item_t*) calloc(cache->capacity, sizeof(mtl_sampler_cache_item_t));
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_items[i].key != 0)
+            *_mtl_sampler_cache_slot(cache, old_items[i].key) = old_items[i];
+    }
+    free(old_items);
+}
+
 typedef struct {
     uint32_t frame_index; // frame index at which it is safe to release this resource
     uint32_t slot_index;
@@ -104,10 +123,8 @@ static mtl_idpool_t idpool;
 		memset(pipeline_cache.items, 0, pip_cache_size);
         
         memset(&sampler_cache, 0, sizeof(mtl_sampler_cache_t));
-        sampler_cache.capacity = 20;
-        const int sampler_cache_size = sampler_cache.capacity * sizeof(mtl_sampler_cache_item_t);
-        sampler_cache.items = (mtl_sampler_cache_item_t*) malloc(sampler_cache_size);
-        memset(sampler_cache.items, 0, sampler_cache_size);
+        sampler_cache.capacity = 32;
+        sampler_cache.items = (mtl_sampler_cache_item_t*) calloc(sampler_cache.capacity, sizeof(mtl_sampler_cache_item_t));
     }
     
     return self;
@@ -226,26 +243,16 @@ static mtl_idpool_t idpool;
 		item->vertex_buffer_type_ids[i] = bindings->vertex_buffers[i] != nil ? bindings->vertex_buffers[i]->type_id : 0;
 }
 
-- (id<MTLRenderPipelineState>)getOrCreatePipelineStateItem:(_mtl_shader*)shader
-							  blendState:(Blend_t*)blend_state
-								bindings:(MtlBufferBindings_t*)bindings
-							  metalLayer:(CAMetalLayer*)layer {
-	int index = [self findPipelineState:shader->shader_id blendState:blend_state bindings:bindings];
-	if (index >= 0) {
-		// reuse existing pipeline
-		return self.objectPool[pipeline_cache.items[index].pipeline_handle];
-	}
-	
-	printf("--- no existing pipeline. creating now\n");
-	
-	// create a new PipelineState object and add to pipeline cache
+- (MTLRenderPipelineDescriptor*)pipelineDescriptor:(_mtl_shader*)shader
+										blendState:(Blend_t*)blend_state
+										metalLayer:(CAMetalLayer*)layer {
 	MTLRenderPipelineDescriptor* pipelineStateDescriptor = [[MTLRenderPipelineDescriptor alloc] init];
 	pipelineStateDescriptor.label = @"Sprite Pipeline";
 	pipelineStateDescriptor.vertexFunction = self.objectPool[shader->vs_func];
 	pipelineStateDescriptor.fragmentFunction = self.objectPool[shader->fs_func];
 	pipelineStateDescriptor.colorAttachments[0].pixelFormat = layer.pixelFormat;
 	pipelineStateDescriptor.colorAttachments[0].writeMask = _mtl_color_write_mask(blend_state->color_write_mask);
-	
+
 	if (blend_state->enabled) {
 		pipelineStateDescriptor.colorAttachments[0].blendingEnabled = blend_state->enabled;
 		pipelineStateDescriptor.colorAttachments[0].alphaBlendOperation = _mtl_blend_op(blend_state->op_alpha);
@@ -255,6 +262,58 @@ static mtl_idpool_t idpool;
 		pipelineStateDescriptor.colorAttachments[0].sourceAlphaBlendFactor = _mtl_blend_factor(blend_state->src_factor_alpha);
 		pipelineStateDescriptor.colorAttachments[0].sourceRGBBlendFactor = _mtl_blend_factor(blend_state->src_factor_rgb);
 	}
+	return pipelineStateDescriptor;
+}
+
+// builds a pipeline from an explicit vertex layout instead of the bound buffers. The pipeline cache in pipeline.zig
+// dedupes these so they are not added to pipeline_cache.
+- (uint32_t)createPipelineState:(_mtl_shader*)shader
+					 blendState:(Blend_t*)blend_state
+						 layout:(const PipelineVertexLayout_t*)layout
+					 metalLayer:(CAMetalLayer*)layer {
+	MTLRenderPipelineDescriptor* pipelineStateDescriptor = [self pipelineDescriptor:shader blendState:blend_state metalLayer:layer];
+
+	MTLVertexDescriptor* vertexDesc = [MTLVertexDescriptor vertexDescriptor];
+	for (uint32_t i = 0; i < layout->num_attributes; i++) {
+		const PipelineVertexAttribute_t* attr = &layout->attributes[i];
+		vertexDesc.attributes[i].format = _mtl_vertex_format(attr->format);
+		vertexDesc.attributes[i].offset = attr->offset;
+		vertexDesc.attributes[i].bufferIndex = attr->buffer;
+	}
+	for (int i = 0; i < 4; i++) {
+		if (layout->buffers[i].stride == 0) break;
+		vertexDesc.layouts[i].stepFunction = _mtl_step_function(layout->buffers[i].step_func);
+		vertexDesc.layouts[i].stride = layout->buffers[i].stride;
+	}
+	pipelineStateDescriptor.vertexDescriptor = vertexDesc;
+
+	NSError* error = nil;
+	id<MTLRenderPipelineState> pipelineState = [layer.device newRenderPipelineStateWithDescriptor:pipelineStateDescriptor error:&error];
+	if (error) {
+		NSLog(@"Failed to created pipeline state, error %@", error);
+		return 0;
+	}
+	return [self addResource:pipelineState];
+}
+
+- (void)releasePipelineState:(uint32_t)pipeline_handle frameIndex:(uint32_t)frame_index {
+	[self releaseResourceWithFrameIndex:frame_index slotIndex:pipeline_handle];
+}
+
+- (id<MTLRenderPipelineState>)getOrCreatePipelineStateItem:(_mtl_shader*)shader
+							  blendState:(Blend_t*)blend_state
+								bindings:(MtlBufferBindings_t*)bindings
+							  metalLayer:(CAMetalLayer*)layer {
+	int index = [self findPipelineState:shader->shader_id blendState:blend_state bindings:bindings];
+	if (index >= 0) {
+		// reuse existing pipeline
+		return self.objectPool[pipeline_cache.items[index].pipeline_handle];
+	}
+	
+	printf("--- no existing pipeline. creating now\n");
+
+	// create a new PipelineState object and add to pipeline cache
+	MTLRenderPipelineDescriptor* pipelineStateDescriptor = [self pipelineDescriptor:shader blendState:blend_state metalLayer:layer];
 
 	// preprare the MTLVertexDescriptor
 	MTLVertexDescriptor* vertexDesc = [MTLVertexDescriptor vertexDescriptor];
@@ -326,49 +385,32 @@ static mtl_idpool_t idpool;
 }
 
 // sampler cache
-- (int)findSamplerState:(ImageDesc_t*)img_desc {
-    for (int i = 0; i < sampler_cache.num_items; i++) {
-        const mtl_sampler_cache_item_t* item = &sampler_cache.items[i];
-        if ((img_desc->min_filter == item->min_filter) &&
-            (img_desc->mag_filter == item->mag_filter) &&
-            (img_desc->wrap_u == item->wrap_u) &&
-            (img_desc->wrap_v == item->wrap_v))
-        {
-            return i;
-        }
-    }
-    
-    return -1;
-}
-
-- (void)addSamplerCacheItem:(const ImageDesc_t*)img_desc handle:(uint32_t)sampler_handle {
-    const int item_index = sampler_cache.num_items++;
-    mtl_sampler_cache_item_t* item = &sampler_cache.items[item_index];
-    item->min_filter = img_desc->min_filter;
-    item->mag_filter = img_desc->mag_filter;
-    item->wrap_u = img_desc->wrap_u;
-    item->wrap_v = img_desc->wrap_v;
-    item->sampler_handle = sampler_handle;
-}
-
-- (uint32_t)getOrCreateSampler:(id<MTLDevice>)mtl_device withImageDesc:(ImageDesc_t*)img_desc {
-    int index = [self findSamplerState:img_desc];
-    if (index >= 0) {
+- (uint32_t)getOrCreateSampler:(id<MTLDevice>)mtl_device withSamplerDesc:(const SamplerDesc_t*)desc {
+    const uint32_t key = _mtl_sampler_key(desc) + 1;
+    mtl_sampler_cache_item_t* item = _mtl_sampler_cache_slot(&sampler_cache, key);
+    if (item->key == key) {
         // reuse existing sampler
-        return (uint32_t)sampler_cache.items[index].sampler_handle;
+        return item->sampler_handle;
     }
 	
 	// create a new Metal sampler state object and add to sampler cache
 	MTLSamplerDescriptor *mtl_desc = [[MTLSamplerDescriptor alloc] init];
-	mtl_desc.sAddressMode = _mtl_address_mode(img_desc->wrap_u);
-	mtl_desc.tAddressMode = _mtl_address_mode(img_desc->wrap_v);
-	mtl_desc.minFilter = _mtl_minmag_filter(img_desc->min_filter);
-	mtl_desc.magFilter = _mtl_minmag_filter(img_desc->mag_filter);
+	mtl_desc.sAddressMode = _mtl_address_mode(desc->wrap_u);
+	mtl_desc.tAddressMode = _mtl_address_mode(desc->wrap_v);
+	mtl_desc.minFilter = _mtl_minmag_filter(desc->min_filter);
+	mtl_desc.magFilter = _mtl_minmag_filter(desc->mag_filter);
+	mtl_desc.mipFilter = _mtl_mip_filter(desc->mip_filter);
+	// Metal accepts 1 to 16 samples
+	mtl_desc.maxAnisotropy = MIN(MAX(desc->max_anisotropy, 1), 16);
 	mtl_desc.normalizedCoordinates = YES;
 	
 	id<MTLSamplerState> mtl_sampler = [mtl_device newSamplerStateWithDescriptor:mtl_desc];
 	uint32_t sampler_handle = [self addResource:mtl_sampler];
-	[self addSamplerCacheItem:img_desc handle:sampler_handle];
+
+	item->key = key;
+	item->sampler_handle = sampler_handle;
+	if (++sampler_cache.num_items * 2 > sampler_cache.capacity)
+		_mtl_sampler_cache_grow(&sampler_cache);
 
 	return sampler_handle;
 }
@@ -24,9 +24,14 @@ int cur_width;
 int cur_height;
 uint32_t frame_index = 1;
 
+// the block set with mtl_set_frame_uniform_block(), bound at buffer index 2 of both stages for every draw
+void* frame_uniform_data;
+uint32_t frame_uniform_size;
+
 // pipeline state
 _mtl_shader* cur_shader;
 RenderState_t cur_render_state;
+_mtl_pipeline* cur_pipeline; // set by mtl_use_pipeline, NULL when the pipeline is looked up from the bindings
 MtlBufferBindings_t cur_bindings;
 
 // setup
@@ -53,6 +58,7 @@ void mtl_shutdown() {
 	for (int i = 0; i < NUM_INFLIGHT_FRAMES; i++)
 		dispatch_semaphore_signal(render_semaphore);
 
+    free(frame_uniform_data);
     mtl_backend = nil;
 	cmd_buffer = nil;
 	cmd_encoder = nil;
@@ -64,6 +70,7 @@ void mtl_set_render_state(RenderState_t state) {
     printf("metal_set_render_state\n");
     assert(!in_pass);
 	cur_render_state = state;
+    cur_pipeline = NULL;
 }
 
 void mtl_viewport(int x, int y, int w, int h) {
@@ -115,10 +122,11 @@ _mtl_image* mtl_create_image(ImageDesc_t desc) {
     
     MTLTextureDescriptor* mtl_desc = [[MTLTextureDescriptor alloc] init];
     mtl_desc.textureType = MTLTextureType2D;
-    mtl_desc.pixelFormat = MTLPixelFormatRGBA8Unorm;
+    mtl_desc.pixelFormat = _mtl_pixel_format(desc.pixel_format);
     mtl_desc.width = desc.width;
     mtl_desc.height = desc.height;
     mtl_desc.depth = 1;
+    mtl_desc.mipmapLevelCount = desc.num_mipmaps;
     mtl_desc.arrayLength = 1;
     mtl_desc.usage = MTLTextureUsageShaderRead;
     if (desc.usage != usage_immutable)
@@ -135,11 +143,14 @@ _mtl_image* mtl_create_image(ImageDesc_t desc) {
 		mtl_desc.storageMode = MTLStorageModePrivate;
 		// render targets are shader-readable
 		mtl_desc.usage = MTLTextureUsageShaderRead | MTLTextureUsageRenderTarget;
-        mtl_desc.pixelFormat = MTLPixelFormatBGRA8Unorm;
+		if (desc.pixel_format == pixel_format_rgba)
+			mtl_desc.pixelFormat = MTLPixelFormatBGRA8Unorm;
 	}
 
 	img->width = desc.width;
 	img->height = desc.height;
+	img->num_mipmaps = desc.num_mipmaps;
+	img->pixel_format = desc.pixel_format;
 
     // special case depth-stencil-buffer
     if (desc.pixel_format == pixel_format_depth_stencil || desc.pixel_format == pixel_format_stencil) {
@@ -150,17 +161,25 @@ _mtl_image* mtl_create_image(ImageDesc_t desc) {
         img->depth_tex = [mtl_backend addResource:tex];
     } else {
         id<MTLTexture> tex = [layer.device newTextureWithDescriptor:mtl_desc];
-		if (desc.usage == usage_immutable && !desc.render_target) {
+		if (desc.usage == usage_immutable && !desc.render_target && desc.content) {
 			MTLRegion region = MTLRegionMake2D(0, 0, desc.width, desc.height);
 			[tex replaceRegion:region
                   mipmapLevel:0
                     withBytes:desc.content
-                  bytesPerRow:desc.width * 4];
+                  bytesPerRow:_mtl_bytes_per_row(desc.pixel_format, desc.width)];
 			RK_ASSERT(tex != nil);
 		}
 
         // create (possibly shared) sampler state
-        img->sampler_state = [mtl_backend getOrCreateSampler:layer.device withImageDesc:&desc];
+        const SamplerDesc_t sampler_desc = {
+            .min_filter = desc.min_filter,
+            .mag_filter = desc.mag_filter,
+            .mip_filter = desc.mip_filter,
+            .wrap_u = desc.wrap_u,
+            .wrap_v = desc.wrap_v,
+            .max_anisotropy = desc.max_anisotropy,
+        };
+        img->sampler_state = [mtl_backend getOrCreateSampler:layer.device withSamplerDesc:&sampler_desc];
         img->tex = [mtl_backend addResource:tex];
     }
     
@@ -180,7 +199,61 @@ void mtl_update_image(_mtl_image* img, void* data) {
     printf("metal_update_image\n");
 	__unsafe_unretained id<MTLTexture> mtl_tex = mtl_backend.objectPool[img->tex];
 	MTLRegion region = MTLRegionMake2D(0, 0, img->width, img->height);
-	[mtl_tex replaceRegion:region mipmapLevel:0 withBytes:data bytesPerRow:img->width * 4];
+	[mtl_tex replaceRegion:region mipmapLevel:0 withBytes:data bytesPerRow:_mtl_bytes_per_row(img->pixel_format, img->width)];
+}
+
+void mtl_update_image_region(_mtl_image* img, int x, int y, int w, int h, uint32_t bytes_per_row, const void* data) {
+    RK_ASSERT(x >= 0 && y >= 0 && x + w <= (int)img->width && y + h <= (int)img->height);
+	__unsafe_unretained id<MTLTexture> mtl_tex = mtl_backend.objectPool[img->tex];
+	MTLRegion region = MTLRegionMake2D(x, y, w, h);
+	if (bytes_per_row == 0)
+		bytes_per_row = _mtl_bytes_per_row(img->pixel_format, w);
+	[mtl_tex replaceRegion:region mipmapLevel:0 withBytes:data bytesPerRow:bytes_per_row];
+}
+
+void mtl_update_image_level(_mtl_image* img, int level, uint32_t bytes_per_row, const void* data) {
+	RK_ASSERT(level >= 0 && level < (int)img->num_mipmaps);
+	__unsafe_unretained id<MTLTexture> mtl_tex = mtl_backend.objectPool[img->tex];
+	int w = MAX(1, (int)img->width >> level);
+	int h = MAX(1, (int)img->height >> level);
+	if (bytes_per_row == 0)
+		bytes_per_row = _mtl_bytes_per_row(img->pixel_format, w);
+	[mtl_tex replaceRegion:MTLRegionMake2D(0, 0, w, h) mipmapLevel:level withBytes:data bytesPerRow:bytes_per_row];
+}
+
+void mtl_generate_mipmaps(_mtl_image* img) {
+	RK_ASSERT(img->num_mipmaps > 1);
+	// a command buffer of its own, committed before the frame's command buffer so the levels are ready for its draws
+	id<MTLCommandBuffer> blit_buffer = [cmd_queue commandBuffer];
+	id<MTLBlitCommandEncoder> blit_encoder = [blit_buffer blitCommandEncoder];
+	[blit_encoder generateMipmapsForTexture:mtl_backend.objectPool[img->tex]];
+	[blit_encoder endEncoding];
+	[blit_buffer commit];
+}
+
+bool mtl_is_pixel_format_supported(PixelFormat_t format) {
+	switch (format) {
+		case pixel_format_bc1:
+		case pixel_format_bc3:
+		case pixel_format_bc7:
+#if TARGET_OS_OSX
+			if (@available(macOS 11.0, *))
+				return layer.device.supportsBCTextureCompression;
+			return true;
+#else
+			return false;
+#endif
+		// packed 16 bit, etc2 and astc formats are only sampled by Apple GPUs
+		case pixel_format_rgb565:
+		case pixel_format_etc2_rgb8:
+		case pixel_format_etc2_rgba8:
+		case pixel_format_astc_4x4:
+			if (@available(macOS 10.15, iOS 13.0, *))
+				return [layer.device supportsFamily:MTLGPUFamilyApple2];
+			return !TARGET_OS_OSX;
+		default:
+			return true;
+	}
 }
 
 
@@ -300,6 +373,10 @@ _mtl_buffer* mtl_create_buffer(MtlBufferDesc_t desc) {
     buffer->size = (int)desc.size;
     buffer->num_slots = (desc.usage == usage_immutable) ? 1 : NUM_INFLIGHT_FRAMES;
     buffer->type_id = desc.type_id;
+    buffer->type = desc.type;
+    buffer->usage = desc.usage;
+    buffer->grow = desc.grow && desc.usage != usage_immutable;
+    buffer->stats.size = (uint32_t)desc.size;
 
     // store off some data we will need for the pipeline later
     if (desc.type == buffer_type_vertex) {
@@ -337,6 +414,8 @@ void mtl_destroy_buffer(_mtl_buffer* buffer) {
         // it's valid to call release resource with
         [mtl_backend releaseResourceWithFrameIndex:frame_index slotIndex:buffer->buffers[slot]];
     }
+    [mtl_backend releaseResourceWithFrameIndex:frame_index slotIndex:buffer->overflow_buffer];
+    free(buffer->staging);
     free(buffer);
 }
 
@@ -359,13 +438,7 @@ void mtl_update_buffer(_mtl_buffer* buffer, const void* data, uint32_t num_bytes
 }
 
 // this is the workhorse for buffer appends, called by mtl_append_buffer after it does its validation and bookkeeping
-void _mtl_append_buffer(_mtl_buffer* buffer, const void* data, uint32_t num_bytes, bool new_frame) {
-    // if this is our first append this frame rotate the active slot
-    if (new_frame) {
-        if (++buffer->active_slot >= buffer->num_slots)
-            buffer->active_slot = 0;
-    }
-    
+void _mtl_append_buffer(_mtl_buffer* buffer, const void* data, uint32_t num_bytes) {
     __unsafe_unretained id<MTLBuffer> mtl_buf = mtl_backend.objectPool[buffer->buffers[buffer->active_slot]];
     uint8_t* dst_ptr = (uint8_t*) [mtl_buf contents];
     dst_ptr += buffer->append_pos;
@@ -373,31 +446,155 @@ void _mtl_append_buffer(_mtl_buffer* buffer, const void* data, uint32_t num_byte
     [mtl_buf didModifyRange:NSMakeRange(buffer->append_pos, num_bytes)];
 }
 
-uint32_t mtl_append_buffer(_mtl_buffer* buffer, const void* data, uint32_t num_bytes) {
-    RK_ASSERT(num_bytes <= buffer->size);
-    
-    // rewind append cursor in a new frame
+// reallocates every slot of a buffer that overflowed, doubling its size until it holds the high-water mark. The old
+// slots are released deferred since in flight frames may still read them.
+void _mtl_grow_buffer(_mtl_buffer* buffer) {
+    while (buffer->size < (int)buffer->stats.high_water)
+        buffer->size *= 2;
+
+    MTLResourceOptions mtl_options = _mtl_buffer_resource_options(buffer->usage);
+    for (int slot = 0; slot < buffer->num_slots; slot++) {
+        [mtl_backend releaseResourceWithFrameIndex:frame_index slotIndex:buffer->buffers[slot]];
+        id<MTLBuffer> mtl_buf = [layer.device newBufferWithLength:buffer->size options:mtl_options];
+        buffer->buffers[slot] = [mtl_backend addResource:mtl_buf];
+    }
+
+    buffer->stats.size = (uint32_t)buffer->size;
+    buffer->stats.grow_count++;
+    buffer->grow_pending = false;
+}
+
+// writes appended bytes that didn't fit into a growable vertex buffer into its overflow block for this frame. The offset
+// is past the end of the buffer, which is how mtl_apply_bindings knows to bind the block. Index data isn't spilled since
+// mtl_draw always reads the index buffer's active slot.
+bool _mtl_spill_append(_mtl_buffer* buffer, const void* data, uint32_t num_bytes, uint32_t* offset) {
+    if (!buffer->grow || buffer->type != buffer_type_vertex)
+        return false;
+
+    if (buffer->overflow_buffer == 0) {
+        buffer->overflow_size = max(buffer->size, (int)num_bytes);
+        id<MTLBuffer> mtl_buf = [layer.device newBufferWithLength:buffer->overflow_size options:_mtl_buffer_resource_options(buffer->usage)];
+        buffer->overflow_buffer = [mtl_backend addResource:mtl_buf];
+    }
+    if ((buffer->overflow_pos + (int)num_bytes) > buffer->overflow_size)
+        return false;
+
+    __unsafe_unretained id<MTLBuffer> mtl_buf = mtl_backend.objectPool[buffer->overflow_buffer];
+    uint8_t* dst_ptr = (uint8_t*) [mtl_buf contents];
+    memcpy(dst_ptr + buffer->overflow_pos, data, num_bytes);
+    [mtl_buf didModifyRange:NSMakeRange(buffer->overflow_pos, num_bytes)];
+
+    *offset = (uint32_t)(buffer->size + buffer->overflow_pos);
+    buffer->overflow_pos += num_bytes;
+    buffer->stats.spilled_bytes += num_bytes;
+    return true;
+}
+
+// rewinds the append cursor and rotates the active slot in a new frame. This is the frame boundary where a buffer that
+// overflowed grows and the last frame's overflow block is let go.
+void _mtl_rewind_append(_mtl_buffer* buffer) {
     if (buffer->append_frame_index != frame_index) {
+        if (buffer->grow_pending)
+            _mtl_grow_buffer(buffer);
+        if (buffer->overflow_buffer != 0) {
+            [mtl_backend releaseResourceWithFrameIndex:frame_index slotIndex:buffer->overflow_buffer];
+            buffer->overflow_buffer = 0;
+        }
+        if (++buffer->active_slot >= buffer->num_slots)
+            buffer->active_slot = 0;
+
+        buffer->append_frame_index = frame_index;
         buffer->append_pos = 0;
         buffer->append_overflow = false;
+        buffer->frame_bytes = 0;
+        buffer->overflow_pos = 0;
     }
-    
-	// check for overflow
-    if ((buffer->append_pos + num_bytes) > buffer->size)
+}
+
+// counts num_bytes towards the frame's high-water mark and returns false if they don't fit. Once a frame overflows the
+// rest of its appends spill or are dropped to keep them in order.
+bool _mtl_track_append(_mtl_buffer* buffer, uint32_t num_bytes) {
+    buffer->frame_bytes += num_bytes;
+    buffer->stats.high_water = max(buffer->stats.high_water, buffer->frame_bytes);
+
+    if (!buffer->append_overflow && (buffer->append_pos + num_bytes) > buffer->size) {
         buffer->append_overflow = true;
+        buffer->stats.overflow_frames++;
+        buffer->grow_pending = buffer->grow;
+    }
+    return !buffer->append_overflow;
+}
+
+uint32_t mtl_append_buffer(_mtl_buffer* buffer, const void* data, uint32_t num_bytes) {
+    RK_ASSERT(buffer->grow || num_bytes <= buffer->size);
+    _mtl_rewind_append(buffer);
     
     const uint32_t start_pos = buffer->append_pos;
-    if (!buffer->append_overflow && (num_bytes > 0)) {
-        // update and append on same buffer in same frame not allowed
-        RK_ASSERT(buffer->update_frame_index != frame_index);
-        _mtl_append_buffer(buffer, data, num_bytes, buffer->append_frame_index != frame_index);
+    const bool fits = _mtl_track_append(buffer, num_bytes);
+    if (num_bytes == 0)
+        return start_pos;
+
+    // update and append on same buffer in same frame not allowed
+    RK_ASSERT(buffer->update_frame_index != frame_index);
+
+    if (!fits) {
+        uint32_t spill_offset;
+        if (_mtl_spill_append(buffer, data, num_bytes, &spill_offset))
+            return spill_offset;
+        buffer->stats.dropped_bytes += num_bytes;
+    } else {
+        _mtl_append_buffer(buffer, data, num_bytes);
         buffer->append_pos += num_bytes;
-        buffer->append_frame_index = frame_index;
     }
     
     return start_pos;
 }
 
+// returns room for num_bytes at the append cursor, directly in the active slot's contents. Reservations that don't fit
+// get staging memory that mtl_commit_append() spills or drops like mtl_append_buffer() would.
+void* mtl_reserve_append(_mtl_buffer* buffer, uint32_t num_bytes) {
+    RK_ASSERT(buffer->reserved_bytes == 0);
+    // update and append on same buffer in same frame not allowed
+    RK_ASSERT(buffer->update_frame_index != frame_index);
+    _mtl_rewind_append(buffer);
+
+    buffer->reserved_bytes = num_bytes;
+    buffer->reserved_staging = buffer->append_overflow || (buffer->append_pos + num_bytes) > buffer->size;
+    if (buffer->reserved_staging) {
+        if (buffer->staging_size < num_bytes) {
+            free(buffer->staging);
+            buffer->staging = malloc(num_bytes);
+            buffer->staging_size = num_bytes;
+        }
+        return buffer->staging;
+    }
+
+    __unsafe_unretained id<MTLBuffer> mtl_buf = mtl_backend.objectPool[buffer->buffers[buffer->active_slot]];
+    return (uint8_t*) [mtl_buf contents] + buffer->append_pos;
+}
+
+uint32_t mtl_commit_append(_mtl_buffer* buffer, uint32_t num_bytes) {
+    RK_ASSERT(num_bytes <= buffer->reserved_bytes);
+    buffer->reserved_bytes = 0;
+
+    if (buffer->reserved_staging)
+        return mtl_append_buffer(buffer, buffer->staging, num_bytes);
+
+    const uint32_t start_pos = buffer->append_pos;
+    // the reservation was checked against the room left so this can't overflow
+    _mtl_track_append(buffer, num_bytes);
+    if (num_bytes > 0) {
+        __unsafe_unretained id<MTLBuffer> mtl_buf = mtl_backend.objectPool[buffer->buffers[buffer->active_slot]];
+        [mtl_buf didModifyRange:NSMakeRange(start_pos, num_bytes)];
+        buffer->append_pos += num_bytes;
+    }
+    return start_pos;
+}
+
+BufferStats_t mtl_get_buffer_stats(_mtl_buffer* buffer) {
+    return buffer->stats;
+}
+
 
 // shaders
 _mtl_shader* mtl_create_shader(ShaderDesc_t desc) {
@@ -467,6 +664,7 @@ void mtl_destroy_shader(_mtl_shader* shader) {
 
 void mtl_use_shader(_mtl_shader* shader) {
     cur_shader = shader;
+    cur_pipeline = NULL;
 }
 
 void mtl_set_shader_uniform_block(enum ShaderStage_t stage, const void* data, int num_bytes) {
@@ -480,6 +678,15 @@ void mtl_set_shader_uniform_block(enum ShaderStage_t stage, const void* data, in
     memcpy(data_block, data, num_bytes);
 }
 
+void mtl_set_frame_uniform_block(const void* data, int num_bytes) {
+    if (frame_uniform_size != (uint32_t)num_bytes) {
+        free(frame_uniform_data);
+        frame_uniform_data = malloc(num_bytes);
+        frame_uniform_size = num_bytes;
+    }
+    memcpy(frame_uniform_data, data, num_bytes);
+}
+
 void mtl_set_shader_uniform(_mtl_shader* shader, uint8_t* arg1, void* arg2) {
     RK_ASSERT(in_pass);
     if (!pass_valid) return;
@@ -488,14 +695,43 @@ void mtl_set_shader_uniform(_mtl_shader* shader, uint8_t* arg1, void* arg2) {
 }
 
 
+// pipelines
+_mtl_pipeline* mtl_create_pipeline(_mtl_shader* shader, RenderState_t state, const PipelineVertexLayout_t* layout) {
+    _mtl_pipeline* pipeline = malloc(sizeof(_mtl_pipeline));
+    pipeline->shader = shader;
+    pipeline->render_state = state;
+    pipeline->pipeline_handle = [mtl_backend createPipelineState:shader
+                                                      blendState:&pipeline->render_state.blend
+                                                          layout:layout
+                                                      metalLayer:layer];
+    return pipeline;
+}
+
+void mtl_destroy_pipeline(_mtl_pipeline* pipeline) {
+    if (cur_pipeline == pipeline) cur_pipeline = NULL;
+    [mtl_backend releasePipelineState:pipeline->pipeline_handle frameIndex:frame_index];
+    free(pipeline);
+}
+
+void mtl_use_pipeline(_mtl_pipeline* pipeline) {
+    RK_ASSERT(pipeline->pipeline_handle != 0);
+    cur_pipeline = pipeline;
+    cur_shader = pipeline->shader;
+    cur_render_state = pipeline->render_state;
+}
+
+
 // bindings and draw
 void mtl_apply_bindings(MtlBufferBindings_t bindings) {
     cur_bindings = bindings;
 
-	id<MTLRenderPipelineState> pipeline = [mtl_backend getOrCreatePipelineStateItem:cur_shader
-																		 blendState:&cur_render_state.blend
-																		   bindings:&bindings
-																		 metalLayer:layer];
+    // a prebuilt pipeline skips the search through the pipeline cache
+	id<MTLRenderPipelineState> pipeline = cur_pipeline != NULL ?
+        mtl_backend.objectPool[cur_pipeline->pipeline_handle] :
+        [mtl_backend getOrCreatePipelineStateItem:cur_shader
+                                       blendState:&cur_render_state.blend
+                                         bindings:&bindings
+                                       metalLayer:layer];
     [cmd_encoder setRenderPipelineState:pipeline];
     [cmd_encoder setCullMode:MTLCullModeNone];
 
@@ -503,9 +739,17 @@ void mtl_apply_bindings(MtlBufferBindings_t bindings) {
     for (int i = 0; i < 4; i++) {
         _mtl_buffer* buffer = bindings.vertex_buffers[i];
         if (buffer == NULL) break;
+        uint32_t mtl_buf = buffer->buffers[buffer->active_slot];
+        uint32_t offset = bindings.vertex_buffer_offsets[i];
+        // offsets past the end of the buffer were returned for spilled appends and address the overflow block
+        if (offset >= (uint32_t)buffer->size) {
+            mtl_buf = buffer->overflow_buffer;
+            offset -= (uint32_t)buffer->size;
+        }
+
         // TODO: cache the bound buffer and if it doesnt change (common for batcher) use setVertexBufferOffset: instead
-        [cmd_encoder setVertexBuffer:mtl_backend.objectPool[buffer->buffers[buffer->active_slot]]
-							  offset:bindings.vertex_buffer_offsets[i]
+        [cmd_encoder setVertexBuffer:mtl_backend.objectPool[mtl_buf]
+							  offset:offset
 							 atIndex:0];
     }
     
@@ -513,24 +757,34 @@ void mtl_apply_bindings(MtlBufferBindings_t bindings) {
     [cmd_encoder setVertexBytes:cur_shader->vs_uniform_data length:cur_shader->vs_uniform_size atIndex:1];
     if (cur_shader->fs_uniform_size > 0)
         [cmd_encoder setFragmentBytes:cur_shader->fs_uniform_data length:cur_shader->fs_uniform_size atIndex:0];
+    if (frame_uniform_size > 0) {
+        [cmd_encoder setVertexBytes:frame_uniform_data length:frame_uniform_size atIndex:2];
+        [cmd_encoder setFragmentBytes:frame_uniform_data length:frame_uniform_size atIndex:2];
+    }
 
     // set textures
     for (int i = 0; i < 8; i++) {
         if (bindings.images[i] == NULL) break;
         RK_ASSERT(bindings.images[i]->sampler_state != 0);
+        // overrides are looked up by key, a hash table probe per bind
+        const uint32_t sampler_state = (bindings.sampler_overrides & (1u << i)) ?
+            [mtl_backend getOrCreateSampler:layer.device withSamplerDesc:&bindings.samplers[i]] :
+            bindings.images[i]->sampler_state;
         [cmd_encoder setFragmentTexture:mtl_backend.objectPool[bindings.images[i]->tex] atIndex:i];
-        [cmd_encoder setFragmentSamplerState:mtl_backend.objectPool[bindings.images[i]->sampler_state] atIndex:i];
+        [cmd_encoder setFragmentSamplerState:mtl_backend.objectPool[sampler_state] atIndex:i];
     }
 }
 
-void mtl_draw(int base_element, int element_count, int instance_count) {
+void mtl_draw(DrawCommand_t cmd) {
     const NSUInteger index_size = cur_bindings.index_buffer->index_type == MTLIndexTypeUInt16 ? 2 : 4;
-    const NSUInteger index_buffer_offset = base_element * index_size; // + cur_bindings.index_buffer_offset; // TODO: dynamic index buffers
+    const NSUInteger index_buffer_offset = cmd.base_element * index_size; // + cur_bindings.index_buffer_offset; // TODO: dynamic index buffers
 
-	[cmd_encoder drawIndexedPrimitives:MTLPrimitiveTypeTriangle
-							indexCount:element_count
+	[cmd_encoder drawIndexedPrimitives:_mtl_primitive_type(cmd.primitive_type)
+							indexCount:cmd.element_count
 							 indexType:cur_bindings.index_buffer->index_type
 						   indexBuffer:mtl_backend.objectPool[cur_bindings.index_buffer->buffers[cur_bindings.index_buffer->active_slot]]
 					 indexBufferOffset:index_buffer_offset
-						 instanceCount:instance_count];
+						 instanceCount:cmd.instance_count
+							baseVertex:cmd.base_vertex
+						  baseInstance:cmd.base_instance];
 }
@@ -38,6 +38,22 @@ MTLSamplerMinMagFilter _mtl_minmag_filter(TextureFilter_t f) {
 }
 
 
+typedef enum MipFilter_t {
+    mip_filter_none,
+    mip_filter_nearest,
+    mip_filter_linear,
+} MipFilter_t;
+
+MTLSamplerMipFilter _mtl_mip_filter(MipFilter_t f) {
+	switch (f) {
+		case mip_filter_none: return MTLSamplerMipFilterNotMipmapped;
+		case mip_filter_nearest: return MTLSamplerMipFilterNearest;
+		case mip_filter_linear: return MTLSamplerMipFilterLinear;
+		default:
+			RK_UNREACHABLE; return (MTLSamplerMipFilter)0;
+	}
+}
+
 typedef enum TextureWrap_t {
     texture_wrap_clamp,
     texture_wrap_repeat,
@@ -55,8 +71,51 @@ typedef enum PixelFormat_t {
     pixel_format_rgba,
     pixel_format_stencil,
     pixel_format_depth_stencil,
+    pixel_format_r8,
+    pixel_format_rg8,
+    pixel_format_rgb565,
+    pixel_format_bc1,
+    pixel_format_bc3,
+    pixel_format_bc7,
+    pixel_format_etc2_rgb8,
+    pixel_format_etc2_rgba8,
+    pixel_format_astc_4x4,
 } PixelFormat_t;
 
+MTLPixelFormat _mtl_pixel_format(PixelFormat_t fmt) {
+	switch (fmt) {
+		case pixel_format_rgba:          return MTLPixelFormatRGBA8Unorm;
+		case pixel_format_stencil:       return MTLPixelFormatStencil8;
+		case pixel_format_depth_stencil: return MTLPixelFormatDepth32Float_Stencil8;
+		case pixel_format_r8:            return MTLPixelFormatR8Unorm;
+		case pixel_format_rg8:           return MTLPixelFormatRG8Unorm;
+		case pixel_format_rgb565:        return MTLPixelFormatB5G6R5Unorm;
+		case pixel_format_bc1:           return MTLPixelFormatBC1_RGBA;
+		case pixel_format_bc3:           return MTLPixelFormatBC3_RGBA;
+		case pixel_format_bc7:           return MTLPixelFormatBC7_RGBAUnorm;
+		case pixel_format_etc2_rgb8:     return MTLPixelFormatETC2_RGB8;
+		case pixel_format_etc2_rgba8:    return MTLPixelFormatEAC_RGBA8;
+		case pixel_format_astc_4x4:      return MTLPixelFormatASTC_4x4_LDR;
+		default: RK_UNREACHABLE; return MTLPixelFormatInvalid;
+	}
+}
+
+// bytes of a tightly packed row of texels, or of 4x4 blocks for the compressed formats
+uint32_t _mtl_bytes_per_row(PixelFormat_t fmt, int width) {
+	switch (fmt) {
+		case pixel_format_r8:         return width;
+		case pixel_format_rg8:
+		case pixel_format_rgb565:     return width * 2;
+		case pixel_format_bc1:
+		case pixel_format_etc2_rgb8:  return (width + 3) / 4 * 8;
+		case pixel_format_bc3:
+		case pixel_format_bc7:
+		case pixel_format_etc2_rgba8:
+		case pixel_format_astc_4x4:   return (width + 3) / 4 * 16;
+		default:                      return width * 4;
+	}
+}
+
 typedef enum Usage_t {
     usage_immutable,
     usage_dynamic,
@@ -88,6 +147,17 @@ typedef enum PrimitiveType_t {
     primitive_type_triangles,
 } PrimitiveType_t;
 
+MTLPrimitiveType _mtl_primitive_type(PrimitiveType_t t) {
+	switch (t) {
+		case primitive_type_points:          return MTLPrimitiveTypePoint;
+		case primitive_type_line_strip:      return MTLPrimitiveTypeLineStrip;
+		case primitive_type_lines:           return MTLPrimitiveTypeLine;
+		case primitive_type_triangle_strip:  return MTLPrimitiveTypeTriangleStrip;
+		case primitive_type_triangles:       return MTLPrimitiveTypeTriangle;
+		default: RK_UNREACHABLE; return (MTLPrimitiveType)0;
+	}
+}
+
 typedef enum ElementType_t {
     element_type_u8,
     element_type_u16,
@@ -315,13 +385,31 @@ typedef struct ClearCommand_t {
    double depth;
 } ClearCommand_t;
 
+typedef struct DrawCommand_t {
+   enum PrimitiveType_t primitive_type;
+   int base_element;
+   int element_count;
+   int instance_count;
+   int base_vertex;
+   int base_instance;
+} DrawCommand_t;
+
+typedef struct BufferStats_t {
+   uint32_t size;
+   uint32_t high_water;
+   uint32_t overflow_frames;
+   uint32_t grow_count;
+   uint64_t spilled_bytes;
+   uint64_t dropped_bytes;
+} BufferStats_t;
+
 
 // descriptor structs
 typedef struct PoolSizes_t {
-   uint8_t texture;
-   uint8_t offscreen_pass;
-   uint8_t buffers;
-   uint8_t shaders;
+   uint32_t texture;
+   uint32_t offscreen_pass;
+   uint32_t buffers;
+   uint32_t shaders;
 } PoolSizes_t;
 
 typedef struct MetalSetup_t {
@@ -333,18 +421,38 @@ typedef struct RendererDesc_t {
    const void* (*getProcAddress)(uint8_t*);
    PoolSizes_t pool_sizes;
    MetalSetup_t metal;
+   const char* shader_cache_dir;
 } RendererDesc_t;
 
+typedef struct SamplerDesc_t {
+   enum TextureFilter_t min_filter;
+   enum TextureFilter_t mag_filter;
+   enum MipFilter_t mip_filter;
+   enum TextureWrap_t wrap_u;
+   enum TextureWrap_t wrap_v;
+   int32_t max_anisotropy;
+} SamplerDesc_t;
+
+// packs every field into 10 bits, equal keys mean equal samplers
+uint32_t _mtl_sampler_key(const SamplerDesc_t* desc) {
+	const uint32_t anisotropy = (uint32_t)(MIN(MAX(desc->max_anisotropy, 1), 16) - 1);
+	return (uint32_t)desc->min_filter | ((uint32_t)desc->mag_filter << 1) | ((uint32_t)desc->mip_filter << 2) |
+		((uint32_t)desc->wrap_u << 4) | ((uint32_t)desc->wrap_v << 5) | (anisotropy << 6);
+}
+
 typedef struct ImageDesc_t {
    bool render_target;
    int32_t width;
    int32_t height;
+   int32_t num_mipmaps;
    enum Usage_t usage;
    enum PixelFormat_t pixel_format;
    enum TextureFilter_t min_filter;
    enum TextureFilter_t mag_filter;
+   enum MipFilter_t mip_filter;
    enum TextureWrap_t wrap_u;
    enum TextureWrap_t wrap_v;
+   int32_t max_anisotropy;
    uint8_t* content;
 } ImageDesc_t;
 
@@ -392,6 +500,24 @@ typedef struct VertexLayout_t {
     VertexStep_t step_func;
 } VertexLayout_t;
 
+// backend agnostic vertex layout of a pipeline, mirrors VertexLayout in descriptions.zig
+typedef struct PipelineVertexAttribute_t {
+    VertexFormat_t format;
+    uint32_t offset;
+    uint32_t buffer;
+} PipelineVertexAttribute_t;
+
+typedef struct PipelineVertexBuffer_t {
+    uint32_t stride;
+    VertexStep_t step_func;
+} PipelineVertexBuffer_t;
+
+typedef struct PipelineVertexLayout_t {
+    PipelineVertexAttribute_t attributes[8];
+    uint32_t num_attributes;
+    PipelineVertexBuffer_t buffers[4];
+} PipelineVertexLayout_t;
+
 typedef struct MtlBufferDesc_t {
     long size; // either size (for stream buffers) or content (for static/dynamic) must be set
     BufferType_t type;
@@ -401,6 +527,7 @@ typedef struct MtlBufferDesc_t {
     IndexType_t index_type;
     VertexLayout_t vertex_layout[4];
     VertexAttribute_t vertex_attrs[8];
+    bool grow;
 } MtlBufferDesc_t;
 
 
@@ -429,6 +556,8 @@ typedef struct _mtl_image {
 	uint32_t sampler_state;
 	uint32_t width;
 	uint32_t height;
+	uint32_t num_mipmaps;
+	PixelFormat_t pixel_format;
 } _mtl_image;
 
 typedef struct _mtl_pass {
@@ -448,11 +577,24 @@ typedef struct mtl_vertex_attribute_t {
 
 typedef struct _mtl_buffer {
 	uint8_t type_id;                // unique identifier for they type of the buffer
+    BufferType_t type;
+    Usage_t usage;
     int size;                       // size of the buffer in bytes
     uint32_t update_frame_index;    // frame index of last mtl_update_buffer()
     uint32_t append_frame_index;    // frame index of last mtl_append_buffer()
     int append_pos;                 // current position in buffer for sg_append_buffer()
     bool append_overflow;           // is buffer in overflow state (due to sg_append_buffer)
+    bool grow;                      // grow at the next frame boundary after an overflow instead of dropping appends
+    bool grow_pending;              // an overflow happened and the next frame's first append grows the buffer
+    uint32_t frame_bytes;           // bytes mtl_append_buffer() was asked for this frame, including the ones that didn't fit
+    uint32_t overflow_buffer;       // per-frame overflow block of a growable vertex buffer, 0 if nothing spilled
+    int overflow_size;
+    int overflow_pos;
+    BufferStats_t stats;
+    uint32_t reserved_bytes;        // size of the open mtl_reserve_append() reservation, 0 if there is none
+    bool reserved_staging;          // the reservation didn't fit and points into staging memory
+    void* staging;                  // the buffer's own staging memory, reused until the buffer is destroyed
+    uint32_t staging_size;
     int num_slots;                  // number of renaming-slots for dynamically updated buffers
     int active_slot;                // currently active write-slot for dynamically updated buffers
     uint32_t buffers[NUM_INFLIGHT_FRAMES];
@@ -473,11 +615,21 @@ typedef struct _mtl_shader {
     uint32_t fs_uniform_size;
 } _mtl_shader;
 
+// a MTLRenderPipelineState built up front by mtl_create_pipeline along with the state it was built for
+typedef struct _mtl_pipeline {
+    uint32_t pipeline_handle;
+    _mtl_shader* shader;
+    RenderState_t render_state;
+} _mtl_pipeline;
+
 typedef struct MtlBufferBindings_t {
     _mtl_buffer* index_buffer;
     _mtl_buffer* vertex_buffers[4];
 	uint32_t vertex_buffer_offsets[4];
     _mtl_image* images[8];
+    // bit i set if samplers[i] replaces the sampler of images[i]
+    uint32_t sampler_overrides;
+    SamplerDesc_t samplers[8];
 } MtlBufferBindings_t;
 
 
@@ -493,6 +645,7 @@ void mtl_scissor(int x, int y, int w, int h);
 _mtl_image* mtl_create_image(ImageDesc_t desc);
 void mtl_destroy_image(_mtl_image* arg0);
 void mtl_update_image(_mtl_image* img, void* data);
+void mtl_update_image_region(_mtl_image* img, int x, int y, int w, int h, uint32_t bytes_per_row, const void* data);
 
 _mtl_pass* mtl_create_pass(PassDesc_t desc);
 void mtl_destroy_pass(_mtl_pass* pass);
@@ -505,12 +658,20 @@ _mtl_buffer* mtl_create_buffer(MtlBufferDesc_t desc);
 void mtl_destroy_buffer(_mtl_buffer* buffer);
 void mtl_update_buffer(_mtl_buffer* buffer, const void* data, uint32_t data_size);
 uint32_t mtl_append_buffer(_mtl_buffer* buffer, const void* data, uint32_t data_size);
+void* mtl_reserve_append(_mtl_buffer* buffer, uint32_t data_size);
+uint32_t mtl_commit_append(_mtl_buffer* buffer, uint32_t data_size);
+BufferStats_t mtl_get_buffer_stats(_mtl_buffer* buffer);
 
 _mtl_shader* mtl_create_shader(ShaderDesc_t desc);
 void mtl_destroy_shader(_mtl_shader* shader);
 void mtl_use_shader(_mtl_shader* shader);
 void mtl_set_shader_uniform_block(enum ShaderStage_t stage, const void* data, int num_bytes);
+void mtl_set_frame_uniform_block(const void* data, int num_bytes);
 void mtl_set_shader_uniform(_mtl_shader* shader, uint8_t* arg1, void* arg2);
 
+_mtl_pipeline* mtl_create_pipeline(_mtl_shader* shader, RenderState_t state, const PipelineVertexLayout_t* layout);
+void mtl_destroy_pipeline(_mtl_pipeline* pipeline);
+void mtl_use_pipeline(_mtl_pipeline* pipeline);
+
 void mtl_apply_bindings(MtlBufferBindings_t bindings);
-void mtl_draw(int base_element, int element_count, int instance_count);
+void mtl_draw(DrawCommand_t cmd);
@@ -0,0 +1,321 @@
+const std = @import("std");
+const renderkit = @import("types.zig");
+
+/// CPU mip generation for rgba8 pixels, for images built offline or before upload. Each level is half the size of the
+/// one above rounded down, so odd sized levels drop their last row or column like most `glGenerateMipmap`
+/// implementations. Colors are filtered as stored: premultiply alpha first to keep transparent texels from bleeding.
+pub const Filter = enum {
+    /// 2x2 average, computed on four output texels at a time
+    box,
+    /// 6x6 Kaiser windowed sinc. Sharper than box, roughly ten times slower.
+    kaiser,
+};
+
+pub const max_threads = 16;
+
+fn halfSize(size: u32) u32 {
+    return std.math.max(1, size / 2);
+}
+
+/// downsamples `src` into `dst`, which holds max(1, width / 2) * max(1, height / 2) texels
+pub fn downsample(filter: Filter, src: []const u32, width: u32, height: u32, dst: []u32) void {
+    std.debug.assert(src.len >= width * height and dst.len >= halfSize(width) * halfSize(height));
+    downsampleRows(filter, src, width, height, dst, 0, halfSize(height));
+}
+
+/// like `downsample` but the rows of `dst` are split across `num_threads` threads, the calling thread included
+pub fn downsampleParallel(filter: Filter, src: []const u32, width: u32, height: u32, dst: []u32, num_threads: usize) void {
+    const dst_height = halfSize(height);
+    const num_bands = std.math.min(std.math.min(num_threads, max_threads), dst_height);
+    if (std.builtin.single_threaded or num_bands <= 1) return downsample(filter, src, width, height, dst);
+
+    var bands: [max_threads]Band = undefined;
+    var threads = [_]?*std.Thread{null} ** max_threads;
+    for (bands[0..num_bands]) |*band, i| {
+        band.* = .{
+            .filter = filter,
+            .src = src,
+            .width = width,
+            .height = height,
+            .dst = dst,
+            .first_row = @intCast(u32, dst_height * i / num_bands),
+            .end_row = @intCast(u32, dst_height * (i + 1) / num_bands),
+        };
+        if (i > 0) threads[i] = std.Thread.spawn(@as(*const Band, band), Band.run) catch null;
+    }
+
+    // the calling thread takes the first band and any band that didn't get a thread
+    for (bands[0..num_bands]) |*band, i| {
+        if (threads[i] == null) band.run();
+    }
+    for (threads[0..num_bands]) |thread| {
+        if (thread) |t| t.wait();
+    }
+}
+
+const Band = struct {
+    filter: Filter,
+    src: []const u32,
+    width: u32,
+    height: u32,
+    dst: []u32,
+    first_row: u32,
+    end_row: u32,
+
+    fn run(self: *const Band) void {
+        downsampleRows(self.filter, self.src, self.width, self.height, self.dst, self.first_row, self.end_row);
+    }
+};
+
+fn downsampleRows(filter: Filter, src: []const u32, width: u32, height: u32, dst: []u32, first_row: u32, end_row: u32) void {
+    switch (filter) {
+        .box => boxRows(src, width, height, dst, first_row, end_row),
+        .kaiser => kaiserRows(src, width, height, dst, first_row, end_row),
+    }
+}
+
+/// every level of an rgba8 image. Level 0 references the source pixels, the rest share one allocation.
+pub const MipChain = struct {
+    pub const max_levels = 16;
+
+    allocator: *std.mem.Allocator,
+    pixels: []u32,
+    levels: [max_levels][]const u32 = undefined,
+    num_levels: u32,
+
+    pub fn init(allocator: *std.mem.Allocator, src: []const u32, width: u32, height: u32, filter: Filter, num_threads: usize) MipChain {
+        const num_levels = @intCast(u32, renderkit.mipCount(@intCast(i32, width), @intCast(i32, height)));
+        std.debug.assert(num_levels <= max_levels);
+
+        var total: usize = 0;
+        var level: u32 = 1;
+        while (level < num_levels) : (level += 1) total += levelWidth(width, level) * levelWidth(height, level);
+
+        var self = MipChain{
+            .allocator = allocator,
+            .pixels = allocator.alloc(u32, total) catch unreachable,
+            .num_levels = num_levels,
+        };
+        self.levels[0] = src[0 .. width * height];
+
+        var offset: usize = 0;
+        level = 1;
+        while (level < num_levels) : (level += 1) {
+            const w = levelWidth(width, level - 1);
+            const h = levelWidth(height, level - 1);
+            const dst = self.pixels[offset .. offset + halfSize(w) * halfSize(h)];
+            downsampleParallel(filter, self.levels[level - 1], w, h, dst, num_threads);
+            self.levels[level] = dst;
+            offset += dst.len;
+        }
+
+        return self;
+    }
+
+    pub fn deinit(self: MipChain) void {
+        self.allocator.free(self.pixels);
+    }
+
+    fn levelWidth(size: u32, level: u32) u32 {
+        return @intCast(u32, renderkit.mipSize(@intCast(i32, size), @intCast(i32, level)));
+    }
+};
+
+// box filter. The four channels are averaged in two u32s holding 16 bit lanes (r|b and g|a), which leaves room for the
+// sum of four bytes plus rounding. The same code runs on single texels and on vectors of four.
+const Vec4 = @Vector(4, u32);
+
+fn splat(comptime T: type, value: u32) T {
+    return if (T == u32) value else @splat(4, value);
+}
+
+fn shiftBy(comptime T: type, comptime bits: u5) if (T == u32) u5 else @Vector(4, u5) {
+    return if (T == u32) bits else @splat(4, bits);
+}
+
+fn average4(comptime T: type, a: T, b: T, c: T, d: T) T {
+    const mask = splat(T, 0x00FF00FF);
+    const round = splat(T, 0x00020002);
+    const two = shiftBy(T, 2);
+    const eight = shiftBy(T, 8);
+
+    const lo = (a & mask) + (b & mask) + (c & mask) + (d & mask) + round;
+    const hi = ((a >> eight) & mask) + ((b >> eight) & mask) + ((c >> eight) & mask) + ((d >> eight) & mask) + round;
+    return ((lo >> two) & mask) | (((hi >> two) & mask) << eight);
+}
+
+fn boxRows(src: []const u32, width: u32, height: u32, dst: []u32, first_row: u32, end_row: u32) void {
+    const dst_width = halfSize(width);
+    const even = [4]i32{ 0, 2, 4, 6 };
+    const odd = [4]i32{ 1, 3, 5, 7 };
+
+    var y = first_row;
+    while (y < end_row) : (y += 1) {
+        const top = src[std.math.min(2 * y, height - 1) * width ..][0..width];
+        const bottom = src[std.math.min(2 * y + 1, height - 1) * width ..][0..width];
+        const out = dst[y * dst_width ..][0..dst_width];
+
+        // eight texels of both rows become four
+        var x: u32 = 0;
+        while (x + 4 <= dst_width) : (x += 4) {
+            const t: @Vector(8, u32) = top[2 * x ..][0..8].*;
+            const b: @Vector(8, u32) = bottom[2 * x ..][0..8].*;
+            out[x..][0..4].* = average4(
+                Vec4,
+                @shuffle(u32, t, undefined, even),
+                @shuffle(u32, t, undefined, odd),
+                @shuffle(u32, b, undefined, even),
+                @shuffle(u32, b, undefined, odd),
+            );
+        }
+
+        while (x < dst_width) : (x += 1) {
+            const x0 = std.math.min(2 * x, width - 1);
+            const x1 = std.math.min(2 * x + 1, width - 1);
+            out[x] = average4(u32, top[x0], top[x1], bottom[x0], bottom[x1]);
+        }
+    }
+}
+
+// kaiser filter. The six taps sit at -2.5 to 2.5 texels from the center between the two source texels that collapse
+// into one, texels past the edges are clamped.
+const kaiser_taps = 6;
+const kaiser_weights = comptime kaiserWeights(4.0);
+const Texel = @Vector(4, f32);
+
+fn kaiserWeights(beta: f64) [kaiser_taps]f32 {
+    @setEvalBranchQuota(10000);
+    var weights: [kaiser_taps]f64 = undefined;
+    var sum: f64 = 0;
+    for (weights) |*weight, i| {
+        const d = @intToFloat(f64, i) - 2.5;
+        const x = std.math.pi * d / 2;
+        const r = d / 3;
+        weight.* = std.math.sin(x) / x * besselI0(beta * std.math.sqrt(1 - r * r)) / besselI0(beta);
+        sum += weight.*;
+    }
+
+    var normalized: [kaiser_taps]f32 = undefined;
+    for (weights) |weight, i| normalized[i] = @floatCast(f32, weight / sum);
+    return normalized;
+}
+
+/// power series of the modified Bessel function of the first kind, converges quickly for the small arguments used here
+fn besselI0(x: f64) f64 {
+    var sum: f64 = 1;
+    var term: f64 = 1;
+    var k: f64 = 1;
+    while (k < 20) : (k += 1) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+fn unpack(texel: u32) Texel {
+    return .{
+        @intToFloat(f32, texel & 0xFF),
+        @intToFloat(f32, (texel >> 8) & 0xFF),
+        @intToFloat(f32, (texel >> 16) & 0xFF),
+        @intToFloat(f32, texel >> 24),
+    };
+}
+
+fn pack(texel: Texel) u32 {
+    const channels: [4]f32 = texel;
+    var result: u32 = 0;
+    for (channels) |channel, i| {
+        const value = @floatToInt(u32, std.math.clamp(channel + 0.5, 0, 255));
+        result |= value << @intCast(u5, i * 8);
+    }
+    return result;
+}
+
+fn clampedIndex(position: i64, size: u32) u32 {
+    return @intCast(u32, std.math.clamp(position, 0, @as(i64, size) - 1));
+}
+
+fn kaiserRows(src: []const u32, width: u32, height: u32, dst: []u32, first_row: u32, end_row: u32) void {
+    const dst_width = halfSize(width);
+
+    var y = first_row;
+    while (y < end_row) : (y += 1) {
+        var x: u32 = 0;
+        while (x < dst_width) : (x += 1) {
+            var sum = @splat(4, @as(f32, 0));
+            for (kaiser_weights) |weight_y, j| {
+                const row = src[clampedIndex(@intCast(i64, 2 * y + j) - 2, height) * width ..][0..width];
+                var row_sum = @splat(4, @as(f32, 0));
+                for (kaiser_weights) |weight_x, i| {
+                    row_sum += unpack(row[clampedIndex(@intCast(i64, 2 * x + i) - 2, width)]) * @splat(4, weight_x);
+                }
+                sum += row_sum * @splat(4, weight_y);
+            }
+            dst[y * dst_width + x] = pack(sum);
+        }
+    }
+}
+
+/// byte by byte 2x2 average, the reference the vectorised box filter is checked against
+fn boxReference(src: []const u32, width: u32, height: u32, dst: []u32) void {
+    const dst_width = halfSize(width);
+    var y: u32 = 0;
+    while (y < halfSize(height)) : (y += 1) {
+        var x: u32 = 0;
+        while (x < dst_width) : (x += 1) {
+            const ys = [2]u32{ std.math.min(2 * y, height - 1), std.math.min(2 * y + 1, height - 1) };
+            const xs = [2]u32{ std.math.min(2 * x, width - 1), std.math.min(2 * x + 1, width - 1) };
+            var result: u32 = 0;
+            var shift: u5 = 0;
+            while (true) : (shift += 8) {
+                var sum: u32 = 2;
+                for (ys) |sy| {
+                    for (xs) |sx| sum += (src[sy * width + sx] >> shift) & 0xFF;
+                }
+                result |= (sum / 4) << shift;
+                if (shift == 24) break;
+            }
+            dst[y * dst_width + x] = result;
+        }
+    }
+}
+
+test "box filter matches the reference" {
+    var rng = std.rand.DefaultPrng.init(7);
+    var src: [37 * 23]u32 = undefined;
+    for (src) |*texel| texel.* = rng.random.int(u32);
+
+    var expected: [18 * 11]u32 = undefined;
+    var actual: [18 * 11]u32 = undefined;
+    boxReference(&src, 37, 23, &expected);
+    downsample(.box, &src, 37, 23, &actual);
+    std.testing.expectEqualSlices(u32, &expected, &actual);
+
+    std.mem.set(u32, &actual, 0);
+    downsampleParallel(.box, &src, 37, 23, &actual, 4);
+    std.testing.expectEqualSlices(u32, &expected, &actual);
+
+    // a single column
+    var column: [4]u32 = undefined;
+    downsample(.box, src[0..9], 1, 9, &column);
+    std.testing.expectEqual(average4(u32, src[0], src[0], src[1], src[1]), column[0]);
+}
+
+test "kaiser filter keeps flat color" {
+    const color: u32 = 0x80FF4010;
+    var src = [_]u32{color} ** (16 * 8);
+    var dst: [8 * 4]u32 = undefined;
+    downsampleParallel(.kaiser, &src, 16, 8, &dst, 2);
+    for (dst) |texel| std.testing.expectEqual(color, texel);
+}
+
+test "mip chain" {
+    var src = [_]u32{0xFFFFFFFF} ** (5 * 3);
+    const chain = MipChain.init(std.testing.allocator, &src, 5, 3, .box, 1);
+    defer chain.deinit();
+
+    std.testing.expectEqual(@as(u32, 3), chain.num_levels);
+    std.testing.expectEqual(@as(usize, 2), chain.levels[1].len);
+    std.testing.expectEqual(@as(usize, 1), chain.levels[2].len);
+    std.testing.expectEqual(@as(u32, 0xFFFFFFFF), chain.levels[2][0]);
+}
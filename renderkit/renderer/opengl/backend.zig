@@ -6,44 +6,116 @@ usingnamespace @import("../types.zig");
 
 const HandledCache = @import("../handles.zig").HandledCache;
 const RenderCache = @import("render_cache.zig").RenderCache;
-
+const ReleaseQueue = @import("release_queue.zig").ReleaseQueue;
+const VertexArrayCache = @import("vao_cache.zig").VertexArrayCache;
+const Features = @import("gl_features.zig").Features;
+const UniformRing = @import("uniform_ring.zig").UniformRing;
+const std140 = @import("std140.zig");
+const FrameFences = @import("frame_fences.zig").FrameFences;
+const UniformTable = @import("uniform_table.zig").UniformTable;
+const PixelUnpackRing = @import("pixel_unpack_ring.zig").PixelUnpackRing;
+const SamplerCache = @import("sampler_cache.zig").SamplerCache;
+const ProgramCache = @import("program_cache.zig").ProgramCache;
+const BaseShift = @import("base_shift.zig").BaseShift;
+
+var features: Features = .{};
 var cache = RenderCache.init();
-var pip_cache: RenderState = undefined;
-var vao: GLuint = undefined;
-var cur_bindings: BufferBindings = undefined;
+var vao_cache = VertexArrayCache.init();
+// bound whenever an index buffer is created so the element buffer binding of a cached VAO is never clobbered
+var upload_vao: GLuint = undefined;
+var cur_bindings = std.mem.zeroes(BufferBindings);
+// the bindings from applyBindings, which differ from `cur_bindings` after drawShifted
+var base_shift = BaseShift{};
 
 var image_cache: HandledCache(GLImage) = undefined;
 var pass_cache: HandledCache(GLPass) = undefined;
 var buffer_cache: HandledCache(GLBuffer) = undefined;
 var shader_cache: HandledCache(GLShaderProgram) = undefined;
+var pipeline_cache: HandledCache(GLPipeline) = undefined;
+// the pipeline whose shader and render state are current, 0 after anything else changed them
+var cur_pipeline: u32 = 0;
+var release_queue: ReleaseQueue = undefined;
+var frame_fences = FrameFences{};
+var unpack_ring = PixelUnpackRing{};
+// only used with sampler objects, see applyBindings for the fallback
+var sampler_cache: SamplerCache = undefined;
+// null unless RendererDesc.shader_cache_dir is set and the driver supports program binaries
+var program_cache: ?ProgramCache = null;
+var shader_stats = ShaderCacheStats{};
+// programs from createShaderPrograms still building in the background, polled in commitFrame
+var pending_programs: std.ArrayList(ShaderProgram) = undefined;
+// draws recorded between beginDrawBatch and endDrawBatch, see submitDrawBatch
+var draw_batch = DrawBatch{};
+// shadows GL_UNPACK_ALIGNMENT, 0 when unknown
+var unpack_alignment: GLint = 4;
+// growable buffers that overflowed this frame, reallocated in commitFrame
+var pending_grows: std.ArrayList(Buffer) = undefined;
 
 var frame_index: u32 = 1;
+var allocator: *std.mem.Allocator = undefined;
 
 // setup
 pub fn setup(desc: RendererDesc) void {
+    allocator = desc.allocator;
     image_cache = HandledCache(GLImage).init(desc.allocator, desc.pool_sizes.texture);
     pass_cache = HandledCache(GLPass).init(desc.allocator, desc.pool_sizes.offscreen_pass);
     buffer_cache = HandledCache(GLBuffer).init(desc.allocator, desc.pool_sizes.buffers);
     shader_cache = HandledCache(GLShaderProgram).init(desc.allocator, desc.pool_sizes.shaders);
+    pipeline_cache = HandledCache(GLPipeline).init(desc.allocator, desc.pool_sizes.shaders);
+    release_queue = ReleaseQueue.init(desc.allocator);
+    pending_grows = std.ArrayList(Buffer).init(desc.allocator);
+    pending_programs = std.ArrayList(ShaderProgram).init(desc.allocator);
+    draw_batch.commands = std.ArrayList(DrawElementsIndirectCommand).init(desc.allocator);
 
     if (desc.gl_loader) |loader| {
         loadFunctions(loader);
     } else {
         loadFunctionsZig();
     }
+    features = Features.detect();
 
     setRenderState(.{});
 
-    glGenVertexArrays(1, &vao);
-    cache.bindVertexArray(vao);
+    glGenVertexArrays(1, &upload_vao);
+    cache.bindVertexArray(upload_vao, 0);
+
+    if (features.uniform_buffer) uniform_ring = UniformRing.init();
+    if (features.sampler_objects) sampler_cache = SamplerCache.init(desc.allocator, features.max_anisotropy);
+    if (desc.shader_cache_dir) |dir| {
+        if (features.program_binary) program_cache = ProgramCache.init(desc.allocator, std.mem.spanZ(dir));
+    }
+    // let the driver use as many compiler threads as it likes
+    if (features.parallel_shader_compile) {
+        if (hasFunction("glMaxShaderCompilerThreadsKHR")) {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        } else if (hasFunction("glMaxShaderCompilerThreadsARB")) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        }
+    }
 }
 
 pub fn shutdown() void {
     // TODO: destroy the items in the caches as well
+    vao_cache.clear(releaseVertexArray);
+    release_queue.push(.vertex_array, upload_vao, frame_index);
+    if (features.fence_sync) frame_fences.deinit();
+    if (features.uniform_buffer) release_queue.push(.buffer, uniform_ring.buffer, frame_index);
+    release_queue.push(.buffer, unpack_ring.buffer, frame_index);
+    if (draw_batch.indirect_buffer != 0) release_queue.push(.buffer, draw_batch.indirect_buffer, frame_index);
+    if (features.sampler_objects) sampler_cache.deinit();
+    if (program_cache) |*programs| programs.deinit();
+    if (frame_block.bytes) |bytes| allocator.free(bytes);
+    if (frame_values) |bytes| allocator.free(bytes);
+    release_queue.collectAll();
+    release_queue.deinit();
+    pending_grows.deinit();
+    pending_programs.deinit();
+    draw_batch.commands.deinit();
     image_cache.deinit();
     pass_cache.deinit();
     buffer_cache.deinit();
     shader_cache.deinit();
+    pipeline_cache.deinit();
 }
 
 fn checkError(src: std.builtin.SourceLocation) void {
@@ -103,104 +175,48 @@ fn checkProgramError(shader: GLuint) bool {
 
 // render state
 pub fn setRenderState(state: RenderState) void {
-    // depth
-    if (state.depth.enabled != pip_cache.depth.enabled) {
-        glDepthMask(if (state.depth.enabled) 1 else 0);
-        pip_cache.depth.enabled = state.depth.enabled;
-    }
-
-    if (state.depth.compare_func != pip_cache.depth.compare_func) {
-        glDepthFunc(translations.compareFuncToGl(state.depth.compare_func));
-        pip_cache.depth.compare_func = state.depth.compare_func;
-    }
-
-    // stencil
-    if (state.stencil.enabled != pip_cache.stencil.enabled) {
-        if (state.stencil.enabled) glEnable(GL_STENCIL_TEST) else glDisable(GL_STENCIL_TEST);
-        pip_cache.stencil.enabled = state.stencil.enabled;
-    }
-
-    if (state.stencil.write_mask != pip_cache.stencil.write_mask) {
-        glStencilMask(@intCast(GLuint, state.stencil.write_mask));
-        pip_cache.stencil = state.stencil;
-        pip_cache.stencil.write_mask = state.stencil.write_mask;
-    }
-
-    if (state.stencil.compare_func != pip_cache.stencil.compare_func or
-        state.stencil.read_mask != pip_cache.stencil.read_mask or
-        state.stencil.ref != pip_cache.stencil.ref)
-    {
-        glStencilFuncSeparate(GL_FRONT, translations.compareFuncToGl(state.stencil.compare_func), @intCast(GLint, state.stencil.ref), @intCast(GLuint, state.stencil.read_mask));
-        pip_cache.stencil.compare_func = state.stencil.compare_func;
-        pip_cache.stencil.read_mask = state.stencil.read_mask;
-        pip_cache.stencil.ref = state.stencil.ref;
-    }
-
-    if (state.stencil.fail_op != pip_cache.stencil.fail_op or
-        state.stencil.depth_fail_op != pip_cache.stencil.depth_fail_op or
-        state.stencil.pass_op != pip_cache.stencil.pass_op)
-    {
-        glStencilOpSeparate(GL_FRONT, translations.stencilOpToGl(state.stencil.fail_op), translations.stencilOpToGl(state.stencil.depth_fail_op), translations.stencilOpToGl(state.stencil.pass_op));
-        pip_cache.stencil.fail_op = state.stencil.fail_op;
-        pip_cache.stencil.depth_fail_op = state.stencil.depth_fail_op;
-        pip_cache.stencil.pass_op = state.stencil.pass_op;
-    }
-
-    // blend
-    if (state.blend.enabled != pip_cache.blend.enabled) {
-        if (state.blend.enabled) glEnable(GL_BLEND) else glDisable(GL_BLEND);
-        pip_cache.blend.enabled = state.blend.enabled;
-    }
+    flushDrawBatch();
+    cur_pipeline = 0;
+    cache.setRenderState(state);
+}
 
-    if (state.blend.src_factor_rgb != pip_cache.blend.src_factor_rgb or
-        state.blend.dst_factor_rgb != pip_cache.blend.dst_factor_rgb or
-        state.blend.src_factor_alpha != pip_cache.blend.src_factor_alpha or
-        state.blend.dst_factor_alpha != pip_cache.blend.dst_factor_alpha)
-    {
-        glBlendFuncSeparate(translations.blendFactorToGl(state.blend.src_factor_rgb), translations.blendFactorToGl(state.blend.dst_factor_rgb), translations.blendFactorToGl(state.blend.src_factor_alpha), translations.blendFactorToGl(state.blend.dst_factor_alpha));
-        pip_cache.blend.src_factor_rgb = state.blend.src_factor_rgb;
-        pip_cache.blend.dst_factor_rgb = state.blend.dst_factor_rgb;
-        pip_cache.blend.src_factor_alpha = state.blend.src_factor_alpha;
-        pip_cache.blend.dst_factor_alpha = state.blend.dst_factor_alpha;
-    }
+pub fn resetStateCache() void {
+    flushDrawBatch();
+    cache.reset();
+    cur_pipeline = 0;
+    cur_bindings = std.mem.zeroes(BufferBindings);
+    unpack_alignment = 0;
 
-    if (state.blend.op_rgb != pip_cache.blend.op_rgb or state.blend.op_alpha != pip_cache.blend.op_alpha) {
-        glBlendEquationSeparate(translations.blendOpToGl(state.blend.op_rgb), translations.blendOpToGl(state.blend.op_alpha));
-        pip_cache.blend.op_rgb = state.blend.op_rgb;
-        pip_cache.blend.op_alpha = state.blend.op_alpha;
-    }
+    // outside code may have set uniforms of our programs too
+    var programs = shader_cache.iterator();
+    while (programs.next()) |shdr| shdr.uniforms.resetShadows();
+}
 
-    if (state.blend.color_write_mask != pip_cache.blend.color_write_mask) {
-        const r = (@enumToInt(state.blend.color_write_mask) & @enumToInt(ColorMask.r)) != 0;
-        const g = (@enumToInt(state.blend.color_write_mask) & @enumToInt(ColorMask.g)) != 0;
-        const b = (@enumToInt(state.blend.color_write_mask) & @enumToInt(ColorMask.b)) != 0;
-        const a = (@enumToInt(state.blend.color_write_mask) & @enumToInt(ColorMask.a)) != 0;
-        glColorMask(if (r) 1 else 0, if (g) 1 else 0, if (b) 1 else 0, if (a) 1 else 0);
-        pip_cache.blend.color_write_mask = state.blend.color_write_mask;
-    }
+pub fn getVertexArrayCacheStats() VertexArrayCacheStats {
+    return vao_cache.stats;
+}
 
-    if (std.math.approxEq(f32, state.blend.color[0], pip_cache.blend.color[0], 0.0001) or
-        std.math.approxEq(f32, state.blend.color[1], pip_cache.blend.color[1], 0.0001) or
-        std.math.approxEq(f32, state.blend.color[2], pip_cache.blend.color[2], 0.0001) or
-        std.math.approxEq(f32, state.blend.color[3], pip_cache.blend.color[3], 0.0001))
-    {
-        glBlendColor(state.blend.color[0], state.blend.color[1], state.blend.color[2], state.blend.color[3]);
-        pip_cache.blend.color = state.blend.color;
-    }
+pub fn getShaderCacheStats() ShaderCacheStats {
+    return shader_stats;
+}
 
-    // scissor
-    if (state.scissor != pip_cache.scissor) {
-        if (state.scissor) glEnable(GL_SCISSOR_TEST) else glDisable(GL_SCISSOR_TEST);
-        pip_cache.scissor = state.scissor;
+fn releaseVertexArray(vao: GLuint) void {
+    // never leave a VAO that is going away bound
+    if (cache.vao == vao) {
+        cache.bindVertexArray(upload_vao, 0);
+        cur_bindings = std.mem.zeroes(BufferBindings);
     }
+    release_queue.push(.vertex_array, vao, frame_index);
 }
 
 pub fn viewport(x: c_int, y: c_int, width: c_int, height: c_int) void {
-    glViewport(x, y, width, height);
+    flushDrawBatch();
+    cache.setViewport(x, y, width, height);
 }
 
 pub fn scissor(x: c_int, y: c_int, width: c_int, height: c_int) void {
-    glScissor(x, y, width, height);
+    flushDrawBatch();
+    cache.setScissor(x, y, width, height);
 }
 
 // images
@@ -208,66 +224,248 @@ const GLImage = struct {
     tid: GLuint,
     width: i32,
     height: i32,
+    num_mipmaps: i32,
+    format: PixelFormat,
     depth: bool,
     stencil: bool,
+    sampler: SamplerDesc,
+    /// key of the sampler parameters currently set on the texture
+    applied: u32,
 };
 
 pub fn createImage(desc: ImageDesc) Image {
+    flushDrawBatch();
     var img = std.mem.zeroes(GLImage);
     img.width = desc.width;
     img.height = desc.height;
+    img.num_mipmaps = desc.num_mipmaps;
+    img.format = desc.pixel_format;
+    img.sampler = desc.sampler();
+    img.applied = img.sampler.key();
 
     if (desc.pixel_format == .depth_stencil) {
         std.debug.assert(desc.usage == .immutable);
-        glGenRenderbuffers(1, &img.tid);
-        glBindRenderbuffer(GL_RENDERBUFFER, img.tid);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, desc.width, desc.height);
+        img.tid = createRenderbuffer(GL_DEPTH24_STENCIL8_OES, desc.width, desc.height);
         img.depth = true;
         img.stencil = true;
     } else if (desc.pixel_format == .stencil) {
         std.debug.assert(desc.usage == .immutable);
-        glGenRenderbuffers(1, &img.tid);
-        glBindRenderbuffer(GL_RENDERBUFFER, img.tid);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, desc.width, desc.height);
+        img.tid = createRenderbuffer(GL_STENCIL_INDEX8, desc.width, desc.height);
         img.stencil = true;
+    } else if (features.direct_state_access) {
+        std.debug.assert(isPixelFormatSupported(desc.pixel_format));
+        // immutable storage for every level at once, nothing gets bound
+        glCreateTextures(GL_TEXTURE_2D, 1, &img.tid);
+        glTextureStorage2D(img.tid, desc.num_mipmaps, translations.sizedInternalFormat(desc.pixel_format), desc.width, desc.height);
+        setTextureParams(img.tid, img.sampler);
+        glTextureParameteri(img.tid, GL_TEXTURE_MAX_LEVEL, desc.num_mipmaps - 1);
+        if (desc.content != null) texSubImage(img.tid, desc.pixel_format, 0, 0, 0, desc.width, desc.height, 0, desc.content);
     } else {
+        std.debug.assert(isPixelFormatSupported(desc.pixel_format));
         glGenTextures(1, &img.tid);
-        glBindTexture(GL_TEXTURE_2D, img.tid);
-
-        const wrap_u: GLint = if (desc.wrap_u == .clamp) GL_CLAMP_TO_EDGE else GL_REPEAT;
-        const wrap_v: GLint = if (desc.wrap_v == .clamp) GL_CLAMP_TO_EDGE else GL_REPEAT;
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_u);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_v);
+        bindForUpdate(img.tid);
 
-        const filter_min: GLint = if (desc.min_filter == .nearest) GL_NEAREST else GL_LINEAR;
-        const filter_mag: GLint = if (desc.mag_filter == .nearest) GL_NEAREST else GL_LINEAR;
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mag);
+        setTextureParams(img.tid, img.sampler);
+        // without it a texture missing the levels GL expects down to 1x1 is incomplete once mipmaps are sampled
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, desc.num_mipmaps - 1);
 
-        if (desc.content) |content| {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, content);
-        } else {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, null);
+        var level: i32 = 0;
+        while (level < desc.num_mipmaps) : (level += 1) {
+            const content = if (level == 0) desc.content else null;
+            texImage(desc.pixel_format, level, mipSize(desc.width, level), mipSize(desc.height, level), content);
         }
-
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
 
     return image_cache.append(img);
 }
 
+/// sets the sampling parameters of texture `tid`. Without direct state access it has to be bound to the active unit.
+fn setTextureParams(tid: GLuint, sampler: SamplerDesc) void {
+    texParameteri(tid, GL_TEXTURE_WRAP_S, translations.wrapToGl(sampler.wrap_u));
+    texParameteri(tid, GL_TEXTURE_WRAP_T, translations.wrapToGl(sampler.wrap_v));
+    texParameteri(tid, GL_TEXTURE_MIN_FILTER, translations.minFilterToGl(sampler.min_filter, sampler.mip_filter));
+    texParameteri(tid, GL_TEXTURE_MAG_FILTER, translations.magFilterToGl(sampler.mag_filter));
+    if (features.anisotropy) {
+        const anisotropy = std.math.clamp(sampler.max_anisotropy, 1, features.max_anisotropy);
+        texParameteri(tid, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+    }
+}
+
+fn texParameteri(tid: GLuint, pname: GLenum, value: GLint) void {
+    if (features.direct_state_access) {
+        glTextureParameteri(tid, pname, value);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, pname, value);
+    }
+}
+
+fn createRenderbuffer(format: GLenum, width: i32, height: i32) GLuint {
+    var renderbuffer: GLuint = 0;
+    if (features.direct_state_access) {
+        glCreateRenderbuffers(1, &renderbuffer);
+        glNamedRenderbufferStorage(renderbuffer, format, width, height);
+    } else {
+        glGenRenderbuffers(1, &renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
+    }
+    return renderbuffer;
+}
+
 pub fn destroyImage(image: Image) void {
+    flushDrawBatch();
     var img = image_cache.free(image);
-    cache.invalidateTexture(img.tid);
-    glDeleteTextures(1, &img.tid);
+    if (img.depth or img.stencil) {
+        release_queue.push(.renderbuffer, img.tid, frame_index);
+    } else {
+        cache.invalidateTexture(img.tid);
+        release_queue.push(.texture, img.tid, frame_index);
+    }
 }
 
 pub fn updateImage(comptime T: type, image: Image, content: []const T) void {
+    flushDrawBatch();
+    var img = image_cache.get(image);
+
+    // createImage allocated the storage so only the texels are replaced
+    texSubImage(img.tid, img.format, 0, 0, 0, img.width, img.height, 0, content.ptr);
+}
+
+/// `row_pitch` is the number of bytes between rows of `content`, 0 if they are tightly packed
+pub fn updateImageRegion(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) void {
+    flushDrawBatch();
     var img = image_cache.get(image);
+    std.debug.assert(x >= 0 and y >= 0 and x + width <= img.width and y + height <= img.height);
 
-    glBindTexture(GL_TEXTURE_2D, img.tid);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img.width, img.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, content.ptr);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    texSubImage(img.tid, img.format, 0, x, y, width, height, row_pitch, content.ptr);
+}
+
+/// stages `content` in the pixel unpack ring and uploads it from there, so the call returns without waiting for the
+/// transfer. `content` can be reused right away. The returned token completes once the GPU consumed the staged copy.
+pub fn updateImageRegionAsync(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) UploadToken {
+    flushDrawBatch();
+    var img = image_cache.get(image);
+    std.debug.assert(x >= 0 and y >= 0 and x + width <= img.width and y + height <= img.height);
+
+    const num_bytes = if (img.format.isCompressed() or row_pitch == 0)
+        img.format.imageSize(width, height)
+    else
+        row_pitch * @intCast(u32, height - 1) + img.format.rowPitch(width);
+    const bytes = std.mem.sliceAsBytes(content);
+    std.debug.assert(bytes.len >= num_bytes);
+
+    const offset = unpack_ring.upload(bytes[0..num_bytes], frame_index, features.buffer_storage, releaseBuffer);
+    texSubImage(img.tid, img.format, 0, x, y, width, height, row_pitch, @intToPtr(?*const c_void, offset));
+    // a bound unpack buffer would turn the pointers of every later texture upload into offsets
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return .{ .frame = frame_index };
+}
+
+/// polls the fence of the frame the upload was issued in. Without fences it falls back to assuming the GPU is done
+/// once the frame is `FrameFences.num_regions` frames old, which is only an estimate.
+pub fn isUploadComplete(token: UploadToken) bool {
+    if (features.fence_sync) return frame_fences.isComplete(token.frame);
+    return frame_index - token.frame >= FrameFences.num_regions;
+}
+
+/// replaces mip level `level`. `row_pitch` is the number of bytes between rows of `content`, 0 if they are tightly
+/// packed. Compressed levels are always tightly packed.
+pub fn updateImageLevel(comptime T: type, image: Image, level: i32, row_pitch: u32, content: []const T) void {
+    flushDrawBatch();
+    var img = image_cache.get(image);
+    std.debug.assert(level >= 0 and level < img.num_mipmaps);
+
+    texSubImage(img.tid, img.format, level, 0, 0, mipSize(img.width, level), mipSize(img.height, level), row_pitch, content.ptr);
+}
+
+pub fn generateMipmaps(image: Image) void {
+    flushDrawBatch();
+    var img = image_cache.get(image);
+    std.debug.assert(!img.format.isCompressed());
+
+    if (features.direct_state_access) {
+        glGenerateTextureMipmap(img.tid);
+    } else {
+        bindForUpdate(img.tid);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+pub fn isPixelFormatSupported(format: PixelFormat) bool {
+    return switch (format) {
+        .r8, .rg8 => features.texture_rg,
+        .rgb565 => features.rgb565,
+        .bc1, .bc3 => features.s3tc,
+        .bc7 => features.bptc,
+        .etc2_rgb8, .etc2_rgba8 => features.etc2,
+        .astc_4x4 => features.astc,
+        .rgba8, .stencil, .depth_stencil => true,
+    };
+}
+
+/// allocates mip level `level` of the texture bound to unit 0, filling it with tightly packed `content` if there is any
+fn texImage(format: PixelFormat, level: i32, width: i32, height: i32, content: ?*const c_void) void {
+    const gl_format = translations.pixelFormatToGl(format);
+    if (format.isCompressed()) {
+        const image_size = @intCast(GLsizei, format.imageSize(width, height));
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, gl_format.internal_format, width, height, 0, image_size, content);
+    } else {
+        setUnpackAlignment(format.rowPitch(width));
+        glTexImage2D(GL_TEXTURE_2D, level, @intCast(GLint, gl_format.internal_format), width, height, 0, gl_format.format, gl_format.kind, content);
+    }
+}
+
+/// binds `tid` to unit 0 and makes unit 0 active so texture calls without a unit reach it. bindImage alone skips both
+/// when the texture is already in unit 0, leaving whichever unit applyBindings touched last active.
+fn bindForUpdate(tid: GLuint) void {
+    cache.setActiveTexture(GL_TEXTURE0);
+    cache.bindImage(tid, 0);
+}
+
+/// sub image upload to texture `tid`, which is bound to unit 0 unless direct state access is available. Compressed
+/// regions have to be aligned to blocks.
+fn texSubImage(tid: GLuint, format: PixelFormat, level: i32, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, pixels: ?*const c_void) void {
+    const dsa = features.direct_state_access;
+    if (!dsa) bindForUpdate(tid);
+
+    const gl_format = translations.pixelFormatToGl(format);
+    if (format.isCompressed()) {
+        std.debug.assert(row_pitch == 0 or row_pitch == format.rowPitch(width));
+        const image_size = @intCast(GLsizei, format.imageSize(width, height));
+        if (dsa) {
+            glCompressedTextureSubImage2D(tid, level, x, y, width, height, gl_format.internal_format, image_size, pixels);
+        } else {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, gl_format.internal_format, image_size, pixels);
+        }
+        return;
+    }
+
+    const bytes_per_texel = format.bytesPerBlock();
+    std.debug.assert(row_pitch % bytes_per_texel == 0);
+    const row_length = @intCast(GLint, row_pitch / bytes_per_texel);
+
+    setUnpackAlignment(if (row_pitch == 0) format.rowPitch(width) else row_pitch);
+    if (row_length != 0) glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, row_length);
+    if (dsa) {
+        glTextureSubImage2D(tid, level, x, y, width, height, gl_format.format, gl_format.kind, pixels);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, gl_format.format, gl_format.kind, pixels);
+    }
+    if (row_length != 0) glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+}
+
+/// GL assumes rows start at multiples of GL_UNPACK_ALIGNMENT, 4 by default, and would skip bytes at the end of odd
+/// width r8, rg8 and rgb565 rows. The largest alignment the row pitch allows is used.
+fn setUnpackAlignment(row_pitch: u32) void {
+    const alignment: GLint = if (row_pitch % 8 == 0) 8 else if (row_pitch % 4 == 0) 4 else if (row_pitch % 2 == 0) 2 else 1;
+    if (alignment == unpack_alignment) return;
+    unpack_alignment = alignment;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+}
+
+fn releaseBuffer(buffer: GLuint) void {
+    release_queue.push(.buffer, buffer, frame_index);
 }
 
 pub fn getImageNativeId(image: Image) u32 {
@@ -282,19 +480,20 @@ const GLPass = struct {
 };
 
 pub fn createPass(desc: PassDesc) Pass {
+    flushDrawBatch();
+    if (features.direct_state_access) return createPassDsa(desc);
+
     var pass = std.mem.zeroes(GLPass);
     pass.depth_stencil_img = null;
 
-    var orig_fb: GLint = undefined;
-    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &orig_fb);
-    defer glBindFramebuffer(GL_FRAMEBUFFER, @intCast(GLuint, orig_fb));
+    const orig_fb = cache.currentFramebuffer();
+    defer cache.bindFramebuffer(orig_fb);
 
     pass.color_img = desc.color_img;
 
     // create a framebuffer object
     glGenFramebuffers(1, &pass.framebuffer_tid);
-    glBindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer_tid);
-    defer glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    cache.bindFramebuffer(pass.framebuffer_tid);
 
     // bind depth-stencil
     if (desc.depth_stencil_img) |depth_stencil_handle| {
@@ -317,13 +516,33 @@ pub fn createPass(desc: PassDesc) Pass {
     return pass_cache.append(pass);
 }
 
+/// createPass without binding the framebuffer, so the one in use stays bound
+fn createPassDsa(desc: PassDesc) Pass {
+    var pass = GLPass{ .framebuffer_tid = 0, .color_img = desc.color_img, .depth_stencil_img = desc.depth_stencil_img };
+    glCreateFramebuffers(1, &pass.framebuffer_tid);
+
+    if (desc.depth_stencil_img) |depth_stencil_handle| {
+        const depth_stencil = image_cache.get(depth_stencil_handle);
+        if (depth_stencil.depth) glNamedFramebufferRenderbuffer(pass.framebuffer_tid, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_stencil.tid);
+        if (depth_stencil.stencil) glNamedFramebufferRenderbuffer(pass.framebuffer_tid, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_stencil.tid);
+    }
+
+    const color_img = image_cache.get(desc.color_img);
+    glNamedFramebufferTexture(pass.framebuffer_tid, GL_COLOR_ATTACHMENT0, color_img.tid, 0);
+
+    const draw_buffer: GLenum = GL_COLOR_ATTACHMENT0;
+    glNamedFramebufferDrawBuffers(pass.framebuffer_tid, 1, &draw_buffer);
+
+    if (glCheckNamedFramebufferStatus(pass.framebuffer_tid, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) std.debug.print("framebuffer failed\n", .{});
+
+    return pass_cache.append(pass);
+}
+
+/// the depth-stencil renderbuffer belongs to its Image and is released by destroyImage
 pub fn destroyPass(offscreen_pass: Pass) void {
+    flushDrawBatch();
     var pass = pass_cache.free(offscreen_pass);
-    glDeleteFramebuffers(1, &pass.framebuffer_tid);
-    if (pass.depth_stencil_img) |depth_stencil_handle| {
-        var depth_stencil = image_cache.get(depth_stencil_handle);
-        glDeleteRenderbuffers(1, &depth_stencil.tid);
-    }
+    release_queue.push(.framebuffer, pass.framebuffer_tid, frame_index);
 }
 
 pub fn beginDefaultPass(action: ClearCommand, width: c_int, height: c_int) void {
@@ -335,108 +554,147 @@ pub fn beginPass(offscreen_pass: Pass, action: ClearCommand) void {
 }
 
 fn beginDefaultOrOffscreenPass(offscreen_pass: Pass, action: ClearCommand, width: c_int, height: c_int) void {
+    flushDrawBatch();
     // negative width/height means offscreen pass
     if (width < 0) {
         const pass = pass_cache.get(offscreen_pass);
         const img = image_cache.get(pass.color_img);
-        glBindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer_tid);
-        glViewport(0, 0, img.width, img.height);
+        cache.bindFramebuffer(pass.framebuffer_tid);
+        cache.setViewport(0, 0, img.width, img.height);
     } else {
-        glViewport(0, 0, width, height);
+        cache.bindFramebuffer(0);
+        cache.setViewport(0, 0, width, height);
     }
 
     var clear_mask: GLbitfield = 0;
     if (action.color_action == .clear) {
         clear_mask |= GL_COLOR_BUFFER_BIT;
-        glClearColor(action.color[0], action.color[1], action.color[2], action.color[3]);
+        cache.setClearColor(action.color);
     }
     if (action.stencil_action == .clear) {
         clear_mask |= GL_STENCIL_BUFFER_BIT;
-        glClearStencil(@intCast(GLint, action.stencil));
+        cache.setClearStencil(action.stencil);
     }
     if (action.depth_action == .clear) {
         clear_mask |= GL_DEPTH_BUFFER_BIT;
-        glClearDepth(action.depth);
+        cache.setClearDepth(action.depth);
     }
 
     glClear(clear_mask);
 }
 
 pub fn endPass() void {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    flushDrawBatch();
+    cache.bindFramebuffer(0);
 }
 
 pub fn commitFrame() void {
+    flushDrawBatch();
+    if (features.fence_sync) frame_fences.signal(frame_index);
+    growBuffers();
+    if (pending_programs.items.len > 0) pollPendingPrograms();
+    release_queue.collect(frame_index);
     frame_index += 1;
+
+    // persistently mapped stream buffers are about to be written in the region this frame uses
+    if (features.buffer_storage) frame_fences.wait(frame_index);
 }
 
 // buffers
 const GLBuffer = struct {
     vbo: GLuint,
+    kind: GLenum,
     stream: bool,
     size: u32,
     append_frame_index: u32,
     append_pos: u32,
     append_overflow: bool,
+    /// stream buffers with buffer storage are persistently mapped with a region of `size` bytes per frame
+    mapped: ?[*]u8,
+    grow: bool,
+    grow_pending: bool,
+    /// bytes appendBuffer was asked for this frame, including the ones that didn't fit
+    frame_bytes: u32,
+    /// overflow block of a growable vertex buffer. Appends that don't fit in `size` are written here and addressed by
+    /// offsets past the end of the buffer's own storage.
+    overflow_vbo: GLuint,
+    overflow_size: u32,
+    overflow_pos: u32,
+    stats: BufferStats,
+    /// where the open reserveAppend slice points, see commitAppend
+    reserved: enum { none, mapped, map_range, staging },
+    reserved_bytes: u32,
+    /// reserveAppend memory when the buffer can't be written directly, kept until the buffer is destroyed
+    staging: ?[]align(16) u8,
     index_buffer_type: GLenum,
     vert_buffer_step_func: GLuint,
+    stride: GLsizei,
     setVertexAttributes: ?fn (attr_index: *GLuint, step_func: GLuint, vertex_buffer_offset: u32) void,
+    /// vertex attrib binding path: the attribute formats for binding point `binding`. The buffer itself is attached
+    /// with glBindVertexBuffer so offset changes don't touch the formats.
+    setVertexFormat: ?fn (attr_index: *GLuint, binding: GLuint) void,
+};
+
+const VertexAttribute = struct {
+    size: GLint,
+    kind: GLenum,
+    normalized: GLboolean,
+    offset: GLuint,
 };
 
+/// GL attribute format of each field of a vertex struct. u32 fields are colors, f32 and structs of 2-4 f32 are floats.
+fn vertexAttributes(comptime T: type) [@typeInfo(T).Struct.fields.len]VertexAttribute {
+    var attrs: [@typeInfo(T).Struct.fields.len]VertexAttribute = undefined;
+    inline for (@typeInfo(T).Struct.fields) |field, i| {
+        const offset = @byteOffsetOf(T, field.name);
+        attrs[i] = switch (@typeInfo(field.field_type)) {
+            .Int => |type_info| blk: {
+                if (type_info.is_signed or type_info.bits != 32) @compileError("only u32 colors are supported: " ++ @typeName(field.field_type));
+                break :blk .{ .size = 4, .kind = GL_UNSIGNED_BYTE, .normalized = GL_TRUE, .offset = offset };
+            },
+            .Float => .{ .size = 1, .kind = GL_FLOAT, .normalized = GL_FALSE, .offset = offset },
+            .Struct => |type_info| blk: {
+                if (@typeInfo(type_info.fields[0].field_type) != .Float or @sizeOf(type_info.fields[0].field_type) != 4)
+                    @compileError("Structs of f32 must be 2/3/4 elements: " ++ @typeName(field.field_type));
+                if (type_info.fields.len < 2 or type_info.fields.len > 4)
+                    @compileError("Structs of f32 must be 2/3/4 elements: " ++ @typeName(field.field_type));
+                break :blk .{ .size = type_info.fields.len, .kind = GL_FLOAT, .normalized = GL_FALSE, .offset = offset };
+            },
+            else => @compileError("unsupported vertex field type: " ++ @typeName(field.field_type)),
+        };
+    }
+    return attrs;
+}
+
 pub fn createBuffer(comptime T: type, desc: BufferDesc(T)) Buffer {
+    flushDrawBatch();
     var buffer = std.mem.zeroes(GLBuffer);
     buffer.stream = desc.usage == .stream;
     buffer.vert_buffer_step_func = if (desc.step_func == .per_vertex) 0 else 1;
     buffer.size = @intCast(u32, desc.getSize());
+    buffer.grow = desc.grow and desc.usage != .immutable;
+    buffer.stats.size = buffer.size;
 
     if (@typeInfo(T) == .Struct) {
+        buffer.stride = @sizeOf(T);
         buffer.setVertexAttributes = struct {
             fn cb(attr_index: *GLuint, step_func: GLuint, vertex_buffer_offset: u32) void {
-                inline for (@typeInfo(T).Struct.fields) |field, i| {
-                    const offset: ?usize = if (i + vertex_buffer_offset == 0) null else vertex_buffer_offset + @byteOffsetOf(T, field.name);
-
-                    switch (@typeInfo(field.field_type)) {
-                        .Int => |type_info| {
-                            if (type_info.is_signed) {
-                                unreachable;
-                            } else {
-                                switch (type_info.bits) {
-                                    32 => {
-                                        // u32 is color
-                                        glVertexAttribPointer(attr_index.*, 4, GL_UNSIGNED_BYTE, GL_TRUE, @sizeOf(T), offset);
-                                        glEnableVertexAttribArray(attr_index.*);
-                                        glVertexAttribDivisor(attr_index.*, step_func);
-                                        attr_index.* += 1;
-                                    },
-                                    else => unreachable,
-                                }
-                            }
-                        },
-                        .Float => {
-                            glVertexAttribPointer(i, 1, GL_FLOAT, GL_FALSE, @sizeOf(T), offset);
-                            glEnableVertexAttribArray(i);
-                        },
-                        .Struct => |type_info| {
-                            const field_type = type_info.fields[0].field_type;
-                            std.debug.assert(@sizeOf(field_type) == 4);
-
-                            switch (@typeInfo(field_type)) {
-                                .Float => {
-                                    switch (type_info.fields.len) {
-                                        2, 3, 4 => {
-                                            glVertexAttribPointer(attr_index.*, type_info.fields.len, GL_FLOAT, GL_FALSE, @sizeOf(T), offset);
-                                            glEnableVertexAttribArray(attr_index.*);
-                                            glVertexAttribDivisor(attr_index.*, step_func);
-                                            attr_index.* += 1;
-                                        },
-                                        else => unreachable,
-                                    }
-                                },
-                                else => unreachable,
-                            }
-                        },
-                        else => unreachable,
-                    }
+                inline for (comptime vertexAttributes(T)) |attr| {
+                    const offset = @intToPtr(?*const c_void, vertex_buffer_offset + attr.offset);
+                    glVertexAttribPointer(attr_index.*, attr.size, attr.kind, attr.normalized, @sizeOf(T), offset);
+                    glEnableVertexAttribArray(attr_index.*);
+                    glVertexAttribDivisor(attr_index.*, step_func);
+                    attr_index.* += 1;
+                }
+            }
+        }.cb;
+        buffer.setVertexFormat = struct {
+            fn cb(attr_index: *GLuint, binding: GLuint) void {
+                inline for (comptime vertexAttributes(T)) |attr| {
+                    glVertexAttribFormat(attr_index.*, attr.size, attr.kind, attr.normalized, attr.offset);
+                    glVertexAttribBinding(attr_index.*, binding);
+                    glEnableVertexAttribArray(attr_index.*);
+                    attr_index.* += 1;
                 }
             }
         }.cb;
@@ -444,104 +702,679 @@ pub fn createBuffer(comptime T: type, desc: BufferDesc(T)) Buffer {
         buffer.index_buffer_type = if (T == u16) GL_UNSIGNED_SHORT else GL_UNSIGNED_INT;
     }
 
-    const buffer_kind: GLenum = if (desc.type == .index) GL_ELEMENT_ARRAY_BUFFER else GL_ARRAY_BUFFER;
-    glGenBuffers(1, &buffer.vbo);
-    cache.bindBuffer(buffer_kind, buffer.vbo);
-
+    buffer.kind = if (desc.type == .index) GL_ELEMENT_ARRAY_BUFFER else GL_ARRAY_BUFFER;
     const usage: GLenum = switch (desc.usage) {
         .stream => GL_STREAM_DRAW,
         .immutable => GL_STATIC_DRAW,
         .dynamic => GL_DYNAMIC_DRAW,
     };
-
-    glBufferData(buffer_kind, @intCast(c_long, buffer.size), if (desc.usage == .immutable) desc.content.?.ptr else null, usage);
+    createStorage(&buffer, if (desc.usage == .immutable) desc.content.?.ptr else null, usage);
     return buffer_cache.append(buffer);
 }
 
+/// creates the GL buffer object holding `buff.size` bytes. Stream buffers are persistently mapped when buffer storage
+/// is available.
+fn createStorage(buff: *GLBuffer, content: ?*const c_void, usage: GLenum) void {
+    if (features.direct_state_access) {
+        glCreateBuffers(1, &buff.vbo);
+        if (buff.stream and features.buffer_storage) {
+            const total_size = @intCast(GLsizeiptr, buff.size * FrameFences.num_regions);
+            const map_flags: GLbitfield = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+            glNamedBufferStorage(buff.vbo, total_size, null, map_flags | GL_DYNAMIC_STORAGE_BIT_EXT);
+            buff.mapped = @ptrCast([*]u8, glMapNamedBufferRange(buff.vbo, 0, total_size, map_flags));
+        } else {
+            glNamedBufferData(buff.vbo, @intCast(c_long, buff.size), content, usage);
+        }
+        return;
+    }
+
+    if (buff.kind == GL_ELEMENT_ARRAY_BUFFER) {
+        cache.bindVertexArray(upload_vao, 0);
+        cur_bindings = std.mem.zeroes(BufferBindings);
+    }
+    glGenBuffers(1, &buff.vbo);
+    cache.bindBuffer(buff.kind, buff.vbo);
+
+    if (buff.stream and features.buffer_storage) {
+        const total_size = @intCast(GLsizeiptr, buff.size * FrameFences.num_regions);
+        const map_flags: GLbitfield = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+        // dynamic storage keeps glBufferSubData legal for updateBuffer
+        glBufferStorage(buff.kind, total_size, null, map_flags | GL_DYNAMIC_STORAGE_BIT_EXT);
+        buff.mapped = @ptrCast([*]u8, glMapBufferRange(buff.kind, 0, total_size, map_flags));
+    } else {
+        glBufferData(buff.kind, @intCast(c_long, buff.size), content, usage);
+    }
+}
+
+/// bytes of the buffer's own storage. Append offsets at or past this address the overflow block.
+fn storageSize(buff: *const GLBuffer) u32 {
+    return if (buff.mapped != null) buff.size * FrameFences.num_regions else buff.size;
+}
+
+/// reallocates the growable buffers that overflowed this frame, doubling their size until it holds the high-water mark.
+/// The GPU may still be reading the old storage and the overflow block so both go through the release queue.
+fn growBuffers() void {
+    for (pending_grows.items) |buffer| {
+        const buff = buffer_cache.get(buffer);
+        buff.grow_pending = false;
+
+        vao_cache.invalidateBuffer(buffer, releaseVertexArray);
+        cache.invalidateBuffer(buff.vbo);
+        release_queue.push(.buffer, buff.vbo, frame_index);
+        if (buff.overflow_vbo != 0) {
+            cache.invalidateBuffer(buff.overflow_vbo);
+            release_queue.push(.buffer, buff.overflow_vbo, frame_index);
+            buff.overflow_vbo = 0;
+            buff.overflow_size = 0;
+        }
+
+        while (buff.size < buff.stats.high_water) buff.size *= 2;
+        buff.stats.size = buff.size;
+        buff.stats.grow_count += 1;
+        buff.mapped = null;
+        createStorage(buff, null, if (buff.stream) GL_STREAM_DRAW else GL_DYNAMIC_DRAW);
+    }
+
+    if (pending_grows.items.len > 0) cur_bindings = std.mem.zeroes(BufferBindings);
+    pending_grows.items.len = 0;
+}
+
+/// size, high-water mark and overflow counters of the buffer's appends
+pub fn getBufferStats(buffer: Buffer) BufferStats {
+    return buffer_cache.get(buffer).stats;
+}
+
 pub fn destroyBuffer(buffer: Buffer) void {
+    flushDrawBatch();
     var buff = buffer_cache.free(buffer);
+    vao_cache.invalidateBuffer(buffer, releaseVertexArray);
     cache.invalidateBuffer(buff.vbo);
-    glDeleteBuffers(1, &buff.vbo);
+    // the handle can be reused by the next createBuffer so the current bindings can't be trusted
+    cur_bindings = std.mem.zeroes(BufferBindings);
+    release_queue.push(.buffer, buff.vbo, frame_index);
+    if (buff.overflow_vbo != 0) {
+        cache.invalidateBuffer(buff.overflow_vbo);
+        release_queue.push(.buffer, buff.overflow_vbo, frame_index);
+    }
+    if (buff.staging) |memory| allocator.free(memory);
+
+    if (buff.grow_pending) {
+        for (pending_grows.items) |pending, i| {
+            if (pending == buffer) {
+                _ = pending_grows.swapRemove(i);
+                break;
+            }
+        }
+    }
 }
 
 pub fn updateBuffer(comptime T: type, buffer: Buffer, verts: []const T) void {
+    flushDrawBatch();
     const buff = buffer_cache.get(buffer);
-    cache.bindBuffer(GL_ARRAY_BUFFER, buff.vbo);
+    const num_bytes = @intCast(u32, verts.len * @sizeOf(T));
+
+    // orphan the buffer for streamed. Buffer storage can't be orphaned and relies on the driver syncing instead.
+    if (buff.stream and buff.mapped == null) orphanBuffer(buff.vbo, num_bytes);
+    bufferSubData(buff.vbo, 0, num_bytes, verts.ptr);
+}
+
+// the buffer helpers below go through GL_ARRAY_BUFFER, which unlike GL_ELEMENT_ARRAY_BUFFER isn't VAO state, or skip
+// binding entirely with direct state access
+
+/// replaces the storage with `size` uninitialized bytes so the GPU keeps the old storage it may still be reading
+fn orphanBuffer(vbo: GLuint, size: u32) void {
+    if (features.direct_state_access) {
+        glNamedBufferData(vbo, size, null, GL_STREAM_DRAW);
+    } else {
+        cache.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, size, null, GL_STREAM_DRAW);
+    }
+}
 
-    // orphan the buffer for streamed
-    if (buff.stream) glBufferData(GL_ARRAY_BUFFER, @intCast(c_long, verts.len * @sizeOf(T)), null, GL_STREAM_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, @intCast(c_long, verts.len * @sizeOf(T)), verts.ptr);
+fn bufferSubData(vbo: GLuint, offset: u32, num_bytes: u32, data: ?*const c_void) void {
+    if (features.direct_state_access) {
+        glNamedBufferSubData(vbo, offset, num_bytes, data);
+    } else {
+        cache.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, num_bytes, data);
+    }
+}
+
+fn mapBufferRange(vbo: GLuint, offset: u32, num_bytes: u32, access: GLbitfield) [*]u8 {
+    if (features.direct_state_access) return @ptrCast([*]u8, glMapNamedBufferRange(vbo, offset, num_bytes, access));
+    cache.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    return @ptrCast([*]u8, glMapBufferRange(GL_ARRAY_BUFFER, offset, num_bytes, access));
+}
+
+fn unmapBuffer(vbo: GLuint) void {
+    if (features.direct_state_access) {
+        _ = glUnmapNamedBuffer(vbo);
+    } else {
+        cache.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        _ = glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
 }
 
+/// returns the byte offset of the appended data. For persistently mapped buffers the offset includes the base of the
+/// current frame's region so callers can use it as a vertex buffer offset or base element unchanged.
 pub fn appendBuffer(comptime T: type, buffer: Buffer, verts: []const T) u32 {
+    return appendBytes(buffer, std.mem.sliceAsBytes(verts));
+}
+
+fn appendBytes(buffer: Buffer, bytes: []const u8) u32 {
+    const buff = buffer_cache.get(buffer);
+    rewindAppend(buff);
+
+    const num_bytes = @intCast(u32, bytes.len);
+    const region_base = if (buff.mapped != null) FrameFences.region(frame_index) * buff.size else 0;
+    const start_pos = buff.append_pos;
+
+    if (!trackAppend(buffer, buff, num_bytes)) {
+        if (num_bytes == 0) return region_base + start_pos;
+        if (spillAppend(buff, bytes)) |offset| return offset;
+        buff.stats.dropped_bytes += num_bytes;
+    } else if (num_bytes > 0) {
+        if (buff.mapped) |mapped| {
+            // commitFrame waited on this region's fence so the GPU is done with it
+            std.mem.copy(u8, mapped[region_base + start_pos .. region_base + start_pos + num_bytes], bytes);
+        } else if (buff.stream and features.map_buffer_range) {
+            const ptr = mapAppendRange(buff, num_bytes);
+            std.mem.copy(u8, ptr[0..num_bytes], bytes);
+            unmapBuffer(buff.vbo);
+        } else {
+            bufferSubData(buff.vbo, start_pos, num_bytes, bytes.ptr);
+        }
+        buff.append_pos += num_bytes;
+    }
+
+    return region_base + start_pos;
+}
+
+/// returns room for `count` elements at the buffer's append cursor. Persistently mapped buffers hand out their mapped
+/// memory directly and other stream buffers a glMapBufferRange mapping, so vertices are written straight to the GPU.
+/// Anything else, and reservations that don't fit, get staging memory that commitAppend uploads like appendBuffer.
+/// Only one reservation per buffer can be open and it must be committed before the buffer is drawn from.
+pub fn reserveAppend(comptime T: type, buffer: Buffer, count: usize) []T {
     const buff = buffer_cache.get(buffer);
-    cache.bindBuffer(GL_ARRAY_BUFFER, buff.vbo);
+    std.debug.assert(buff.reserved == .none);
+    rewindAppend(buff);
+
+    const num_bytes = @intCast(u32, count * @sizeOf(T));
+    buff.reserved_bytes = num_bytes;
+
+    var ptr: [*]u8 = undefined;
+    if (buff.append_overflow or buff.append_pos + num_bytes > buff.size) {
+        ptr = reserveStaging(buff, num_bytes);
+    } else if (buff.mapped) |mapped| {
+        buff.reserved = .mapped;
+        ptr = mapped + FrameFences.region(frame_index) * buff.size + buff.append_pos;
+    } else if (buff.stream and features.map_buffer_range) {
+        buff.reserved = .map_range;
+        ptr = mapAppendRange(buff, num_bytes);
+    } else {
+        ptr = reserveStaging(buff, num_bytes);
+    }
+    return @ptrCast([*]T, @alignCast(@alignOf(T), ptr))[0..count];
+}
 
-    const num_bytes = @intCast(c_long, verts.len * @sizeOf(T));
+fn reserveStaging(buff: *GLBuffer, num_bytes: u32) [*]u8 {
+    buff.reserved = .staging;
+    if (buff.staging == null or buff.staging.?.len < num_bytes) {
+        if (buff.staging) |old| allocator.free(old);
+        buff.staging = allocator.alignedAlloc(u8, 16, num_bytes) catch unreachable;
+    }
+    return buff.staging.?.ptr;
+}
 
-    // rewind append cursor in a new frame
-    if (buff.append_frame_index != frame_index) {
-        buff.append_pos = 0;
-        buff.append_overflow = false;
+/// appends the first `count` elements written to the slice returned by reserveAppend. Returns the byte offset of the
+/// data, the same as appendBuffer.
+pub fn commitAppend(comptime T: type, buffer: Buffer, count: usize) u32 {
+    const buff = buffer_cache.get(buffer);
+    const num_bytes = @intCast(u32, count * @sizeOf(T));
+    std.debug.assert(buff.reserved != .none and num_bytes <= buff.reserved_bytes);
+
+    const reserved = buff.reserved;
+    buff.reserved = .none;
+    switch (reserved) {
+        .none => unreachable,
+        .staging => return appendBytes(buffer, buff.staging.?[0..num_bytes]),
+        .mapped => {},
+        .map_range => unmapBuffer(buff.vbo),
     }
 
-    // check for overflow
-    if ((buff.append_pos + @intCast(u32, num_bytes)) > buff.size)
+    const region_base = if (buff.mapped != null) FrameFences.region(frame_index) * buff.size else 0;
+    const start_pos = buff.append_pos;
+    // the reservation was checked against the room left so this can't overflow
+    _ = trackAppend(buffer, buff, num_bytes);
+    buff.append_pos += num_bytes;
+    return region_base + start_pos;
+}
+
+/// rewinds the append cursor in a new frame
+fn rewindAppend(buff: *GLBuffer) void {
+    if (buff.append_frame_index == frame_index) return;
+    buff.append_frame_index = frame_index;
+    buff.append_pos = 0;
+    buff.append_overflow = false;
+    buff.frame_bytes = 0;
+    buff.overflow_pos = 0;
+}
+
+/// counts `num_bytes` towards the frame's high-water mark and returns false if they don't fit. Once a frame overflows
+/// the rest of its appends spill or are dropped to keep them in order.
+fn trackAppend(buffer: Buffer, buff: *GLBuffer, num_bytes: u32) bool {
+    buff.frame_bytes += num_bytes;
+    buff.stats.high_water = std.math.max(buff.stats.high_water, buff.frame_bytes);
+
+    if (!buff.append_overflow and (buff.append_pos + num_bytes) > buff.size) {
         buff.append_overflow = true;
+        buff.stats.overflow_frames += 1;
+        if (buff.grow and !buff.grow_pending) {
+            buff.grow_pending = true;
+            pending_grows.append(buffer) catch unreachable;
+        }
+    }
+    return !buff.append_overflow;
+}
 
-    const start_pos = buff.append_pos;
-    if (!buff.append_overflow and num_bytes > 0) {
-        glBufferSubData(GL_ARRAY_BUFFER, @intCast(c_long, buff.append_pos), num_bytes, verts.ptr);
-        buff.append_pos += @intCast(u32, num_bytes);
-        buff.append_frame_index = frame_index;
+/// maps `num_bytes` at the append cursor of a stream buffer. The caller unmaps it with unmapBuffer when done writing.
+fn mapAppendRange(buff: *GLBuffer, num_bytes: u32) [*]u8 {
+    // orphan on the first append of a frame so the GPU keeps the storage it is reading and writes never wait
+    if (buff.append_pos == 0) orphanBuffer(buff.vbo, buff.size);
+
+    const access: GLbitfield = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT_EXT | GL_MAP_INVALIDATE_RANGE_BIT_EXT;
+    return mapBufferRange(buff.vbo, buff.append_pos, num_bytes, access);
+}
+
+/// writes appended bytes that didn't fit into a growable vertex buffer into its overflow block, returning the offset to
+/// bind them with. Index data isn't spilled since the index buffer is attached to the VAO rather than bound per draw.
+fn spillAppend(buff: *GLBuffer, bytes: []const u8) ?u32 {
+    if (!buff.grow or buff.kind != GL_ARRAY_BUFFER) return null;
+
+    const num_bytes = @intCast(u32, bytes.len);
+    if (buff.overflow_pos + num_bytes > buff.overflow_size) {
+        // only an empty block can be resized without losing this frame's earlier spills
+        if (buff.overflow_pos > 0) return null;
+        buff.overflow_size = std.math.max(buff.size, num_bytes);
     }
 
-    return start_pos;
+    if (buff.overflow_vbo == 0) {
+        if (features.direct_state_access) glCreateBuffers(1, &buff.overflow_vbo) else glGenBuffers(1, &buff.overflow_vbo);
+    }
+    // orphan on the first spill of a frame so the GPU keeps the block an earlier frame drew from
+    if (buff.overflow_pos == 0) orphanBuffer(buff.overflow_vbo, buff.overflow_size);
+    bufferSubData(buff.overflow_vbo, buff.overflow_pos, num_bytes, bytes.ptr);
+
+    const offset = storageSize(buff) + buff.overflow_pos;
+    buff.overflow_pos += num_bytes;
+    buff.stats.spilled_bytes += num_bytes;
+    return offset;
+}
+
+const VertexSource = struct {
+    vbo: GLuint,
+    offset: u32,
+};
+
+/// the GL buffer and offset behind a vertex buffer binding. Offsets past the buffer's own storage were returned by
+/// spillAppend and address the overflow block.
+fn vertexSource(vbuffer: *const GLBuffer, offset: u32) VertexSource {
+    const storage_size = storageSize(vbuffer);
+    if (offset < storage_size) return .{ .vbo = vbuffer.vbo, .offset = offset };
+    return .{ .vbo = vbuffer.overflow_vbo, .offset = offset - storage_size };
 }
 
 // bindings and drawing
 pub fn applyBindings(bindings: BufferBindings) void {
+    base_shift.apply(bindings);
+    bindBuffers(bindings);
+}
+
+fn bindBuffers(bindings: BufferBindings) void {
     if (cur_bindings.eq(bindings)) return;
+    flushDrawBatch();
     cur_bindings = bindings;
 
     var ibuffer = buffer_cache.get(bindings.index_buffer);
-    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibuffer.vbo);
+    const key = VertexArrayCache.Key.init(bindings, !features.vertex_attrib_binding);
+    if (vao_cache.get(key)) |entry| {
+        cache.bindVertexArray(entry.vao, ibuffer.vbo);
+
+        // only the offsets can differ from what the VAO already has
+        if (features.vertex_attrib_binding) {
+            for (bindings.vert_buffers) |buff, i| {
+                if (buff == 0) break;
+                if (entry.offsets[i] == bindings.vertex_buffer_offsets[i]) continue;
+
+                const vbuffer = buffer_cache.get(buff);
+                const source = vertexSource(vbuffer, bindings.vertex_buffer_offsets[i]);
+                glBindVertexBuffer(@intCast(GLuint, i), source.vbo, source.offset, vbuffer.stride);
+                entry.offsets[i] = bindings.vertex_buffer_offsets[i];
+            }
+        }
+    } else {
+        var vao: GLuint = undefined;
+        glGenVertexArrays(1, &vao);
+        cache.bindVertexArray(vao, 0);
+        cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibuffer.vbo);
+
+        var vert_attr_index: GLuint = 0;
+        for (bindings.vert_buffers) |buff, i| {
+            if (buff == 0) break;
+
+            var vbuffer = buffer_cache.get(buff);
+            const source = vertexSource(vbuffer, bindings.vertex_buffer_offsets[i]);
+            if (features.vertex_attrib_binding) {
+                if (vbuffer.setVertexFormat) |setter| {
+                    const binding = @intCast(GLuint, i);
+                    setter(&vert_attr_index, binding);
+                    glVertexBindingDivisor(binding, vbuffer.vert_buffer_step_func);
+                    glBindVertexBuffer(binding, source.vbo, source.offset, vbuffer.stride);
+                }
+            } else if (vbuffer.setVertexAttributes) |setter| {
+                cache.bindBuffer(GL_ARRAY_BUFFER, source.vbo);
+                setter(&vert_attr_index, vbuffer.vert_buffer_step_func, source.offset);
+            }
+        }
 
-    var vert_attr_index: GLuint = 0;
-    for (bindings.vert_buffers) |buff, i| {
-        if (buff == 0) break;
+        const evicted = vao_cache.put(key, vao, bindings.vertex_buffer_offsets);
+        if (evicted != 0) releaseVertexArray(evicted);
+    }
+
+    // bind images and samplers
+    for (bindings.images) |image, slot| {
+        const unit = @intCast(c_uint, slot);
+        if (image == 0) {
+            cache.bindImage(0, unit);
+            continue;
+        }
 
-        var vbuffer = buffer_cache.get(buff);
-        if (vbuffer.setVertexAttributes) |setter| {
-            cache.bindBuffer(GL_ARRAY_BUFFER, vbuffer.vbo);
-            setter(&vert_attr_index, vbuffer.vert_buffer_step_func, bindings.vertex_buffer_offsets[i]);
+        var img = image_cache.get(image);
+        cache.bindImage(img.tid, unit);
+        if (features.sampler_objects) {
+            cache.bindSampler(if (bindings.samplers[slot]) |sampler| sampler_cache.get(sampler) else 0, unit);
+        } else {
+            // without sampler objects the parameters live on the texture. They are only rewritten when the wanted
+            // sampler differs from the last one applied, so an image bound two ways in one draw gets the last slot's.
+            const sampler = bindings.samplers[slot] orelse img.sampler;
+            if (sampler.key() != img.applied) {
+                cache.setActiveTexture(GL_TEXTURE0 + unit);
+                setTextureParams(img.tid, sampler);
+                img.applied = sampler.key();
+            }
         }
     }
+}
 
-    // bind images
-    for (bindings.images) |image, slot| {
-        const tid = if (image == 0) 0 else image_cache.get(image).tid;
-        cache.bindImage(tid, @intCast(c_uint, slot));
+pub fn draw(cmd: DrawCommand) void {
+    if ((cmd.base_vertex != 0 and !features.draw_base_vertex) or (cmd.base_instance != 0 and !features.base_instance)) {
+        return drawShifted(cmd);
     }
+    if (base_shift.restore()) |applied| bindBuffers(applied);
+    submitDraw(cmd);
 }
 
-pub fn draw(base_element: c_int, element_count: c_int, instance_count: c_int) void {
+fn submitDraw(cmd: DrawCommand) void {
     const ibuffer = buffer_cache.get(cur_bindings.index_buffer);
+    const mode = translations.primitiveTypeToGl(cmd.primitive_type);
+    const indirect = DrawElementsIndirectCommand{
+        .count = @intCast(GLuint, cmd.element_count),
+        .instance_count = @intCast(GLuint, std.math.max(cmd.instance_count, 1)),
+        .first_index = @intCast(GLuint, cmd.base_element),
+        .base_vertex = cmd.base_vertex,
+        .base_instance = @intCast(GLuint, cmd.base_instance),
+    };
 
-    const i_size: c_int = if (ibuffer.index_buffer_type == GL_UNSIGNED_SHORT) 2 else 4;
-    var ib_offset = @intCast(usize, base_element * i_size);
+    if (draw_batch.depth > 0) {
+        // a multi draw takes a single primitive type
+        if (draw_batch.mode != mode) flushDrawBatch();
+        draw_batch.mode = mode;
+        draw_batch.index_type = ibuffer.index_buffer_type;
+        draw_batch.commands.append(indirect) catch unreachable;
+        return;
+    }
+    drawElements(mode, ibuffer.index_buffer_type, indirect);
+}
 
-    if (instance_count <= 1) {
-        glDrawElements(GL_TRIANGLES, element_count, ibuffer.index_buffer_type, @intToPtr(?*GLvoid, ib_offset));
+fn drawElements(mode: GLenum, index_type: GLenum, cmd: DrawElementsIndirectCommand) void {
+    const i_size: usize = if (index_type == GL_UNSIGNED_SHORT) 2 else 4;
+    const ib_offset = @intToPtr(?*GLvoid, @as(usize, cmd.first_index) * i_size);
+    const count = @intCast(GLsizei, cmd.count);
+    const instance_count = @intCast(GLsizei, cmd.instance_count);
+
+    if (cmd.base_instance != 0) {
+        glDrawElementsInstancedBaseVertexBaseInstance(mode, count, index_type, ib_offset, instance_count, cmd.base_vertex, cmd.base_instance);
+    } else if (cmd.base_vertex != 0) {
+        if (instance_count <= 1) {
+            glDrawElementsBaseVertex(mode, count, index_type, ib_offset, cmd.base_vertex);
+        } else {
+            glDrawElementsInstancedBaseVertex(mode, count, index_type, ib_offset, instance_count, cmd.base_vertex);
+        }
+    } else if (instance_count <= 1) {
+        glDrawElements(mode, count, index_type, ib_offset);
     } else {
-        glDrawElementsInstanced(GL_TRIANGLES, element_count, ibuffer.index_buffer_type, @intToPtr(?*GLvoid, ib_offset), instance_count);
+        glDrawElementsInstanced(mode, count, index_type, ib_offset, instance_count);
+    }
+}
+
+/// without base vertex or base instance draws (GLES, GL before 3.2/4.2) the bases are folded into the vertex buffer
+/// offsets instead. That rebinds the vertex buffers, or without vertex attrib binding picks another VAO.
+fn drawShifted(cmd: DrawCommand) void {
+    var layouts = [_]BaseShift.Layout{.{}} ** 4;
+    for (base_shift.applied.vert_buffers) |buff, i| {
+        if (buff == 0) break;
+        const vbuffer = buffer_cache.get(buff);
+        layouts[i] = .{ .stride = @intCast(u32, vbuffer.stride), .per_instance = vbuffer.vert_buffer_step_func != 0 };
     }
+    bindBuffers(base_shift.shift(cmd, layouts));
+
+    var unshifted = cmd;
+    unshifted.base_vertex = 0;
+    unshifted.base_instance = 0;
+    submitDraw(unshifted);
+}
+
+// draw batches. Draws between beginDrawBatch and endDrawBatch are recorded as indirect commands instead of being issued
+// and go to the driver in one multi draw call when the batch ends or anything that affects them changes (bindings,
+// shader, uniforms, render state, passes, buffer and image updates).
+/// the layout glMultiDrawElementsIndirect reads from the indirect buffer
+const DrawElementsIndirectCommand = extern struct {
+    count: GLuint,
+    instance_count: GLuint,
+    first_index: GLuint,
+    base_vertex: GLint = 0,
+    base_instance: GLuint = 0,
+};
+
+const DrawBatch = struct {
+    /// batches nest, draws are recorded while this is above 0
+    depth: u32 = 0,
+    commands: std.ArrayList(DrawElementsIndirectCommand) = undefined,
+    mode: GLenum = GL_TRIANGLES,
+    index_type: GLenum = 0,
+    indirect_buffer: GLuint = 0,
+    indirect_size: u32 = 0,
+};
+
+/// name of the int uniform that receives the index of each draw in a batch on drivers without gl_DrawID. Programs
+/// declaring it have their batches issued one draw at a time with the uniform set in between.
+const draw_id_uniform = "rk_DrawID";
+
+pub fn beginDrawBatch() void {
+    draw_batch.depth += 1;
+}
+
+pub fn endDrawBatch() void {
+    std.debug.assert(draw_batch.depth > 0);
+    draw_batch.depth -= 1;
+    if (draw_batch.depth == 0) flushDrawBatch();
+}
+
+fn flushDrawBatch() void {
+    if (draw_batch.commands.items.len > 0) submitDrawBatch();
+}
+
+fn submitDrawBatch() void {
+    const commands = draw_batch.commands.items;
+    defer draw_batch.commands.items.len = 0;
+
+    const index_size: GLuint = if (draw_batch.index_type == GL_UNSIGNED_SHORT) 2 else 4;
+    const draw_id = if (bound_shader != 0) shader_cache.get(bound_shader).uniforms.find(comptime UniformTable.hashName(draw_id_uniform)) else null;
+
+    if (draw_id) |slot| {
+        for (commands) |cmd, i| {
+            const id = @intCast(c_int, i);
+            if (slot.changed(std.mem.asBytes(&id))) glUniform1i(slot.location, id);
+            drawElements(draw_batch.mode, draw_batch.index_type, cmd);
+        }
+    } else if (commands.len == 1) {
+        drawElements(draw_batch.mode, draw_batch.index_type, commands[0]);
+    } else if (features.multi_draw_indirect) {
+        const num_bytes = @intCast(u32, commands.len * @sizeOf(DrawElementsIndirectCommand));
+        if (draw_batch.indirect_buffer == 0) glGenBuffers(1, &draw_batch.indirect_buffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draw_batch.indirect_buffer);
+        // orphan every time, the previous batch may still be read
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, std.math.max(num_bytes, draw_batch.indirect_size), null, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, num_bytes, commands.ptr);
+        draw_batch.indirect_size = std.math.max(num_bytes, draw_batch.indirect_size);
+        glMultiDrawElementsIndirect(draw_batch.mode, draw_batch.index_type, null, @intCast(GLsizei, commands.len), 0);
+    } else if (features.multi_draw and allPlain(commands)) {
+        var counts: [64]GLsizei = undefined;
+        var offsets: [64]?*const c_void = undefined;
+        var start: usize = 0;
+        while (start < commands.len) : (start += counts.len) {
+            const chunk = commands[start..std.math.min(start + counts.len, commands.len)];
+            for (chunk) |cmd, i| {
+                counts[i] = @intCast(GLsizei, cmd.count);
+                offsets[i] = @intToPtr(?*const c_void, @as(usize, cmd.first_index) * index_size);
+            }
+            glMultiDrawElements(draw_batch.mode, &counts, draw_batch.index_type, &offsets, @intCast(GLsizei, chunk.len));
+        }
+    } else {
+        for (commands) |cmd| drawElements(draw_batch.mode, draw_batch.index_type, cmd);
+    }
+}
+
+/// glMultiDrawElements has no instances or base vertex
+fn allPlain(commands: []const DrawElementsIndirectCommand) bool {
+    for (commands) |cmd| {
+        if (cmd.instance_count > 1 or cmd.base_vertex != 0 or cmd.base_instance != 0) return false;
+    }
+    return true;
 }
 
 // shader
 const GLShaderProgram = struct {
     program: GLuint,
     fs_uniform_cache: [16]GLint,
+    uniform_blocks: [2]UniformBlock, // indexed by ShaderStage
+    uniforms: UniformTable,
+    /// whether the program takes the frame block as a block or as plain uniforms
+    frame_block_state: UniformBlock.State,
+    /// set until the program is checked and its uniforms resolved, see `submitProgram`
+    pending: ?*PendingProgram,
+};
+
+// uniform buffers. Uniform blocks are written with std140 layout into the uniform ring and attached with
+// glBindBufferRange to a binding point per stage. The shared frame block has its own binding point for all programs.
+const UniformBinding = struct {
+    const fs: GLuint = 0;
+    const vs: GLuint = 1;
+    const frame: GLuint = 2;
+
+    fn forStage(stage: ShaderStage) GLuint {
+        return if (stage == .fs) fs else vs;
+    }
+};
+
+const UniformBlock = struct {
+    const State = enum { unresolved, ubo, uniforms };
+
+    state: State,
+    /// the latest std140 bytes. Kept so they can be rewritten if the upload ages out of the ring.
+    bytes: ?[]u8,
+    upload: UniformRing.Upload,
+};
+
+var uniform_ring: UniformRing = undefined;
+var frame_block = std.mem.zeroes(UniformBlock);
+var frame_block_name: ?[*:0]const GLchar = null;
+/// the frame block's value as is, for programs that take its fields as plain uniforms. Those are set by
+/// `frame_fields_upload` when the program is bound, the program's UniformTable skips the ones that didn't change.
+var frame_values: ?[]u8 = null;
+var frame_fields_upload: ?fn (*GLShaderProgram) void = null;
+var bound_shader: ShaderProgram = 0;
+
+/// looks up the block named `name` in `program` and attaches it to `binding`. Programs without the block fall back to
+/// per field glUniform calls.
+fn resolveUniformBlock(block: *UniformBlock, program: GLuint, name: [*:0]const GLchar, binding: GLuint) void {
+    const index = if (features.uniform_buffer) glGetUniformBlockIndex(program, name) else GL_INVALID_INDEX;
+    if (index == GL_INVALID_INDEX) {
+        block.state = .uniforms;
+    } else {
+        glUniformBlockBinding(program, index, binding);
+        block.state = .ubo;
+    }
+}
+
+/// writes the std140 bytes of `value` into the ring unless they match what the block already has uploaded
+fn updateUniformBlock(comptime UniformT: type, block: *UniformBlock, value: *UniformT) void {
+    const Layout = std140.Layout(UniformT);
+    var bytes: [Layout.size]u8 = undefined;
+    Layout.write(value, &bytes);
+
+    if (block.bytes) |cur| {
+        if (cur.len == bytes.len and std.mem.eql(u8, cur, &bytes) and uniform_ring.isLive(block.upload, frame_index)) return;
+        if (cur.len != bytes.len) {
+            allocator.free(cur);
+            block.bytes = null;
+        }
+    }
+
+    if (block.bytes == null) block.bytes = allocator.alloc(u8, bytes.len) catch unreachable;
+    std.mem.copy(u8, block.bytes.?, &bytes);
+    block.upload = uploadUniformBytes(&bytes);
+}
+
+/// attaches the block's range to `binding`, rewriting its bytes first if they have aged out of the ring
+fn bindUniformBlock(block: *UniformBlock, binding: GLuint) void {
+    const bytes = block.bytes orelse return;
+    if (!uniform_ring.isLive(block.upload, frame_index)) block.upload = uploadUniformBytes(bytes);
+    cache.bindUniformBufferRange(binding, uniform_ring.buffer, block.upload.offset, block.upload.size);
+}
+
+/// writes `bytes` into the ring. When that orphans the ring the ranges still bound (the frame block and the blocks of
+/// the bound program) point at undefined storage, so their bytes are written again and rebound.
+fn uploadUniformBytes(bytes: []const u8) UniformRing.Upload {
+    const generation = uniform_ring.generation;
+    const upload = uniform_ring.upload(bytes, frame_index);
+    if (uniform_ring.generation == generation) return upload;
+
+    cache.invalidateUniformBuffers();
+    // every upload from before the orphan has a stale generation, so bindUniformBlock rewrites it
+    if (frame_block_name != null) bindUniformBlock(&frame_block, UniformBinding.frame);
+    if (bound_shader != 0) {
+        const shdr = shader_cache.get(bound_shader);
+        for (shdr.uniform_blocks) |*block, stage| {
+            if (block.state == .ubo) bindUniformBlock(block, UniformBinding.forStage(@intToEnum(ShaderStage, @intCast(@TagType(ShaderStage), stage))));
+        }
+    }
+    return upload;
+}
+
+/// a program handed to the driver whose compile and link status hasn't been checked yet. Asking for the status right
+/// after glCompileShader/glLinkProgram waits for the compiler, so it is put off until the program is needed or, with
+/// KHR_parallel_shader_compile, until the driver reports it done.
+const PendingProgram = struct {
+    vertex_shader: GLuint,
+    frag_shader: GLuint,
+    cache_key: u64,
+    /// time spent submitting, added to the cold time once the program is finished
+    submit_ns: u64,
+    /// copies of ShaderDesc.images so the desc doesn't have to outlive the call
+    names: []u8,
+    images: [][:0]const u8,
+    resolve: fn (shdr: *GLShaderProgram, images: []const [:0]const u8) void,
 };
 
 fn compileShader(stage: GLenum, src: [:0]const u8) GLuint {
@@ -549,88 +1382,323 @@ fn compileShader(stage: GLenum, src: [:0]const u8) GLuint {
     var shader_src = src;
     glShaderSource(shader, 1, &shader_src, null);
     glCompileShader(shader);
-    if (!checkShaderError(shader)) {
-        glDeleteShader(shader);
-        return 0;
-    }
     return shader;
 }
 
-pub fn createShaderProgram(comptime FragUniformT: type, desc: ShaderDesc) ShaderProgram {
+/// looks up image and fragment uniform locations and points each image uniform at its texture slot
+fn resolveProgram(comptime FragUniformT: type) fn (shdr: *GLShaderProgram, images: []const [:0]const u8) void {
+    return struct {
+        fn resolve(shdr: *GLShaderProgram, images: []const [:0]const u8) void {
+            const id = shdr.program;
+            shdr.uniforms = UniformTable.init(allocator, id);
+
+            // store currently bound program and rebind when done
+            const cur_prog = cache.shader;
+            cache.useShaderProgram(id);
+
+            // resolve images
+            var image_slot: GLint = 0;
+            for (images) |image| {
+                const loc = glGetUniformLocation(id, image);
+                if (loc != -1) {
+                    glUniform1i(loc, image_slot);
+                    image_slot += 1;
+                }
+            }
+
+            // uniforms, allow void to indicate no cached uniforms
+            const frag_ti = @typeInfo(FragUniformT);
+            if (frag_ti == .Struct) {
+                inline for (frag_ti.Struct.fields) |field, i| {
+                    shdr.fs_uniform_cache[i] = glGetUniformLocation(id, field.name ++ "\x00");
+                    if (std.builtin.mode == .Debug and shdr.fs_uniform_cache[i] == -1) std.debug.print("Uniform [{}] not found!\n", .{field.name});
+                }
+            }
+
+            cache.useShaderProgram(cur_prog);
+        }
+    }.resolve;
+}
+
+/// starts building a program without waiting for the driver. Programs found in the program cache are ready right away,
+/// everything else is pending until `finishProgram`.
+fn submitProgram(comptime FragUniformT: type, desc: ShaderDesc) ShaderProgram {
+    var timer = std.time.Timer.start() catch unreachable;
     var shader = std.mem.zeroes(GLShaderProgram);
 
-    const vertex_shader = compileShader(GL_VERTEX_SHADER, desc.vs);
-    const frag_shader = compileShader(GL_FRAGMENT_SHADER, desc.fs);
+    var key: u64 = 0;
+    if (program_cache) |*programs| {
+        key = programs.key(desc);
+        if (programs.load(key)) |id| {
+            shader.program = id;
+            resolveProgram(FragUniformT)(&shader, desc.images);
+            shader_stats.hits += 1;
+            shader_stats.warm_ns += timer.read();
+            return shader_cache.append(shader);
+        } else |err| {
+            if (err == error.Rejected) shader_stats.rejected += 1;
+        }
+    }
 
-    if (vertex_shader == 0 and frag_shader == 0) return 0;
+    var pending = allocator.create(PendingProgram) catch unreachable;
+    pending.vertex_shader = compileShader(GL_VERTEX_SHADER, desc.vs);
+    pending.frag_shader = compileShader(GL_FRAGMENT_SHADER, desc.fs);
+    pending.cache_key = key;
+    pending.resolve = resolveProgram(FragUniformT);
+
+    var names_len: usize = 0;
+    for (desc.images) |image| names_len += image.len + 1;
+    pending.names = allocator.alloc(u8, names_len) catch unreachable;
+    pending.images = allocator.alloc([:0]const u8, desc.images.len) catch unreachable;
+    var pos: usize = 0;
+    for (desc.images) |image, i| {
+        std.mem.copy(u8, pending.names[pos..], image);
+        pending.names[pos + image.len] = 0;
+        pending.images[i] = pending.names[pos .. pos + image.len :0];
+        pos += image.len + 1;
+    }
 
-    const id = glCreateProgram();
-    glAttachShader(id, vertex_shader);
-    glAttachShader(id, frag_shader);
-    glLinkProgram(id);
-    glDeleteShader(vertex_shader);
-    glDeleteShader(frag_shader);
+    shader.program = glCreateProgram();
+    if (program_cache != null) glProgramParameteri(shader.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(shader.program, pending.vertex_shader);
+    glAttachShader(shader.program, pending.frag_shader);
+    glLinkProgram(shader.program);
+
+    shader.pending = pending;
+    pending.submit_ns = timer.read();
+    const handle = shader_cache.append(shader);
+    if (features.parallel_shader_compile) pending_programs.append(handle) catch unreachable;
+    return handle;
+}
 
-    if (!checkProgramError(id)) {
-        glDeleteProgram(id);
-        return 0;
+/// waits for the driver to finish a pending program, checks it and resolves its uniforms. A program that failed to
+/// build is left with a GL program of 0.
+fn finishProgram(shdr: *GLShaderProgram) void {
+    var timer = std.time.Timer.start() catch unreachable;
+    const pending = shdr.pending.?;
+    shdr.pending = null;
+    defer freePendingProgram(pending);
+
+    const compiled = checkShaderError(pending.vertex_shader) and checkShaderError(pending.frag_shader);
+    if (!compiled or !checkProgramError(shdr.program)) {
+        glDeleteProgram(shdr.program);
+        // leave nothing for the uniform setters to look up on program 0
+        shdr.program = 0;
+        shdr.uniforms = UniformTable.initCapacity(allocator, 0);
+        for (shdr.fs_uniform_cache) |*loc| loc.* = -1;
+        for (shdr.uniform_blocks) |*block| block.state = .uniforms;
+        shdr.frame_block_state = .uniforms;
+        return;
     }
 
-    shader.program = id;
+    if (program_cache) |*programs| programs.store(pending.cache_key, shdr.program);
+    pending.resolve(shdr, pending.images);
+    shader_stats.misses += 1;
+    shader_stats.cold_ns += pending.submit_ns + timer.read();
+}
 
-    // store currently bound program and rebind when done
-    var cur_prog: GLint = 0;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &cur_prog);
-    glUseProgram(id);
+fn freePendingProgram(pending: *PendingProgram) void {
+    glDeleteShader(pending.vertex_shader);
+    glDeleteShader(pending.frag_shader);
+    allocator.free(pending.names);
+    allocator.free(pending.images);
+    allocator.destroy(pending);
+}
 
-    // resolve images
-    var image_slot: GLint = 0;
-    for (desc.images) |image, i| {
-        const loc = glGetUniformLocation(id, image);
-        if (loc != -1) {
-            glUniform1i(loc, image_slot);
-            image_slot += 1;
+/// the program behind a handle, finishing it first if it is still pending
+fn getProgram(shader: ShaderProgram) *GLShaderProgram {
+    const shdr = shader_cache.get(shader);
+    if (shdr.pending != null) finishProgram(shdr);
+    return shdr;
+}
+
+/// finishes pending programs the driver is done with. Only used with KHR_parallel_shader_compile, where asking for
+/// GL_COMPLETION_STATUS_KHR doesn't wait.
+fn pollPendingPrograms() void {
+    var i: usize = 0;
+    while (i < pending_programs.items.len) {
+        const shdr = shader_cache.get(pending_programs.items[i]);
+        if (shdr.pending == null or isProgramComplete(shdr)) {
+            if (shdr.pending != null) finishProgram(shdr);
+            _ = pending_programs.swapRemove(i);
+        } else {
+            i += 1;
         }
     }
+}
 
-    // uniforms, allow void to indicate no cached uniforms
-    const frag_ti = @typeInfo(FragUniformT);
-    if (frag_ti == .Struct) {
-        inline for (frag_ti.Struct.fields) |field, i| {
-            shader.fs_uniform_cache[i] = glGetUniformLocation(id, field.name ++ "\x00");
-            if (std.builtin.mode == .Debug and shader.fs_uniform_cache[i] == -1) std.debug.print("Uniform [{}] not found!\n", .{field.name});
-        }
+fn isProgramComplete(shdr: *GLShaderProgram) bool {
+    var done: GLint = GL_TRUE;
+    glGetProgramiv(shdr.program, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+pub fn createShaderProgram(comptime FragUniformT: type, desc: ShaderDesc) ShaderProgram {
+    const shader = submitProgram(FragUniformT, desc);
+    if (getProgram(shader).program == 0) {
+        destroyShaderProgram(shader);
+        return 0;
     }
+    return shader;
+}
 
-    glUseProgram(@intCast(GLuint, cur_prog));
+/// submits every program before checking any of them so the driver can compile them side by side. With
+/// KHR_parallel_shader_compile the handles are returned while the programs are still building. They are finished in
+/// `commitFrame` once the driver reports them done, or on first use, which waits. Programs that fail to build
+/// then act like a program of 0 and draw nothing. Without the extension every program is finished before returning and
+/// failed ones come back as 0, like `createShaderProgram`.
+pub fn createShaderPrograms(comptime FragUniformT: type, descs: []const ShaderDesc, programs: []ShaderProgram) void {
+    std.debug.assert(programs.len >= descs.len);
+    for (descs) |desc, i| programs[i] = submitProgram(FragUniformT, desc);
+    if (features.parallel_shader_compile) return;
+
+    for (programs[0..descs.len]) |*shader| {
+        if (getProgram(shader.*).program == 0) {
+            destroyShaderProgram(shader.*);
+            shader.* = 0;
+        }
+    }
+}
 
-    return shader_cache.append(shader);
+/// false while a program from `createShaderPrograms` is still being built by the driver. Never waits.
+pub fn isShaderProgramReady(shader: ShaderProgram) bool {
+    const shdr = shader_cache.get(shader);
+    if (shdr.pending == null) return true;
+    if (!features.parallel_shader_compile or !isProgramComplete(shdr)) return false;
+    finishProgram(shdr);
+    return true;
 }
 
 pub fn destroyShaderProgram(shader: ShaderProgram) void {
+    flushDrawBatch();
     const shdr = shader_cache.free(shader);
+    if (shdr.pending) |pending| {
+        freePendingProgram(pending);
+        for (pending_programs.items) |handle, i| {
+            if (handle == shader) {
+                _ = pending_programs.swapRemove(i);
+                break;
+            }
+        }
+        // nothing was resolved yet
+        release_queue.push(.program, shdr.program, frame_index);
+        return;
+    }
+    for (shdr.uniform_blocks) |block| {
+        if (block.bytes) |bytes| allocator.free(bytes);
+    }
+    shdr.uniforms.deinit(allocator);
     cache.invalidateProgram(shdr.program);
-    glDeleteProgram(shdr.program);
+    if (bound_shader == shader) bound_shader = 0;
+    release_queue.push(.program, shdr.program, frame_index);
 }
 
 pub fn useShaderProgram(shader: ShaderProgram) void {
-    const shdr = shader_cache.get(shader);
+    cur_pipeline = 0;
+    applyShaderProgram(shader);
+}
+
+fn applyShaderProgram(shader: ShaderProgram) void {
+    flushDrawBatch();
+    const shdr = getProgram(shader);
     cache.useShaderProgram(shdr.program);
+    bound_shader = shader;
+
+    if (features.uniform_buffer) {
+        // uniform buffer bindings are global so the program's blocks have to be reattached
+        for (shdr.uniform_blocks) |*block, stage| {
+            if (block.state == .ubo) bindUniformBlock(block, UniformBinding.forStage(@intToEnum(ShaderStage, @intCast(@TagType(ShaderStage), stage))));
+        }
+    }
+
+    if (frame_block_name != null) applyFrameBlock(shdr);
+}
+
+/// attaches the frame block to the bound program `shdr`, or sets its fields as uniforms when the program doesn't
+/// declare the block or the context has no uniform buffers
+fn applyFrameBlock(shdr: *GLShaderProgram) void {
+    if (shdr.frame_block_state == .unresolved) {
+        var block: UniformBlock = undefined;
+        resolveUniformBlock(&block, shdr.program, frame_block_name.?, UniformBinding.frame);
+        shdr.frame_block_state = block.state;
+    }
+
+    if (shdr.frame_block_state == .ubo) {
+        bindUniformBlock(&frame_block, UniformBinding.frame);
+    } else {
+        frame_fields_upload.?(shdr);
+    }
+}
+
+fn frameFieldsUpload(comptime UniformT: type) fn (*GLShaderProgram) void {
+    return struct {
+        fn upload(shdr: *GLShaderProgram) void {
+            var value: UniformT = undefined;
+            std.mem.copy(u8, std.mem.asBytes(&value), frame_values.?);
+            inline for (@typeInfo(UniformT).Struct.fields) |field| {
+                if (shdr.uniforms.find(comptime UniformTable.hashName(field.name))) |slot| {
+                    const field_value = @field(value, field.name);
+                    if (slot.changed(std.mem.asBytes(&field_value))) {
+                        // arrays go up as slices, uploadUniform takes them that way
+                        if (comptime @typeInfo(field.field_type) == .Array) {
+                            uploadUniform([]const @typeInfo(field.field_type).Array.child, slot.location, &field_value);
+                        } else {
+                            uploadUniform(field.field_type, slot.location, field_value);
+                        }
+                    }
+                }
+            }
+        }
+    }.upload;
+}
+
+/// sets the block shared by every program, for example the projection matrix. It is uploaded once and bound to its own
+/// binding point so switching programs doesn't resend it. Programs declare it as a std140 block named after UniformT.
+/// Without uniform buffers, and for programs that declare its fields as plain uniforms instead, the fields are set on
+/// each program when it is bound.
+pub fn setFrameUniformBlock(comptime UniformT: type, value: *UniformT) void {
+    flushDrawBatch();
+    frame_block_name = @typeName(UniformT) ++ "\x00";
+    frame_fields_upload = frameFieldsUpload(UniformT);
+
+    if (frame_values) |bytes| {
+        if (bytes.len != @sizeOf(UniformT)) {
+            allocator.free(bytes);
+            frame_values = null;
+        }
+    }
+    if (frame_values == null) frame_values = allocator.alloc(u8, @sizeOf(UniformT)) catch unreachable;
+    std.mem.copy(u8, frame_values.?, std.mem.asBytes(value));
+
+    if (features.uniform_buffer) {
+        updateUniformBlock(UniformT, &frame_block, value);
+        bindUniformBlock(&frame_block, UniformBinding.frame);
+    }
+    if (bound_shader != 0) applyFrameBlock(shader_cache.get(bound_shader));
 }
 
 pub fn setShaderProgramUniformBlock(comptime UniformT: type, shader: ShaderProgram, stage: ShaderStage, value: *UniformT) void {
-    const shdr = shader_cache.get(shader);
+    flushDrawBatch();
+    const shdr = getProgram(shader);
 
     // in debug builds ensure the shader we are setting the uniform on is bound
-    if (std.builtin.mode == .Debug) {
-        var cur_prog: GLint = 0;
-        glGetIntegerv(GL_CURRENT_PROGRAM, &cur_prog);
-        std.debug.assert(cur_prog == shdr.program);
+    if (std.builtin.mode == .Debug) std.debug.assert(cache.shader == shdr.program);
+
+    // the block is named after UniformT in the shader. Blocks the program doesn't declare use glUniform per field.
+    var block = &shdr.uniform_blocks[@enumToInt(stage)];
+    if (block.state == .unresolved) resolveUniformBlock(block, shdr.program, @typeName(UniformT) ++ "\x00", UniformBinding.forStage(stage));
+    if (block.state == .ubo) {
+        updateUniformBlock(UniformT, block, value);
+        bindUniformBlock(block, UniformBinding.forStage(stage));
+        return;
     }
 
     inline for (@typeInfo(UniformT).Struct.fields) |field, i| {
         const location = shdr.fs_uniform_cache[i];
         if (location > -1) {
+            // keep setShaderProgramUniform from skipping a later upload to the same location
+            if (shdr.uniforms.find(comptime UniformTable.hashName(field.name))) |slot| slot.shadow_len = 0;
+
             switch (@typeInfo(field.field_type)) {
                 .Float => glUniform1f(location, @field(value, field.name)),
                 .Int => glUniform1i(location, @field(value, field.name)),
@@ -680,121 +1748,99 @@ pub fn setShaderProgramUniformBlock(comptime UniformT: type, shader: ShaderProgr
     }
 }
 
-pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, name: [:0]const u8, value: T) void {
-    const shdr = shader_cache.get(shader);
-    const location = glGetUniformLocation(shdr.program, name);
-    if (location == -1) {
+/// `name` is hashed at comptime and looked up in the table of active uniforms built at link time. Uploads of a value
+/// equal to the last one sent to the location are skipped.
+pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, comptime name: [:0]const u8, value: T) void {
+    flushDrawBatch();
+    const shdr = getProgram(shader);
+    const slot = shdr.uniforms.find(comptime UniformTable.hashName(name)) orelse {
         std.debug.print("could not locate uniform: [{}]\n", .{name});
         return;
-    }
+    };
 
     // in debug builds ensure the shader we are setting the uniform on is bound
-    if (std.builtin.mode == .Debug) {
-        var cur_prog: GLint = 0;
-        glGetIntegerv(GL_CURRENT_PROGRAM, &cur_prog);
-        std.debug.assert(cur_prog == shdr.program);
-    }
-
-    const ti = @typeInfo(T);
-    const type_name = @typeName(T);
-
-    // cover common cases before we go down the rabbit hole
-    if (ti == .Struct and std.mem.eql(u8, type_name, "Mat32") and ti.Struct.fields.len == 1 and std.mem.eql(u8, ti.Struct.fields[0].name, "data")) {
-        var data = @field(value, ti.Struct.fields[0].name);
-        glUniformMatrix3x2fv(location, 1, GL_FALSE, &data);
-    } else if (ti == .Struct and std.mem.eql(u8, type_name, "Vec2")) {
-        var val = &@field(value, ti.Struct.fields[0].name);
-        glUniform2fv(location, 1, val);
-    } else if (ti == .Struct and std.mem.eql(u8, type_name, "Vec3")) {
-        var val = &@field(value, ti.Struct.fields[0].name);
-        glUniform3fv(location, 1, val);
-    } else if (ti == .Struct and std.mem.eql(u8, type_name, "Vec4")) {
-        var val = &@field(value, ti.Struct.fields[0].name);
-        glUniform4fv(location, 1, val);
-    } else if (ti == .Int) {
-        glUniform1i(location, value);
-    } else if (ti == .Float) {
-        glUniform1f(location, value);
-    } else if (ti == .Array) {
-        @panic("is it even possible to get to the branch?");
-        switch (@typeInfo(ti.Array.child)) {
-            .Int => |type_info| {
-                std.debug.assert(type_info.bits == 32);
-                glUniform1iv(location, @intCast(c_int, ti.Array.len), &value);
-            },
-            .Float => |type_info| {
-                std.debug.assert(type_info.bits == 32);
-                glUniform1fv(location, @intCast(c_int, ti.Array.len), &value);
-            },
-            .Struct => |type_info| {
-                std.debug.print("type_info: {}, type_info: {}\n", .{ ti, type_info });
-                @panic("add support for array of struct");
-            },
-            else => unreachable,
-        }
-    } else if (ti == .Struct) {
-        // the rabbit hole
-        inline for (ti.Struct.fields) |field, i| {
-            switch (@typeInfo(field.field_type)) {
-                .Float => |type_info| {
-                    std.debug.print("----- float: {}, field: {}\n", .{ type_info, field.name });
+    if (std.builtin.mode == .Debug) std.debug.assert(cache.shader == shdr.program);
+
+    const bytes = if (@typeInfo(T) == .Pointer) std.mem.sliceAsBytes(value) else std.mem.asBytes(&value);
+    if (!slot.changed(bytes)) return;
+
+    uploadUniform(T, slot.location, value);
+}
+
+fn uploadUniform(comptime T: type, location: GLint, value: T) void {
+    switch (@typeInfo(T)) {
+        .Int => |type_info| {
+            if (type_info.bits != 32) @compileError("Need support for uniform type: " ++ @typeName(T));
+            glUniform1i(location, value);
+        },
+        .Float => glUniform1f(location, value),
+        .Struct => |type_info| {
+            var copy = value;
+            var first = &@field(copy, type_info.fields[0].name);
+            switch (@typeInfo(type_info.fields[0].field_type)) {
+                // matrices are "struct { data: [n]f32 }"
+                .Array => |array_ti| switch (array_ti.len) {
+                    6 => glUniformMatrix3x2fv(location, 1, GL_FALSE, first),
+                    9 => glUniformMatrix3fv(location, 1, GL_FALSE, first),
+                    16 => glUniformMatrix4fv(location, 1, GL_FALSE, &first[0]),
+                    else => @compileError("Structs with array fields must be 6/9/16 elements: " ++ @typeName(T)),
+                },
+                .Float => switch (type_info.fields.len) {
+                    2 => glUniform2fv(location, 1, first),
+                    3 => glUniform3fv(location, 1, first),
+                    4 => glUniform4fv(location, 1, first),
+                    else => @compileError("Structs of f32 must be 2/3/4 elements: " ++ @typeName(T)),
                 },
+                else => @compileError("Need support for uniform type: " ++ @typeName(T)),
+            }
+        },
+        .Pointer => |ptr_info| {
+            if (ptr_info.size != .Slice) @compileError("only slices are supported: " ++ @typeName(T));
+            const count = @intCast(GLsizei, value.len);
+            switch (@typeInfo(ptr_info.child)) {
+                .Int => glUniform1iv(location, count, value.ptr),
+                .Float => glUniform1fv(location, count, value.ptr),
                 .Struct => |type_info| {
-                    const field_type = type_info.fields[0].field_type;
-                    std.debug.print("struct: {}, field: {}, len: {}\n", .{ type_info, field.name, type_info.fields.len });
-
-                    switch (@typeInfo(field_type)) {
-                        .Float => {
-                            switch (type_info.fields.len) {
-                                2 => {
-                                    std.debug.print("float2: {}\n", .{type_info});
-                                },
-                                else => unreachable,
-                            }
-                        },
-                        else => unreachable,
+                    if (type_info.fields[0].field_type != f32) @compileError("only slices of f32 structs are supported: " ++ @typeName(T));
+                    // the fields of each element are contiguous floats
+                    const floats = @ptrCast([*]const f32, value.ptr);
+                    switch (type_info.fields.len) {
+                        1 => glUniform1fv(location, count, floats),
+                        2 => glUniform2fv(location, count, floats),
+                        3 => glUniform3fv(location, count, floats),
+                        4 => glUniform4fv(location, count, floats),
+                        else => @compileError("Structs of f32 must be 1/2/3/4 elements: " ++ @typeName(T)),
                     }
                 },
-                else => unreachable,
+                else => @compileError("Need support for uniform type: " ++ @typeName(T)),
             }
-        }
-    } else if (ti == .Pointer) {
-        switch (ti.Pointer.size) {
-            .Slice => {
-                switch (@typeInfo(ti.Pointer.child)) {
-                    .Int => |type_info| {
-                        std.debug.assert(type_info.bits == 32);
-                        glUniform1iv(location, @intCast(c_int, value.len), value.ptr);
-                    },
-                    .Float => |type_info| {
-                        std.debug.assert(type_info.bits == 32);
-                        glUniform1fv(location, @intCast(c_int, value.len), value.ptr);
-                    },
-                    .Struct => |type_info| {
-                        // assume all fields are the same type
-                        switch (@typeInfo(type_info.fields[0].field_type)) {
-                            .Float => |field_info| {
-                                // grab the first element, since we will need a pointer to its first field
-                                const first_element = value[0];
-                                var struct_field_value = &@field(first_element, type_info.fields[0].name);
-
-                                switch (type_info.fields.len) {
-                                    1 => glUniform1fv(location, @intCast(c_int, std.mem.len(value)), struct_field_value),
-                                    2 => glUniform2fv(location, @intCast(c_int, std.mem.len(value)), struct_field_value),
-                                    3 => glUniform3fv(location, @intCast(c_int, std.mem.len(value)), struct_field_value),
-                                    4 => glUniform4fv(location, @intCast(c_int, std.mem.len(value)), struct_field_value),
-                                    else => unreachable,
-                                }
-                            },
-                            else => @panic("only arrays of floats supported"),
-                        }
-                    },
-                    else => unreachable,
-                }
-            },
-            else => @panic("only slices implemented"),
-        }
-    } else {
-        unreachable;
+        },
+        else => @compileError("Need support for uniform type: " ++ @typeName(T)),
     }
 }
+
+// pipelines
+/// GL has no pipeline state objects, the program and render state are applied through the RenderCache. Using the
+/// pipeline that is already current costs nothing.
+const GLPipeline = struct {
+    shader: ShaderProgram,
+    render_state: RenderState,
+};
+
+pub fn createPipeline(desc: PipelineDesc) u32 {
+    return pipeline_cache.append(.{ .shader = desc.shader, .render_state = desc.render_state });
+}
+
+pub fn destroyPipeline(pipeline: u32) void {
+    _ = pipeline_cache.free(pipeline);
+    if (cur_pipeline == pipeline) cur_pipeline = 0;
+}
+
+pub fn usePipeline(pipeline: u32) void {
+    if (pipeline == cur_pipeline) return;
+    flushDrawBatch();
+    const pip = pipeline_cache.get(pipeline);
+    applyShaderProgram(pip.shader);
+    cache.setRenderState(pip.render_state);
+    cur_pipeline = pipeline;
+}
@@ -0,0 +1,70 @@
+const std = @import("std");
+const renderkit = @import("../types.zig");
+
+/// emulates base vertex and base instance draws on drivers without them by folding the bases into the vertex buffer
+/// offsets. The shift is always computed from the bindings the application applied, never from what is bound, so
+/// consecutive shifted draws don't add up and a draw without bases gets the applied offsets back.
+pub const BaseShift = struct {
+    pub const Layout = struct {
+        stride: u32 = 0,
+        per_instance: bool = false,
+    };
+
+    /// the bindings last passed to applyBindings
+    applied: renderkit.BufferBindings = std.mem.zeroes(renderkit.BufferBindings),
+    /// true while shifted bindings are bound in place of `applied`
+    active: bool = false,
+
+    pub fn apply(self: *BaseShift, bindings: renderkit.BufferBindings) void {
+        self.applied = bindings;
+        self.active = false;
+    }
+
+    /// the applied bindings with the bases of `cmd` added to the offsets. `layouts` describes each vertex buffer.
+    pub fn shift(self: *BaseShift, cmd: renderkit.DrawCommand, layouts: [4]Layout) renderkit.BufferBindings {
+        var shifted = self.applied;
+        for (shifted.vert_buffers) |buff, i| {
+            if (buff == 0) break;
+            const base = if (layouts[i].per_instance) cmd.base_instance else cmd.base_vertex;
+            const offset = @as(i64, shifted.vertex_buffer_offsets[i]) + @as(i64, base) * layouts[i].stride;
+            if (offset < 0) std.debug.panic("base {} moves vertex buffer {} before its start, negative bases need driver support for base vertex draws", .{ base, i });
+            shifted.vertex_buffer_offsets[i] = @intCast(u32, offset);
+        }
+        self.active = true;
+        return shifted;
+    }
+
+    /// the applied bindings if shifted ones are bound, null if nothing needs rebinding
+    pub fn restore(self: *BaseShift) ?renderkit.BufferBindings {
+        if (!self.active) return null;
+        self.active = false;
+        return self.applied;
+    }
+};
+
+test "base shift starts from the applied bindings" {
+    var vert_buffers = [_]renderkit.Buffer{ 2, 3 };
+    var bindings = renderkit.BufferBindings.init(1, &vert_buffers);
+    bindings.vertex_buffer_offsets[0] = 16;
+    const layouts = [4]BaseShift.Layout{ .{ .stride = 20 }, .{ .stride = 52, .per_instance = true }, .{}, .{} };
+
+    var shift = BaseShift{};
+    shift.apply(bindings);
+    std.testing.expect(shift.restore() == null);
+
+    const ten = shift.shift(.{ .element_count = 6, .base_vertex = 10, .base_instance = 2 }, layouts);
+    std.testing.expectEqual(@as(u32, 16 + 10 * 20), ten.vertex_buffer_offsets[0]);
+    std.testing.expectEqual(@as(u32, 2 * 52), ten.vertex_buffer_offsets[1]);
+
+    // a draw without bases goes back to the applied offsets
+    std.testing.expect(shift.restore().?.eq(bindings));
+    std.testing.expect(shift.restore() == null);
+
+    const twenty = shift.shift(.{ .element_count = 6, .base_vertex = 20 }, layouts);
+    std.testing.expectEqual(@as(u32, 16 + 20 * 20), twenty.vertex_buffer_offsets[0]);
+    std.testing.expectEqual(@as(u32, 0), twenty.vertex_buffer_offsets[1]);
+    std.testing.expect(!bindings.eq(twenty));
+
+    // back to back shifts don't add up
+    std.testing.expectEqual(@as(u32, 16 + 30 * 20), shift.shift(.{ .element_count = 6, .base_vertex = 30 }, layouts).vertex_buffer_offsets[0]);
+}
@@ -0,0 +1,74 @@
+const std = @import("std");
+const num_inflight_frames = @import("release_queue.zig").num_inflight_frames;
+usingnamespace @import("gl_decls.zig");
+
+/// one fence per frame region of the persistently mapped stream buffers. `signal` is called when a frame is committed
+/// and `wait` before the CPU starts writing into a region again, so it never overwrites data the GPU may still read.
+/// `isComplete` polls the same fences without blocking to tell when the GPU finished a given frame.
+pub const FrameFences = struct {
+    pub const num_regions = num_inflight_frames + 1;
+
+    fences: [num_regions]GLsync = [_]GLsync{null} ** num_regions,
+    /// the frame each fence was signaled for
+    frames: [num_regions]u32 = [_]u32{0} ** num_regions,
+    /// every frame up to this one is known to be finished on the GPU
+    completed: u32 = 0,
+
+    pub fn region(frame_index: u32) u32 {
+        return frame_index % num_regions;
+    }
+
+    /// marks the end of the GPU work that reads `frame_index`'s region
+    pub fn signal(self: *FrameFences, frame_index: u32) void {
+        const fence = &self.fences[region(frame_index)];
+        if (fence.* != null) glDeleteSync(fence.*);
+        fence.* = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        self.frames[region(frame_index)] = frame_index;
+    }
+
+    /// blocks until the GPU is done with the last frame that used `frame_index`'s region
+    pub fn wait(self: *FrameFences, frame_index: u32) void {
+        const fence = &self.fences[region(frame_index)];
+        if (fence.* == null) return;
+
+        // the first wait doesn't flush so an already finished fence costs nothing
+        var flags: GLbitfield = 0;
+        while (true) {
+            const result = glClientWaitSync(fence.*, flags, 1_000_000);
+            if (result == GL_ALREADY_SIGNALED or result == GL_CONDITION_SATISFIED) {
+                self.completed = std.math.max(self.completed, self.frames[region(frame_index)]);
+                break;
+            }
+            if (result == GL_WAIT_FAILED) {
+                std.debug.print("glClientWaitSync failed\n", .{});
+                break;
+            }
+            flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        }
+
+        glDeleteSync(fence.*);
+        fence.* = null;
+    }
+
+    /// true once the GPU finished `frame_index`. Only polls, a frame that wasn't signaled yet is never complete.
+    pub fn isComplete(self: *FrameFences, frame_index: u32) bool {
+        if (frame_index <= self.completed) return true;
+        // the GPU finishes frames in order so any later frame being done will do
+        for (self.fences) |fence, i| {
+            if (fence == null or self.frames[i] < frame_index) continue;
+            const result = glClientWaitSync(fence, 0, 0);
+            if (result == GL_ALREADY_SIGNALED or result == GL_CONDITION_SATISFIED) {
+                self.completed = std.math.max(self.completed, self.frames[i]);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    pub fn deinit(self: *FrameFences) void {
+        for (self.fences) |*fence| {
+            if (fence.* != null) glDeleteSync(fence.*);
+            fence.* = null;
+        }
+    }
+};
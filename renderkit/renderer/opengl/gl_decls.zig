@@ -83,6 +83,7 @@ const Funcs = struct {
     glGetShaderInfoLog: fn (shader: GLuint, maxLength: GLsizei, length: *GLsizei, infoLog: [*]GLchar) void,
 
     glGetUniformLocation: fn (shader: GLuint, name: [*:0]const GLchar) GLint,
+    glGetActiveUniform: fn (GLuint, GLuint, GLsizei, [*c]GLsizei, [*c]GLint, [*c]GLenum, [*c]GLchar) void,
     glUniform1i: fn (location: GLint, v0: GLint) void,
     glUniform1iv: fn (GLint, GLsizei, [*c]const GLint) void,
     glUniform1f: fn (location: GLint, v0: GLfloat) void,
@@ -119,11 +120,90 @@ const Funcs = struct {
     glTexParameteriv: fn (GLenum, GLenum, [*c]const GLint) void,
     glTexImage1D: fn (GLenum, GLint, GLint, GLsizei, GLint, GLenum, GLenum, ?*const c_void) void,
     glTexImage2D: fn (GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, ?*const c_void) void,
+    glTexSubImage2D: fn (GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, ?*const c_void) void,
+    glCompressedTexImage2D: fn (GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, ?*const c_void) void,
+    glCompressedTexSubImage2D: fn (GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei, ?*const c_void) void,
+    glPixelStorei: fn (GLenum, GLint) void,
     glGenerateMipmap: fn (GLenum) void,
     glActiveTexture: fn (GLenum) void,
 };
 
+/// functions from newer GL versions or extensions. These are optional and only called after checking `Features`.
+const ExtFuncs = struct {
+    glGetStringi: ?fn (GLenum, GLuint) [*c]const GLubyte,
+
+    // ARB_vertex_attrib_binding
+    glVertexAttribFormat: ?fn (GLuint, GLint, GLenum, GLboolean, GLuint) void,
+    glVertexAttribBinding: ?fn (GLuint, GLuint) void,
+    glBindVertexBuffer: ?fn (GLuint, GLuint, GLintptr, GLsizei) void,
+    glVertexBindingDivisor: ?fn (GLuint, GLuint) void,
+
+    // ARB_uniform_buffer_object
+    glBindBufferRange: ?fn (GLenum, GLuint, GLuint, GLintptr, GLsizeiptr) void,
+    glGetUniformBlockIndex: ?fn (GLuint, [*:0]const GLchar) GLuint,
+    glUniformBlockBinding: ?fn (GLuint, GLuint, GLuint) void,
+
+    // ARB_map_buffer_range, ARB_buffer_storage and ARB_sync
+    glMapBufferRange: ?fn (GLenum, GLintptr, GLsizeiptr, GLbitfield) ?*c_void,
+    glUnmapBuffer: ?fn (GLenum) GLboolean,
+    glBufferStorage: ?fn (GLenum, GLsizeiptr, ?*const c_void, GLbitfield) void,
+    glFenceSync: ?fn (GLenum, GLbitfield) GLsync,
+    glClientWaitSync: ?fn (GLsync, GLbitfield, GLuint64) GLenum,
+    glDeleteSync: ?fn (GLsync) void,
+
+    // ARB_sampler_objects
+    glGenSamplers: ?fn (GLsizei, [*c]GLuint) void,
+    glDeleteSamplers: ?fn (GLsizei, [*c]const GLuint) void,
+    glBindSampler: ?fn (GLuint, GLuint) void,
+    glSamplerParameteri: ?fn (GLuint, GLenum, GLint) void,
+
+    // ARB_get_program_binary
+    glGetProgramBinary: ?fn (GLuint, GLsizei, [*c]GLsizei, [*c]GLenum, ?*c_void) void,
+    glProgramBinary: ?fn (GLuint, GLenum, ?*const c_void, GLsizei) void,
+    glProgramParameteri: ?fn (GLuint, GLenum, GLint) void,
+
+    // KHR_parallel_shader_compile and its ARB twin, which only differ in the suffix
+    glMaxShaderCompilerThreadsKHR: ?fn (GLuint) void,
+    glMaxShaderCompilerThreadsARB: ?fn (GLuint) void,
+
+    // ARB_direct_state_access
+    glCreateTextures: ?fn (GLenum, GLsizei, [*c]GLuint) void,
+    glTextureStorage2D: ?fn (GLuint, GLsizei, GLenum, GLsizei, GLsizei) void,
+    glTextureSubImage2D: ?fn (GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, ?*const c_void) void,
+    glCompressedTextureSubImage2D: ?fn (GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei, ?*const c_void) void,
+    glTextureParameteri: ?fn (GLuint, GLenum, GLint) void,
+    glGenerateTextureMipmap: ?fn (GLuint) void,
+    glCreateBuffers: ?fn (GLsizei, [*c]GLuint) void,
+    glNamedBufferData: ?fn (GLuint, GLsizeiptr, ?*const c_void, GLenum) void,
+    glNamedBufferSubData: ?fn (GLuint, GLintptr, GLsizeiptr, ?*const c_void) void,
+    glNamedBufferStorage: ?fn (GLuint, GLsizeiptr, ?*const c_void, GLbitfield) void,
+    glMapNamedBufferRange: ?fn (GLuint, GLintptr, GLsizeiptr, GLbitfield) ?*c_void,
+    glUnmapNamedBuffer: ?fn (GLuint) GLboolean,
+    glCreateFramebuffers: ?fn (GLsizei, [*c]GLuint) void,
+    glNamedFramebufferTexture: ?fn (GLuint, GLenum, GLuint, GLint) void,
+    glNamedFramebufferRenderbuffer: ?fn (GLuint, GLenum, GLenum, GLuint) void,
+    glNamedFramebufferDrawBuffers: ?fn (GLuint, GLsizei, [*c]const GLenum) void,
+    glCheckNamedFramebufferStatus: ?fn (GLuint, GLenum) GLenum,
+    glCreateRenderbuffers: ?fn (GLsizei, [*c]GLuint) void,
+    glNamedRenderbufferStorage: ?fn (GLuint, GLenum, GLsizei, GLsizei) void,
+
+    // multi draw. glMultiDrawElements is core since 1.4 but missing from GLES.
+    glMultiDrawElements: ?fn (GLenum, [*c]const GLsizei, GLenum, [*c]const ?*const c_void, GLsizei) void,
+    glMultiDrawElementsIndirect: ?fn (GLenum, GLenum, ?*const c_void, GLsizei, GLsizei) void,
+
+    // ARB_draw_elements_base_vertex and ARB_base_instance
+    glDrawElementsBaseVertex: ?fn (GLenum, GLsizei, GLenum, ?*const c_void, GLint) void,
+    glDrawElementsInstancedBaseVertex: ?fn (GLenum, GLsizei, GLenum, ?*const c_void, GLsizei, GLint) void,
+    glDrawElementsInstancedBaseVertexBaseInstance: ?fn (GLenum, GLsizei, GLenum, ?*const c_void, GLsizei, GLint, GLuint) void,
+};
+
 var gl: Funcs = undefined;
+var gl_ext: ExtFuncs = undefined;
+
+/// true if the optional function was found by the loader
+pub fn hasFunction(comptime name: []const u8) bool {
+    return @field(gl_ext, name) != null;
+}
 
 pub fn loadFunctionsZig() void {
     const lib = switch (std.builtin.os.tag) {
@@ -142,6 +222,10 @@ pub fn loadFunctionsZig() void {
     inline for (@typeInfo(Funcs).Struct.fields) |field, i| {
         @field(gl, field.name) = dynlib.lookup(field.field_type, field.name ++ &[_:0]u8{0}).?;
     }
+
+    inline for (@typeInfo(ExtFuncs).Struct.fields) |field, i| {
+        @field(gl_ext, field.name) = dynlib.lookup(@typeInfo(field.field_type).Optional.child, field.name ++ &[_:0]u8{0});
+    }
 }
 
 /// loader is a GL function loader, for example SDL_GL_GetProcAddress or glfwGetProcAddress
@@ -149,6 +233,10 @@ pub fn loadFunctions(loader: fn ([*c]const u8) callconv(.C) ?*c_void) void {
     inline for (@typeInfo(Funcs).Struct.fields) |field, i| {
         @field(gl, field.name) = @ptrCast(field.field_type, loader(field.name ++ &[_]u8{0}));
     }
+
+    inline for (@typeInfo(ExtFuncs).Struct.fields) |field, i| {
+        @field(gl_ext, field.name) = @ptrCast(field.field_type, loader(field.name ++ &[_]u8{0}));
+    }
 }
 
 pub fn glEnable(state: GLenum) void {
@@ -360,6 +448,10 @@ pub fn glGetUniformLocation(shader: GLuint, name: [*:0]const GLchar) GLint {
     return gl.glGetUniformLocation(shader, name);
 }
 
+pub fn glGetActiveUniform(program: GLuint, index: GLuint, buf_size: GLsizei, length: [*c]GLsizei, size: [*c]GLint, kind: [*c]GLenum, name: [*c]GLchar) void {
+    gl.glGetActiveUniform(program, index, buf_size, length, size, kind, name);
+}
+
 pub fn glUniform1i(location: GLint, value: GLint) void {
     gl.glUniform1i(location, value);
 }
@@ -488,6 +580,22 @@ pub fn glTexImage2D(target: GLenum, level: GLint, internal_format: GLint, width:
     gl.glTexImage2D(target, level, internal_format, width, height, border, format, kind, data);
 }
 
+pub fn glTexSubImage2D(target: GLenum, level: GLint, x: GLint, y: GLint, width: GLsizei, height: GLsizei, format: GLenum, kind: GLenum, data: ?*const c_void) void {
+    gl.glTexSubImage2D(target, level, x, y, width, height, format, kind, data);
+}
+
+pub fn glCompressedTexImage2D(target: GLenum, level: GLint, internal_format: GLenum, width: GLsizei, height: GLsizei, border: GLint, image_size: GLsizei, data: ?*const c_void) void {
+    gl.glCompressedTexImage2D(target, level, internal_format, width, height, border, image_size, data);
+}
+
+pub fn glCompressedTexSubImage2D(target: GLenum, level: GLint, x: GLint, y: GLint, width: GLsizei, height: GLsizei, format: GLenum, image_size: GLsizei, data: ?*const c_void) void {
+    gl.glCompressedTexSubImage2D(target, level, x, y, width, height, format, image_size, data);
+}
+
+pub fn glPixelStorei(pname: GLenum, param: GLint) void {
+    gl.glPixelStorei(pname, param);
+}
+
 pub fn glGenerateMipmap(target: GLenum) void {
     gl.glGenerateMipmap(target);
 }
@@ -496,6 +604,195 @@ pub fn glActiveTexture(target: GLenum) void {
     gl.glActiveTexture(target);
 }
 
+// optional functions
+pub fn glGetStringi(name: GLenum, index: GLuint) [*c]const GLubyte {
+    return gl_ext.glGetStringi.?(name, index);
+}
+
+pub fn glVertexAttribFormat(attrib_index: GLuint, size: GLint, kind: GLenum, normalized: GLboolean, relative_offset: GLuint) void {
+    gl_ext.glVertexAttribFormat.?(attrib_index, size, kind, normalized, relative_offset);
+}
+
+pub fn glVertexAttribBinding(attrib_index: GLuint, binding_index: GLuint) void {
+    gl_ext.glVertexAttribBinding.?(attrib_index, binding_index);
+}
+
+pub fn glBindVertexBuffer(binding_index: GLuint, buffer: GLuint, offset: GLintptr, stride: GLsizei) void {
+    gl_ext.glBindVertexBuffer.?(binding_index, buffer, offset, stride);
+}
+
+pub fn glVertexBindingDivisor(binding_index: GLuint, divisor: GLuint) void {
+    gl_ext.glVertexBindingDivisor.?(binding_index, divisor);
+}
+
+pub fn glBindBufferRange(target: GLenum, index: GLuint, buffer: GLuint, offset: GLintptr, size: GLsizeiptr) void {
+    gl_ext.glBindBufferRange.?(target, index, buffer, offset, size);
+}
+
+pub fn glGetUniformBlockIndex(program: GLuint, name: [*:0]const GLchar) GLuint {
+    return gl_ext.glGetUniformBlockIndex.?(program, name);
+}
+
+pub fn glUniformBlockBinding(program: GLuint, block_index: GLuint, block_binding: GLuint) void {
+    gl_ext.glUniformBlockBinding.?(program, block_index, block_binding);
+}
+
+pub fn glMapBufferRange(target: GLenum, offset: GLintptr, length: GLsizeiptr, access: GLbitfield) ?*c_void {
+    return gl_ext.glMapBufferRange.?(target, offset, length, access);
+}
+
+pub fn glUnmapBuffer(target: GLenum) GLboolean {
+    return gl_ext.glUnmapBuffer.?(target);
+}
+
+pub fn glBufferStorage(target: GLenum, size: GLsizeiptr, data: ?*const c_void, flags: GLbitfield) void {
+    gl_ext.glBufferStorage.?(target, size, data, flags);
+}
+
+pub fn glFenceSync(condition: GLenum, flags: GLbitfield) GLsync {
+    return gl_ext.glFenceSync.?(condition, flags);
+}
+
+pub fn glClientWaitSync(sync: GLsync, flags: GLbitfield, timeout: GLuint64) GLenum {
+    return gl_ext.glClientWaitSync.?(sync, flags, timeout);
+}
+
+pub fn glDeleteSync(sync: GLsync) void {
+    gl_ext.glDeleteSync.?(sync);
+}
+
+pub fn glGenSamplers(n: GLsizei, samplers: [*c]GLuint) void {
+    gl_ext.glGenSamplers.?(n, samplers);
+}
+
+pub fn glDeleteSamplers(n: GLsizei, samplers: [*c]const GLuint) void {
+    gl_ext.glDeleteSamplers.?(n, samplers);
+}
+
+pub fn glBindSampler(unit: GLuint, sampler: GLuint) void {
+    gl_ext.glBindSampler.?(unit, sampler);
+}
+
+pub fn glSamplerParameteri(sampler: GLuint, pname: GLenum, param: GLint) void {
+    gl_ext.glSamplerParameteri.?(sampler, pname, param);
+}
+
+pub fn glGetProgramBinary(program: GLuint, buf_size: GLsizei, length: [*c]GLsizei, binary_format: [*c]GLenum, binary: ?*c_void) void {
+    gl_ext.glGetProgramBinary.?(program, buf_size, length, binary_format, binary);
+}
+
+pub fn glProgramBinary(program: GLuint, binary_format: GLenum, binary: ?*const c_void, length: GLsizei) void {
+    gl_ext.glProgramBinary.?(program, binary_format, binary, length);
+}
+
+pub fn glProgramParameteri(program: GLuint, pname: GLenum, value: GLint) void {
+    gl_ext.glProgramParameteri.?(program, pname, value);
+}
+
+pub fn glMaxShaderCompilerThreadsKHR(count: GLuint) void {
+    gl_ext.glMaxShaderCompilerThreadsKHR.?(count);
+}
+
+pub fn glMaxShaderCompilerThreadsARB(count: GLuint) void {
+    gl_ext.glMaxShaderCompilerThreadsARB.?(count);
+}
+
+pub fn glCreateTextures(target: GLenum, n: GLsizei, textures: [*c]GLuint) void {
+    gl_ext.glCreateTextures.?(target, n, textures);
+}
+
+pub fn glTextureStorage2D(texture: GLuint, levels: GLsizei, internal_format: GLenum, width: GLsizei, height: GLsizei) void {
+    gl_ext.glTextureStorage2D.?(texture, levels, internal_format, width, height);
+}
+
+pub fn glTextureSubImage2D(texture: GLuint, level: GLint, x: GLint, y: GLint, width: GLsizei, height: GLsizei, format: GLenum, kind: GLenum, data: ?*const c_void) void {
+    gl_ext.glTextureSubImage2D.?(texture, level, x, y, width, height, format, kind, data);
+}
+
+pub fn glCompressedTextureSubImage2D(texture: GLuint, level: GLint, x: GLint, y: GLint, width: GLsizei, height: GLsizei, format: GLenum, image_size: GLsizei, data: ?*const c_void) void {
+    gl_ext.glCompressedTextureSubImage2D.?(texture, level, x, y, width, height, format, image_size, data);
+}
+
+pub fn glTextureParameteri(texture: GLuint, pname: GLenum, param: GLint) void {
+    gl_ext.glTextureParameteri.?(texture, pname, param);
+}
+
+pub fn glGenerateTextureMipmap(texture: GLuint) void {
+    gl_ext.glGenerateTextureMipmap.?(texture);
+}
+
+pub fn glCreateBuffers(n: GLsizei, buffers: [*c]GLuint) void {
+    gl_ext.glCreateBuffers.?(n, buffers);
+}
+
+pub fn glNamedBufferData(buffer: GLuint, size: GLsizeiptr, data: ?*const c_void, usage: GLenum) void {
+    gl_ext.glNamedBufferData.?(buffer, size, data, usage);
+}
+
+pub fn glNamedBufferSubData(buffer: GLuint, offset: GLintptr, size: GLsizeiptr, data: ?*const c_void) void {
+    gl_ext.glNamedBufferSubData.?(buffer, offset, size, data);
+}
+
+pub fn glNamedBufferStorage(buffer: GLuint, size: GLsizeiptr, data: ?*const c_void, flags: GLbitfield) void {
+    gl_ext.glNamedBufferStorage.?(buffer, size, data, flags);
+}
+
+pub fn glMapNamedBufferRange(buffer: GLuint, offset: GLintptr, length: GLsizeiptr, access: GLbitfield) ?*c_void {
+    return gl_ext.glMapNamedBufferRange.?(buffer, offset, length, access);
+}
+
+pub fn glUnmapNamedBuffer(buffer: GLuint) GLboolean {
+    return gl_ext.glUnmapNamedBuffer.?(buffer);
+}
+
+pub fn glCreateFramebuffers(n: GLsizei, framebuffers: [*c]GLuint) void {
+    gl_ext.glCreateFramebuffers.?(n, framebuffers);
+}
+
+pub fn glNamedFramebufferTexture(framebuffer: GLuint, attachment: GLenum, texture: GLuint, level: GLint) void {
+    gl_ext.glNamedFramebufferTexture.?(framebuffer, attachment, texture, level);
+}
+
+pub fn glNamedFramebufferRenderbuffer(framebuffer: GLuint, attachment: GLenum, render_buffer_target: GLenum, buffer: GLuint) void {
+    gl_ext.glNamedFramebufferRenderbuffer.?(framebuffer, attachment, render_buffer_target, buffer);
+}
+
+pub fn glNamedFramebufferDrawBuffers(framebuffer: GLuint, n: GLsizei, bufs: [*c]const GLenum) void {
+    gl_ext.glNamedFramebufferDrawBuffers.?(framebuffer, n, bufs);
+}
+
+pub fn glCheckNamedFramebufferStatus(framebuffer: GLuint, target: GLenum) GLenum {
+    return gl_ext.glCheckNamedFramebufferStatus.?(framebuffer, target);
+}
+
+pub fn glCreateRenderbuffers(n: GLsizei, renderbuffers: [*c]GLuint) void {
+    gl_ext.glCreateRenderbuffers.?(n, renderbuffers);
+}
+
+pub fn glNamedRenderbufferStorage(renderbuffer: GLuint, format: GLenum, width: GLsizei, height: GLsizei) void {
+    gl_ext.glNamedRenderbufferStorage.?(renderbuffer, format, width, height);
+}
+
+pub fn glMultiDrawElements(mode: GLenum, count: [*c]const GLsizei, kind: GLenum, indices: [*c]const ?*const c_void, draw_count: GLsizei) void {
+    gl_ext.glMultiDrawElements.?(mode, count, kind, indices, draw_count);
+}
+
+pub fn glMultiDrawElementsIndirect(mode: GLenum, kind: GLenum, indirect: ?*const c_void, draw_count: GLsizei, stride: GLsizei) void {
+    gl_ext.glMultiDrawElementsIndirect.?(mode, kind, indirect, draw_count, stride);
+}
+
+pub fn glDrawElementsBaseVertex(mode: GLenum, count: GLsizei, kind: GLenum, indices: ?*const c_void, base_vertex: GLint) void {
+    gl_ext.glDrawElementsBaseVertex.?(mode, count, kind, indices, base_vertex);
+}
+
+pub fn glDrawElementsInstancedBaseVertex(mode: GLenum, count: GLsizei, kind: GLenum, indices: ?*const c_void, instance_count: GLsizei, base_vertex: GLint) void {
+    gl_ext.glDrawElementsInstancedBaseVertex.?(mode, count, kind, indices, instance_count, base_vertex);
+}
+
+pub fn glDrawElementsInstancedBaseVertexBaseInstance(mode: GLenum, count: GLsizei, kind: GLenum, indices: ?*const c_void, instance_count: GLsizei, base_vertex: GLint, base_instance: GLuint) void {
+    gl_ext.glDrawElementsInstancedBaseVertexBaseInstance.?(mode, count, kind, indices, instance_count, base_vertex, base_instance);
+}
+
 comptime {
     @import("std").testing.refAllDecls(@This());
 }
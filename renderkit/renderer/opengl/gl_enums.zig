@@ -23,6 +23,7 @@ pub const GL_ALPHA16F_EXT = 34844;
 pub const GL_ALPHA32F_EXT = 34838;
 pub const GL_ALPHA8_EXT = 32828;
 pub const GL_ALPHA8_OES = 32828;
+pub const GL_ALREADY_SIGNALED = 37146;
 pub const GL_ALREADY_SIGNALED_APPLE = 37146;
 pub const GL_ALWAYS = 519;
 pub const GL_AMD_compressed_3DC_texture = 1;
@@ -195,6 +196,8 @@ pub const GL_COMPILE_STATUS = 35713;
 pub const GL_COMPLETION_STATUS_KHR = 37297;
 pub const GL_COMPRESSED_RED_GREEN_RGTC2_EXT = 36285;
 pub const GL_COMPRESSED_RED_RGTC1_EXT = 36283;
+pub const GL_COMPRESSED_RGB8_ETC2 = 37492;
+pub const GL_COMPRESSED_RGBA8_ETC2_EAC = 37496;
 pub const GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_EXT = 36494;
 pub const GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT = 36495;
 pub const GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG = 35841;
@@ -276,6 +279,7 @@ pub const GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x5_KHR = 37845;
 pub const GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x6_KHR = 37846;
 pub const GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR = 37847;
 pub const GL_COMPRESSED_TEXTURE_FORMATS = 34467;
+pub const GL_CONDITION_SATISFIED = 37148;
 pub const GL_CONDITION_SATISFIED_APPLE = 37148;
 pub const GL_CONFORMANT_NV = 37748;
 pub const GL_CONIC_CURVE_TO_NV = 26;
@@ -442,6 +446,7 @@ pub const GL_DRAW_FRAMEBUFFER_BINDING_ANGLE = 36006;
 pub const GL_DRAW_FRAMEBUFFER_BINDING_APPLE = 36006;
 pub const GL_DRAW_FRAMEBUFFER_BINDING_NV = 36006;
 pub const GL_DRAW_FRAMEBUFFER_NV = 36009;
+pub const GL_DRAW_INDIRECT_BUFFER = 36671;
 pub const GL_DRIVER_UUID_EXT = 38296;
 pub const GL_DST_ALPHA = 772;
 pub const GL_DST_ATOP_NV = 37519;
@@ -785,6 +790,7 @@ pub const GL_INTEL_framebuffer_CMAA = 1;
 pub const GL_INTEL_performance_query = 1;
 pub const GL_INVALID_ENUM = 1280;
 pub const GL_INVALID_FRAMEBUFFER_OPERATION = 1286;
+pub const GL_INVALID_INDEX = 4294967295;
 pub const GL_INVALID_OPERATION = 1282;
 pub const GL_INVALID_VALUE = 1281;
 pub const GL_INVERT = 5386;
@@ -862,6 +868,7 @@ pub const GL_LUMINANCE8_ALPHA8_EXT = 32837;
 pub const GL_LUMINANCE8_ALPHA8_OES = 32837;
 pub const GL_LUMINANCE8_EXT = 32832;
 pub const GL_LUMINANCE8_OES = 32832;
+pub const GL_MAJOR_VERSION = 33307;
 pub const GL_MALI_PROGRAM_BINARY_ARM = 36705;
 pub const GL_MALI_SHADER_BINARY_ARM = 36704;
 pub const GL_MAP_COHERENT_BIT_EXT = 128;
@@ -1055,6 +1062,7 @@ pub const GL_MESH_SUBROUTINE_UNIFORM_NV = 38270;
 pub const GL_MESH_VERTICES_OUT_NV = 38265;
 pub const GL_MESH_WORK_GROUP_SIZE_NV = 38206;
 pub const GL_MIN = 32775;
+pub const GL_MINOR_VERSION = 33308;
 pub const GL_MIN_EXT = 32775;
 pub const GL_MIN_FRAGMENT_INTERPOLATION_OFFSET_OES = 36443;
 pub const GL_MIN_SAMPLE_SHADING_VALUE_OES = 35895;
@@ -1097,6 +1105,7 @@ pub const GL_NOTEQUAL = 517;
 pub const GL_NUM_COMPRESSED_TEXTURE_FORMATS = 34466;
 pub const GL_NUM_DEVICE_UUIDS_EXT = 38294;
 pub const GL_NUM_DOWNSAMPLE_SCALES_IMG = 37181;
+pub const GL_NUM_EXTENSIONS = 33309;
 pub const GL_NUM_PROGRAM_BINARY_FORMATS_OES = 34814;
 pub const GL_NUM_SHADER_BINARY_FORMATS = 36345;
 pub const GL_NUM_SPARSE_LEVELS_EXT = 37290;
@@ -1327,6 +1336,7 @@ pub const GL_PERFQUERY_WAIT_INTEL = 33787;
 pub const GL_PINLIGHT_NV = 37544;
 pub const GL_PIXEL_PACK_BUFFER_BINDING_NV = 35053;
 pub const GL_PIXEL_PACK_BUFFER_NV = 35051;
+pub const GL_PIXEL_UNPACK_BUFFER = 35052;
 pub const GL_PIXEL_UNPACK_BUFFER_BINDING_NV = 35055;
 pub const GL_PIXEL_UNPACK_BUFFER_NV = 35052;
 pub const GL_PLUS_CLAMPED_ALPHA_NV = 37554;
@@ -1352,6 +1362,7 @@ pub const GL_PROGRAM_BINARY_ANGLE = 37798;
 pub const GL_PROGRAM_BINARY_FORMAT_MESA = 34655;
 pub const GL_PROGRAM_BINARY_FORMATS_OES = 34815;
 pub const GL_PROGRAM_BINARY_LENGTH_OES = 34625;
+pub const GL_PROGRAM_BINARY_RETRIEVABLE_HINT = 33367;
 pub const GL_PROGRAM_KHR = 33506;
 pub const GL_PROGRAM_OBJECT_EXT = 35648;
 pub const GL_PROGRAM_PIPELINE_BINDING_EXT = 33370;
@@ -1651,7 +1662,9 @@ pub const GL_SUPPORTED_MULTISAMPLE_MODES_AMD = 37303;
 pub const GL_SYNC_CONDITION_APPLE = 37139;
 pub const GL_SYNC_FENCE_APPLE = 37142;
 pub const GL_SYNC_FLAGS_APPLE = 37141;
+pub const GL_SYNC_FLUSH_COMMANDS_BIT = 1;
 pub const GL_SYNC_FLUSH_COMMANDS_BIT_APPLE = 1;
+pub const GL_SYNC_GPU_COMMANDS_COMPLETE = 37143;
 pub const GL_SYNC_GPU_COMMANDS_COMPLETE_APPLE = 37143;
 pub const GL_SYNC_OBJECT_APPLE = 35411;
 pub const GL_SYNC_STATUS_APPLE = 37140;
@@ -1738,6 +1751,7 @@ pub const GL_TEXTURE_IMMUTABLE_LEVELS = 33503;
 pub const GL_TEXTURE_INTERNAL_FORMAT_QCOM = 35797;
 pub const GL_TEXTURE_MAG_FILTER = 10240;
 pub const GL_TEXTURE_MAX_ANISOTROPY_EXT = 34046;
+pub const GL_TEXTURE_MAX_LEVEL = 33085;
 pub const GL_TEXTURE_MAX_LEVEL_APPLE = 33085;
 pub const GL_TEXTURE_MIN_FILTER = 10241;
 pub const GL_TEXTURE_NUM_LEVELS_QCOM = 35801;
@@ -1822,6 +1836,8 @@ pub const GL_UNDEFINED_VERTEX_EXT = 33376;
 pub const GL_UNDEFINED_VERTEX_OES = 33376;
 pub const GL_UNIFORM_BLOCK_REFERENCED_BY_MESH_SHADER_NV = 38300;
 pub const GL_UNIFORM_BLOCK_REFERENCED_BY_TASK_SHADER_NV = 38301;
+pub const GL_UNIFORM_BUFFER = 35345;
+pub const GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT = 35380;
 pub const GL_UNKNOWN_CONTEXT_RESET_EXT = 33365;
 pub const GL_UNKNOWN_CONTEXT_RESET_KHR = 33365;
 pub const GL_UNPACK_ALIGNMENT = 3317;
@@ -1920,6 +1936,7 @@ pub const GL_VIRTUAL_PAGE_SIZE_Y_EXT = 37270;
 pub const GL_VIRTUAL_PAGE_SIZE_Z_EXT = 37271;
 pub const GL_VIV_shader_binary = 1;
 pub const GL_VIVIDLIGHT_NV = 37542;
+pub const GL_WAIT_FAILED = 37149;
 pub const GL_WAIT_FAILED_APPLE = 37149;
 pub const GL_WEIGHTED_AVERAGE_EXT = 37735;
 pub const GL_WINDOW_RECTANGLE_EXT = 36626;
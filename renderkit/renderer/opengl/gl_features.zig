@@ -0,0 +1,169 @@
+const std = @import("std");
+usingnamespace @import("gl_decls.zig");
+
+/// optional GL features, detected once at setup from the context version and extension list. A feature is only enabled
+/// when the loader also found every function it needs.
+pub const Features = struct {
+    major_version: GLint = 0,
+    minor_version: GLint = 0,
+    /// glVertexAttribFormat/glBindVertexBuffer (GL 4.3 or ARB_vertex_attrib_binding)
+    vertex_attrib_binding: bool = false,
+    /// glBindBufferRange/glUniformBlockBinding (GL 3.1 or ARB_uniform_buffer_object)
+    uniform_buffer: bool = false,
+    /// glMapBufferRange (GL 3.0 or ARB_map_buffer_range)
+    map_buffer_range: bool = false,
+    /// glFenceSync/glClientWaitSync (GL 3.2 or ARB_sync)
+    fence_sync: bool = false,
+    /// persistently mapped glBufferStorage buffers guarded by fences (GL 4.4 or ARB_buffer_storage)
+    buffer_storage: bool = false,
+    /// GL_R8/GL_RG8 textures (GL 3.0 or ARB_texture_rg)
+    texture_rg: bool = false,
+    /// sized GL_RGB565 textures (GL 4.1 or ARB_ES2_compatibility)
+    rgb565: bool = false,
+    /// bc1/bc3 textures (EXT_texture_compression_s3tc)
+    s3tc: bool = false,
+    /// bc7 textures (GL 4.2 or ARB_texture_compression_bptc)
+    bptc: bool = false,
+    /// etc2 textures (GL 4.3 or ARB_ES3_compatibility)
+    etc2: bool = false,
+    /// astc textures (KHR_texture_compression_astc_ldr)
+    astc: bool = false,
+    /// GL_TEXTURE_MAX_ANISOTROPY (GL 4.6, ARB_ or EXT_texture_filter_anisotropic), up to `max_anisotropy` samples
+    anisotropy: bool = false,
+    max_anisotropy: GLint = 1,
+    /// glGenSamplers/glBindSampler (GL 3.3 or ARB_sampler_objects)
+    sampler_objects: bool = false,
+    /// glGetProgramBinary/glProgramBinary with at least one binary format (GL 4.1 or ARB_get_program_binary)
+    program_binary: bool = false,
+    /// compiles and links in the background, polled with GL_COMPLETION_STATUS_KHR (KHR_ or ARB_parallel_shader_compile)
+    parallel_shader_compile: bool = false,
+    /// creates and updates objects by name without binding them (GL 4.5 or ARB_direct_state_access)
+    direct_state_access: bool = false,
+    /// glMultiDrawElementsIndirect reading commands from a GL_DRAW_INDIRECT_BUFFER (GL 4.3 or ARB_multi_draw_indirect)
+    multi_draw_indirect: bool = false,
+    /// glMultiDrawElements with client side count and offset arrays (desktop GL 1.4)
+    multi_draw: bool = false,
+    /// glDrawElementsBaseVertex/glDrawElementsInstancedBaseVertex (GL 3.2 or ARB_draw_elements_base_vertex)
+    draw_base_vertex: bool = false,
+    /// glDrawElementsInstancedBaseVertexBaseInstance (GL 4.2 or ARB_base_instance)
+    base_instance: bool = false,
+
+    pub fn detect() Features {
+        var self = Features{};
+        glGetIntegerv(GL_MAJOR_VERSION, &self.major_version);
+        glGetIntegerv(GL_MINOR_VERSION, &self.minor_version);
+        // contexts older than 3.0 don't know GL_MAJOR_VERSION and leave it untouched
+        if (self.major_version == 0 and !hasFunction("glGetStringi")) return self;
+
+        self.vertex_attrib_binding = (self.atLeast(4, 3) or hasExtension("GL_ARB_vertex_attrib_binding")) and
+            hasFunction("glVertexAttribFormat") and
+            hasFunction("glVertexAttribBinding") and
+            hasFunction("glBindVertexBuffer") and
+            hasFunction("glVertexBindingDivisor");
+
+        self.uniform_buffer = (self.atLeast(3, 1) or hasExtension("GL_ARB_uniform_buffer_object")) and
+            hasFunction("glBindBufferRange") and
+            hasFunction("glGetUniformBlockIndex") and
+            hasFunction("glUniformBlockBinding");
+
+        self.map_buffer_range = (self.atLeast(3, 0) or hasExtension("GL_ARB_map_buffer_range")) and
+            hasFunction("glMapBufferRange") and
+            hasFunction("glUnmapBuffer");
+
+        self.fence_sync = (self.atLeast(3, 2) or hasExtension("GL_ARB_sync")) and
+            hasFunction("glFenceSync") and
+            hasFunction("glClientWaitSync") and
+            hasFunction("glDeleteSync");
+
+        self.buffer_storage = (self.atLeast(4, 4) or hasExtension("GL_ARB_buffer_storage")) and
+            self.map_buffer_range and
+            self.fence_sync and
+            hasFunction("glBufferStorage");
+
+        self.texture_rg = self.atLeast(3, 0) or hasExtension("GL_ARB_texture_rg");
+        self.rgb565 = self.atLeast(4, 1) or hasExtension("GL_ARB_ES2_compatibility");
+        self.s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+        self.bptc = self.atLeast(4, 2) or hasExtension("GL_ARB_texture_compression_bptc");
+        self.etc2 = self.atLeast(4, 3) or hasExtension("GL_ARB_ES3_compatibility");
+        self.astc = hasExtension("GL_KHR_texture_compression_astc_ldr");
+
+        self.anisotropy = self.atLeast(4, 6) or
+            hasExtension("GL_ARB_texture_filter_anisotropic") or
+            hasExtension("GL_EXT_texture_filter_anisotropic");
+        if (self.anisotropy) glGetIntegerv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &self.max_anisotropy);
+
+        self.sampler_objects = (self.atLeast(3, 3) or hasExtension("GL_ARB_sampler_objects")) and
+            hasFunction("glGenSamplers") and
+            hasFunction("glDeleteSamplers") and
+            hasFunction("glBindSampler") and
+            hasFunction("glSamplerParameteri");
+
+        self.program_binary = (self.atLeast(4, 1) or hasExtension("GL_ARB_get_program_binary")) and
+            hasFunction("glGetProgramBinary") and
+            hasFunction("glProgramBinary") and
+            hasFunction("glProgramParameteri");
+        if (self.program_binary) {
+            // some drivers expose the functions but can't hand out any binaries
+            var num_formats: GLint = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &num_formats);
+            self.program_binary = num_formats > 0;
+        }
+
+        self.parallel_shader_compile = hasExtension("GL_KHR_parallel_shader_compile") or
+            hasExtension("GL_ARB_parallel_shader_compile");
+
+        self.direct_state_access = (self.atLeast(4, 5) or hasExtension("GL_ARB_direct_state_access")) and
+            hasFunction("glCreateTextures") and
+            hasFunction("glTextureStorage2D") and
+            hasFunction("glTextureSubImage2D") and
+            hasFunction("glCompressedTextureSubImage2D") and
+            hasFunction("glTextureParameteri") and
+            hasFunction("glGenerateTextureMipmap") and
+            hasFunction("glCreateBuffers") and
+            hasFunction("glNamedBufferData") and
+            hasFunction("glNamedBufferSubData") and
+            hasFunction("glNamedBufferStorage") and
+            hasFunction("glMapNamedBufferRange") and
+            hasFunction("glUnmapNamedBuffer") and
+            hasFunction("glCreateFramebuffers") and
+            hasFunction("glNamedFramebufferTexture") and
+            hasFunction("glNamedFramebufferRenderbuffer") and
+            hasFunction("glNamedFramebufferDrawBuffers") and
+            hasFunction("glCheckNamedFramebufferStatus") and
+            hasFunction("glCreateRenderbuffers") and
+            hasFunction("glNamedRenderbufferStorage");
+
+        self.multi_draw_indirect = (self.atLeast(4, 3) or hasExtension("GL_ARB_multi_draw_indirect")) and
+            hasFunction("glMultiDrawElementsIndirect");
+        self.multi_draw = hasFunction("glMultiDrawElements");
+
+        self.draw_base_vertex = (self.atLeast(3, 2) or hasExtension("GL_ARB_draw_elements_base_vertex")) and
+            hasFunction("glDrawElementsBaseVertex") and
+            hasFunction("glDrawElementsInstancedBaseVertex");
+        self.base_instance = (self.atLeast(4, 2) or hasExtension("GL_ARB_base_instance")) and
+            self.draw_base_vertex and
+            hasFunction("glDrawElementsInstancedBaseVertexBaseInstance");
+        // the base instance field of indirect commands is only honoured with base instance support
+        self.multi_draw_indirect = self.multi_draw_indirect and self.base_instance;
+
+        return self;
+    }
+
+    pub fn atLeast(self: Features, major: GLint, minor: GLint) bool {
+        return self.major_version > major or (self.major_version == major and self.minor_version >= minor);
+    }
+};
+
+pub fn hasExtension(name: []const u8) bool {
+    if (!hasFunction("glGetStringi")) return false;
+
+    var count: GLint = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    var i: GLuint = 0;
+    while (i < @intCast(GLuint, count)) : (i += 1) {
+        const ext = glGetStringi(GL_EXTENSIONS, i);
+        if (std.mem.eql(u8, std.mem.spanZ(ext), name)) return true;
+    }
+    return false;
+}
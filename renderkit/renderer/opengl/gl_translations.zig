@@ -22,6 +22,22 @@ pub fn blendFactorToGl(state: renderkit.BlendFactor) GLenum {
     };
 }
 
+pub fn minFilterToGl(filter: renderkit.TextureFilter, mip_filter: renderkit.MipFilter) GLint {
+    return switch (mip_filter) {
+        .none => if (filter == .nearest) GL_NEAREST else GL_LINEAR,
+        .nearest => if (filter == .nearest) GL_NEAREST_MIPMAP_NEAREST else GL_LINEAR_MIPMAP_NEAREST,
+        .linear => if (filter == .nearest) GL_NEAREST_MIPMAP_LINEAR else GL_LINEAR_MIPMAP_LINEAR,
+    };
+}
+
+pub fn magFilterToGl(filter: renderkit.TextureFilter) GLint {
+    return if (filter == .nearest) GL_NEAREST else GL_LINEAR;
+}
+
+pub fn wrapToGl(wrap: renderkit.TextureWrap) GLint {
+    return if (wrap == .clamp) GL_CLAMP_TO_EDGE else GL_REPEAT;
+}
+
 pub fn compareFuncToGl(state: renderkit.CompareFunc) GLenum {
     return switch (state) {
         .never => GL_NEVER,
@@ -55,3 +71,42 @@ pub fn blendOpToGl(state: renderkit.BlendOp) GLenum {
         .reverse_subtract => GL_FUNC_REVERSE_SUBTRACT,
     };
 }
+
+pub fn primitiveTypeToGl(primitive_type: renderkit.PrimitiveType) GLenum {
+    return switch (primitive_type) {
+        .points => GL_POINTS,
+        .line_strip => GL_LINE_STRIP,
+        .lines => GL_LINES,
+        .triangle_strip => GL_TRIANGLE_STRIP,
+        .triangles => GL_TRIANGLES,
+    };
+}
+
+pub const TextureFormat = struct {
+    internal_format: GLenum,
+    format: GLenum = 0, // format and type are unused by compressed formats
+    kind: GLenum = 0,
+};
+
+pub fn pixelFormatToGl(format: renderkit.PixelFormat) TextureFormat {
+    return switch (format) {
+        .rgba8 => .{ .internal_format = GL_RGBA, .format = GL_RGBA, .kind = GL_UNSIGNED_BYTE },
+        .r8 => .{ .internal_format = GL_R8_EXT, .format = GL_RED_EXT, .kind = GL_UNSIGNED_BYTE },
+        .rg8 => .{ .internal_format = GL_RG8_EXT, .format = GL_RG_EXT, .kind = GL_UNSIGNED_BYTE },
+        .rgb565 => .{ .internal_format = GL_RGB565, .format = GL_RGB, .kind = GL_UNSIGNED_SHORT_5_6_5 },
+        .bc1 => .{ .internal_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT },
+        .bc3 => .{ .internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT },
+        .bc7 => .{ .internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM_EXT },
+        .etc2_rgb8 => .{ .internal_format = GL_COMPRESSED_RGB8_ETC2 },
+        .etc2_rgba8 => .{ .internal_format = GL_COMPRESSED_RGBA8_ETC2_EAC },
+        .astc_4x4 => .{ .internal_format = GL_COMPRESSED_RGBA_ASTC_4x4_KHR },
+        // renderbuffer formats, see createImage
+        .stencil => .{ .internal_format = GL_STENCIL_INDEX8 },
+        .depth_stencil => .{ .internal_format = GL_DEPTH24_STENCIL8_OES },
+    };
+}
+
+/// internal format for immutable texture storage, which only takes sized formats
+pub fn sizedInternalFormat(format: renderkit.PixelFormat) GLenum {
+    return if (format == .rgba8) GL_RGBA8_OES else pixelFormatToGl(format).internal_format;
+}
@@ -0,0 +1,70 @@
+const std = @import("std");
+const FrameFences = @import("frame_fences.zig").FrameFences;
+usingnamespace @import("gl_decls.zig");
+
+/// a GL_PIXEL_UNPACK_BUFFER split into a region per frame that asynchronous image uploads are staged through. Texture
+/// uploads sourced from an unpack buffer return without waiting for the transfer. When persistently mapped the frame
+/// fences guarantee the GPU is done with a region before it is written again, otherwise data goes in with
+/// glBufferSubData and the driver handles syncing. A region that fills up grows the whole ring.
+pub const PixelUnpackRing = struct {
+    pub const min_region_size: u32 = 4 * 1024 * 1024;
+    const num_regions = FrameFences.num_regions;
+    const alignment = 16;
+
+    buffer: GLuint = 0,
+    region_size: u32 = 0,
+    mapped: ?[*]u8 = null,
+    cursor: u32 = 0,
+    frame: u32 = 0,
+
+    /// copies `bytes` into the current frame's region and returns their offset in the buffer, which is left bound to
+    /// GL_PIXEL_UNPACK_BUFFER. The caller must unbind it once the texture upload is issued. Replaced buffers are
+    /// handed to `release` since the GPU may still be reading them.
+    pub fn upload(self: *PixelUnpackRing, bytes: []const u8, frame_index: u32, persistent: bool, release: fn (buffer: GLuint) void) u32 {
+        const num_bytes = @intCast(u32, bytes.len);
+        const region = frame_index % num_regions;
+        if (self.frame != frame_index) {
+            self.frame = frame_index;
+            self.cursor = region * self.region_size;
+        }
+
+        var offset = std.mem.alignForwardGeneric(u32, self.cursor, alignment);
+        if (self.buffer == 0 or offset + num_bytes > (region + 1) * self.region_size) {
+            var region_size = std.math.max(self.region_size * 2, min_region_size);
+            while (region_size < num_bytes) region_size *= 2;
+            self.grow(region_size, persistent, release);
+            offset = region * self.region_size;
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, self.buffer);
+        }
+
+        if (self.mapped) |mapped| {
+            std.mem.copy(u8, mapped[offset .. offset + num_bytes], bytes);
+        } else {
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, offset, num_bytes, bytes.ptr);
+        }
+        self.cursor = offset + num_bytes;
+        return offset;
+    }
+
+    fn grow(self: *PixelUnpackRing, region_size: u32, persistent: bool, release: fn (buffer: GLuint) void) void {
+        self.region_size = region_size;
+        const total_size = @intCast(GLsizeiptr, region_size * num_regions);
+
+        if (persistent) {
+            // immutable storage can't be resized so the mapped buffer is replaced
+            if (self.buffer != 0) release(self.buffer);
+            glGenBuffers(1, &self.buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, self.buffer);
+
+            const map_flags: GLbitfield = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, total_size, null, map_flags);
+            self.mapped = @ptrCast([*]u8, glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, total_size, map_flags));
+        } else {
+            // orphaning keeps the storage of uploads already issued alive until the GPU is done with them
+            if (self.buffer == 0) glGenBuffers(1, &self.buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, self.buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, total_size, null, GL_STREAM_DRAW);
+        }
+    }
+};
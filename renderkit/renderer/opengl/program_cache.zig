@@ -0,0 +1,105 @@
+const std = @import("std");
+const renderkit = @import("../descriptions.zig");
+usingnamespace @import("gl_decls.zig");
+
+/// linked program binaries stored on disk, one file per program. Files are named after a hash of the shader sources,
+/// the image names and the GL_RENDERER/GL_VERSION strings so a driver update or a shader edit never loads a stale
+/// binary. The driver can still reject a binary, in which case the file is deleted and the program is built from source.
+pub const ProgramCache = struct {
+    const magic: u32 = 0x4E494252; // "RBIN"
+
+    const Header = extern struct {
+        magic: u32 = magic,
+        format: GLenum,
+        length: u32,
+    };
+
+    allocator: *std.mem.Allocator,
+    dir: std.fs.Dir,
+    /// hash of the renderer and version strings, the seed for every key
+    driver_hash: u64,
+
+    /// opens or creates `path`. Returns null if the directory can't be used, the cache is then simply off.
+    pub fn init(allocator: *std.mem.Allocator, path: []const u8) ?ProgramCache {
+        const dir = std.fs.cwd().makeOpenPath(path, .{}) catch |err| {
+            std.debug.print("program cache disabled, could not open {}: {}\n", .{ path, err });
+            return null;
+        };
+
+        var hasher = std.hash.Wyhash.init(0);
+        hasher.update(std.mem.spanZ(glGetString(GL_RENDERER)));
+        hasher.update(std.mem.spanZ(glGetString(GL_VERSION)));
+        return ProgramCache{ .allocator = allocator, .dir = dir, .driver_hash = hasher.final() };
+    }
+
+    pub fn deinit(self: *ProgramCache) void {
+        self.dir.close();
+    }
+
+    pub fn key(self: ProgramCache, desc: renderkit.ShaderDesc) u64 {
+        var hasher = std.hash.Wyhash.init(self.driver_hash);
+        hasher.update(desc.vs);
+        hasher.update(&[_]u8{0});
+        hasher.update(desc.fs);
+        for (desc.images) |image| {
+            hasher.update(&[_]u8{0});
+            hasher.update(image);
+        }
+        return hasher.final();
+    }
+
+    /// creates a program from the binary stored for `program_key`
+    pub fn load(self: *ProgramCache, program_key: u64) error{ Missing, Rejected }!GLuint {
+        var name_buf: [32]u8 = undefined;
+        const name = fileName(&name_buf, program_key);
+        const bytes = self.dir.readFileAlloc(self.allocator, name, 64 * 1024 * 1024) catch return error.Missing;
+        defer self.allocator.free(bytes);
+
+        if (bytes.len < @sizeOf(Header)) return self.reject(name);
+        const header = std.mem.bytesToValue(Header, bytes[0..@sizeOf(Header)]);
+        if (header.magic != magic or header.length != bytes.len - @sizeOf(Header)) return self.reject(name);
+
+        const program = glCreateProgram();
+        glProgramBinary(program, header.format, bytes[@sizeOf(Header)..].ptr, @intCast(GLsizei, header.length));
+
+        var status: GLint = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE) {
+            glDeleteProgram(program);
+            return self.reject(name);
+        }
+        return program;
+    }
+
+    /// writes the binary of a freshly linked program. Failing to write only costs a compile at the next launch.
+    pub fn store(self: *ProgramCache, program_key: u64, program: GLuint) void {
+        var length: GLint = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+        if (length <= 0) return;
+
+        var bytes = self.allocator.alloc(u8, @sizeOf(Header) + @intCast(usize, length)) catch return;
+        defer self.allocator.free(bytes);
+
+        var format: GLenum = 0;
+        var written: GLsizei = 0;
+        glGetProgramBinary(program, length, &written, &format, bytes[@sizeOf(Header)..].ptr);
+        if (written <= 0) return;
+
+        const header = Header{ .format = format, .length = @intCast(u32, written) };
+        std.mem.copy(u8, bytes, std.mem.asBytes(&header));
+
+        var name_buf: [32]u8 = undefined;
+        self.dir.writeFile(fileName(&name_buf, program_key), bytes[0 .. @sizeOf(Header) + @intCast(usize, written)]) catch |err| {
+            std.debug.print("could not write program binary: {}\n", .{err});
+        };
+    }
+
+    fn reject(self: *ProgramCache, name: []const u8) error{Rejected} {
+        self.dir.deleteFile(name) catch {};
+        return error.Rejected;
+    }
+
+    fn fileName(buf: []u8, program_key: u64) []const u8 {
+        return std.fmt.bufPrint(buf, "{x:0>16}.glbin", .{program_key}) catch unreachable;
+    }
+};
@@ -0,0 +1,89 @@
+const std = @import("std");
+usingnamespace @import("gl_decls.zig");
+
+/// number of frames the GPU can lag behind the CPU. Matches NUM_INFLIGHT_FRAMES on the Metal backend.
+pub const num_inflight_frames: u32 = 1;
+
+/// deferred deletion of GL objects, modeled after the Metal idpool release queue. Destroying a resource only pushes its
+/// GL name onto the queue for its kind along with the frame index at which it is safe to delete it. `collect` is called
+/// once per frame and issues a single batched glDelete* call per kind for everything that has aged out.
+pub const ReleaseQueue = struct {
+    pub const Kind = enum {
+        texture,
+        renderbuffer,
+        buffer,
+        framebuffer,
+        vertex_array,
+        program,
+    };
+
+    const Queue = struct {
+        ids: std.ArrayList(GLuint),
+        frames: std.ArrayList(u32), // frame index at which it is safe to release the matching id
+    };
+
+    queues: [@typeInfo(Kind).Enum.fields.len]Queue,
+
+    pub fn init(allocator: *std.mem.Allocator) ReleaseQueue {
+        var self: ReleaseQueue = undefined;
+        for (self.queues) |*queue| {
+            queue.ids = std.ArrayList(GLuint).init(allocator);
+            queue.frames = std.ArrayList(u32).init(allocator);
+        }
+        return self;
+    }
+
+    /// frees the queue storage. Any pending items are leaked so `collectAll` should be called first.
+    pub fn deinit(self: ReleaseQueue) void {
+        for (self.queues) |queue| {
+            queue.ids.deinit();
+            queue.frames.deinit();
+        }
+    }
+
+    /// queues the GL object for deletion once `frame_index` is no longer in flight. The lists keep their capacity so
+    /// after the first few frames this never allocates.
+    pub fn push(self: *ReleaseQueue, kind: Kind, id: GLuint, frame_index: u32) void {
+        if (id == 0) return;
+
+        var queue = &self.queues[@enumToInt(kind)];
+        queue.ids.append(id) catch unreachable;
+        queue.frames.append(frame_index + num_inflight_frames + 1) catch unreachable;
+    }
+
+    /// deletes every queued object that is safe to release at `frame_index`
+    pub fn collect(self: *ReleaseQueue, frame_index: u32) void {
+        for (self.queues) |*queue, i| {
+            // items are pushed in frame order so only a prefix of each queue can be ready
+            var count: usize = 0;
+            while (count < queue.frames.items.len and queue.frames.items[count] <= frame_index) count += 1;
+            if (count == 0) continue;
+
+            deleteObjects(@intToEnum(Kind, @intCast(@TagType(Kind), i)), queue.ids.items[0..count]);
+
+            const remaining = queue.ids.items.len - count;
+            std.mem.copy(GLuint, queue.ids.items[0..remaining], queue.ids.items[count..]);
+            std.mem.copy(u32, queue.frames.items[0..remaining], queue.frames.items[count..]);
+            queue.ids.items.len = remaining;
+            queue.frames.items.len = remaining;
+        }
+    }
+
+    /// deletes everything in the queue regardless of frame. Used at shutdown.
+    pub fn collectAll(self: *ReleaseQueue) void {
+        self.collect(std.math.maxInt(u32));
+    }
+
+    fn deleteObjects(kind: Kind, ids: []GLuint) void {
+        const n = @intCast(GLsizei, ids.len);
+        switch (kind) {
+            .texture => glDeleteTextures(n, ids.ptr),
+            .renderbuffer => glDeleteRenderbuffers(n, ids.ptr),
+            .buffer => glDeleteBuffers(n, ids.ptr),
+            .framebuffer => glDeleteFramebuffers(n, ids.ptr),
+            .vertex_array => glDeleteVertexArrays(n, ids.ptr),
+            // there is no batched delete for programs
+            .program => for (ids) |id| glDeleteProgram(id),
+        }
+    }
+};
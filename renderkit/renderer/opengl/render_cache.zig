@@ -1,21 +1,237 @@
 const std = @import("std");
+const renderkit = @import("../types.zig");
+const translations = @import("gl_translations.zig");
 usingnamespace @import("gl_decls.zig");
 
+/// shadow copy of all the GL state the backend touches. Every setter compares against the shadow and skips the GL call
+/// when nothing changed. State that is marked dirty has an unknown GL value and is always sent on the next set.
 pub const RenderCache = struct {
+    /// one bit per piece of shadowed GL state
+    const Dirty = struct {
+        const depth_mask: u32 = 1 << 0;
+        const depth_func: u32 = 1 << 1;
+        const stencil_test: u32 = 1 << 2;
+        const stencil_mask: u32 = 1 << 3;
+        const stencil_func: u32 = 1 << 4;
+        const stencil_op: u32 = 1 << 5;
+        const blend: u32 = 1 << 6;
+        const blend_func: u32 = 1 << 7;
+        const blend_equation: u32 = 1 << 8;
+        const color_mask: u32 = 1 << 9;
+        const blend_color: u32 = 1 << 10;
+        const scissor_test: u32 = 1 << 11;
+        const viewport: u32 = 1 << 12;
+        const scissor: u32 = 1 << 13;
+        const active_texture: u32 = 1 << 14;
+        const program: u32 = 1 << 15;
+        const vertex_array: u32 = 1 << 16;
+        const array_buffer: u32 = 1 << 17;
+        const element_buffer: u32 = 1 << 18;
+        const framebuffer: u32 = 1 << 19;
+        const clear_color: u32 = 1 << 20;
+        const clear_depth: u32 = 1 << 21;
+        const clear_stencil: u32 = 1 << 22;
+        const uniform_buffers: u32 = 1 << 23;
+        const texture0: u32 = 1 << 24; // texture slots use the top 8 bits
+        const all: u32 = std.math.maxInt(u32);
+    };
+
+    dirty: u32 = Dirty.all,
     vao: GLuint = 0,
     vbo: GLuint = 0,
     ebo: GLuint = 0,
     shader: GLuint = 0,
+    framebuffer: GLuint = 0,
+    active_texture: GLenum = GL_TEXTURE0,
     textures: [8]c_uint = [_]c_uint{0} ** 8,
+    samplers: [8]GLuint = [_]GLuint{0} ** 8,
+    /// sampler units don't fit in `dirty`, so they get their own bits
+    dirty_samplers: u8 = 0xFF,
+    render_state: renderkit.RenderState = .{},
+    viewport: [4]c_int = [_]c_int{0} ** 4,
+    scissor: [4]c_int = [_]c_int{0} ** 4,
+    clear_color: [4]f32 = [_]f32{0} ** 4,
+    clear_depth: f64 = 0,
+    clear_stencil: u8 = 0,
+    uniform_buffers: [4]BufferRange = [_]BufferRange{.{}} ** 4,
+
+    const BufferRange = struct {
+        buffer: GLuint = 0,
+        offset: u32 = 0,
+        size: u32 = 0,
+    };
 
     pub fn init() RenderCache {
         return .{};
     }
 
-    pub fn bindVertexArray(self: *@This(), vao: GLuint) void {
-        if (self.vao != vao) {
+    /// marks all state as unknown so that the next set of each piece of state goes to GL. Call this after any code
+    /// outside of RenderKit (an imgui integration for example) has touched GL state.
+    pub fn reset(self: *@This()) void {
+        self.dirty = Dirty.all;
+        self.dirty_samplers = 0xFF;
+    }
+
+    /// returns true if the state must be sent to GL and clears its dirty bit
+    fn needsUpdate(self: *@This(), bit: u32, changed: bool) bool {
+        if (!changed and self.dirty & bit == 0) return false;
+        self.dirty &= ~bit;
+        return true;
+    }
+
+    pub fn setRenderState(self: *@This(), state: renderkit.RenderState) void {
+        var cur = &self.render_state;
+
+        // depth
+        if (self.needsUpdate(Dirty.depth_mask, state.depth.enabled != cur.depth.enabled)) {
+            glDepthMask(if (state.depth.enabled) 1 else 0);
+            cur.depth.enabled = state.depth.enabled;
+        }
+
+        if (self.needsUpdate(Dirty.depth_func, state.depth.compare_func != cur.depth.compare_func)) {
+            glDepthFunc(translations.compareFuncToGl(state.depth.compare_func));
+            cur.depth.compare_func = state.depth.compare_func;
+        }
+
+        // stencil
+        if (self.needsUpdate(Dirty.stencil_test, state.stencil.enabled != cur.stencil.enabled)) {
+            if (state.stencil.enabled) glEnable(GL_STENCIL_TEST) else glDisable(GL_STENCIL_TEST);
+            cur.stencil.enabled = state.stencil.enabled;
+        }
+
+        if (self.needsUpdate(Dirty.stencil_mask, state.stencil.write_mask != cur.stencil.write_mask)) {
+            glStencilMask(@intCast(GLuint, state.stencil.write_mask));
+            cur.stencil.write_mask = state.stencil.write_mask;
+        }
+
+        const stencil_func_changed = state.stencil.compare_func != cur.stencil.compare_func or
+            state.stencil.read_mask != cur.stencil.read_mask or
+            state.stencil.ref != cur.stencil.ref;
+        if (self.needsUpdate(Dirty.stencil_func, stencil_func_changed)) {
+            glStencilFuncSeparate(GL_FRONT, translations.compareFuncToGl(state.stencil.compare_func), @intCast(GLint, state.stencil.ref), @intCast(GLuint, state.stencil.read_mask));
+            cur.stencil.compare_func = state.stencil.compare_func;
+            cur.stencil.read_mask = state.stencil.read_mask;
+            cur.stencil.ref = state.stencil.ref;
+        }
+
+        const stencil_op_changed = state.stencil.fail_op != cur.stencil.fail_op or
+            state.stencil.depth_fail_op != cur.stencil.depth_fail_op or
+            state.stencil.pass_op != cur.stencil.pass_op;
+        if (self.needsUpdate(Dirty.stencil_op, stencil_op_changed)) {
+            glStencilOpSeparate(GL_FRONT, translations.stencilOpToGl(state.stencil.fail_op), translations.stencilOpToGl(state.stencil.depth_fail_op), translations.stencilOpToGl(state.stencil.pass_op));
+            cur.stencil.fail_op = state.stencil.fail_op;
+            cur.stencil.depth_fail_op = state.stencil.depth_fail_op;
+            cur.stencil.pass_op = state.stencil.pass_op;
+        }
+
+        // blend
+        if (self.needsUpdate(Dirty.blend, state.blend.enabled != cur.blend.enabled)) {
+            if (state.blend.enabled) glEnable(GL_BLEND) else glDisable(GL_BLEND);
+            cur.blend.enabled = state.blend.enabled;
+        }
+
+        const blend_func_changed = state.blend.src_factor_rgb != cur.blend.src_factor_rgb or
+            state.blend.dst_factor_rgb != cur.blend.dst_factor_rgb or
+            state.blend.src_factor_alpha != cur.blend.src_factor_alpha or
+            state.blend.dst_factor_alpha != cur.blend.dst_factor_alpha;
+        if (self.needsUpdate(Dirty.blend_func, blend_func_changed)) {
+            glBlendFuncSeparate(translations.blendFactorToGl(state.blend.src_factor_rgb), translations.blendFactorToGl(state.blend.dst_factor_rgb), translations.blendFactorToGl(state.blend.src_factor_alpha), translations.blendFactorToGl(state.blend.dst_factor_alpha));
+            cur.blend.src_factor_rgb = state.blend.src_factor_rgb;
+            cur.blend.dst_factor_rgb = state.blend.dst_factor_rgb;
+            cur.blend.src_factor_alpha = state.blend.src_factor_alpha;
+            cur.blend.dst_factor_alpha = state.blend.dst_factor_alpha;
+        }
+
+        if (self.needsUpdate(Dirty.blend_equation, state.blend.op_rgb != cur.blend.op_rgb or state.blend.op_alpha != cur.blend.op_alpha)) {
+            glBlendEquationSeparate(translations.blendOpToGl(state.blend.op_rgb), translations.blendOpToGl(state.blend.op_alpha));
+            cur.blend.op_rgb = state.blend.op_rgb;
+            cur.blend.op_alpha = state.blend.op_alpha;
+        }
+
+        if (self.needsUpdate(Dirty.color_mask, state.blend.color_write_mask != cur.blend.color_write_mask)) {
+            const r = (@enumToInt(state.blend.color_write_mask) & @enumToInt(renderkit.ColorMask.r)) != 0;
+            const g = (@enumToInt(state.blend.color_write_mask) & @enumToInt(renderkit.ColorMask.g)) != 0;
+            const b = (@enumToInt(state.blend.color_write_mask) & @enumToInt(renderkit.ColorMask.b)) != 0;
+            const a = (@enumToInt(state.blend.color_write_mask) & @enumToInt(renderkit.ColorMask.a)) != 0;
+            glColorMask(if (r) 1 else 0, if (g) 1 else 0, if (b) 1 else 0, if (a) 1 else 0);
+            cur.blend.color_write_mask = state.blend.color_write_mask;
+        }
+
+        if (self.needsUpdate(Dirty.blend_color, !std.mem.eql(f32, &state.blend.color, &cur.blend.color))) {
+            glBlendColor(state.blend.color[0], state.blend.color[1], state.blend.color[2], state.blend.color[3]);
+            cur.blend.color = state.blend.color;
+        }
+
+        // scissor
+        if (self.needsUpdate(Dirty.scissor_test, state.scissor != cur.scissor)) {
+            if (state.scissor) glEnable(GL_SCISSOR_TEST) else glDisable(GL_SCISSOR_TEST);
+            cur.scissor = state.scissor;
+        }
+    }
+
+    pub fn setViewport(self: *@This(), x: c_int, y: c_int, width: c_int, height: c_int) void {
+        const rect = [4]c_int{ x, y, width, height };
+        if (self.needsUpdate(Dirty.viewport, !std.mem.eql(c_int, &rect, &self.viewport))) {
+            glViewport(x, y, width, height);
+            self.viewport = rect;
+        }
+    }
+
+    pub fn setScissor(self: *@This(), x: c_int, y: c_int, width: c_int, height: c_int) void {
+        const rect = [4]c_int{ x, y, width, height };
+        if (self.needsUpdate(Dirty.scissor, !std.mem.eql(c_int, &rect, &self.scissor))) {
+            glScissor(x, y, width, height);
+            self.scissor = rect;
+        }
+    }
+
+    pub fn setClearColor(self: *@This(), color: [4]f32) void {
+        if (self.needsUpdate(Dirty.clear_color, !std.mem.eql(f32, &color, &self.clear_color))) {
+            glClearColor(color[0], color[1], color[2], color[3]);
+            self.clear_color = color;
+        }
+    }
+
+    pub fn setClearDepth(self: *@This(), depth: f64) void {
+        if (self.needsUpdate(Dirty.clear_depth, depth != self.clear_depth)) {
+            glClearDepth(depth);
+            self.clear_depth = depth;
+        }
+    }
+
+    pub fn setClearStencil(self: *@This(), stencil: u8) void {
+        if (self.needsUpdate(Dirty.clear_stencil, stencil != self.clear_stencil)) {
+            glClearStencil(@intCast(GLint, stencil));
+            self.clear_stencil = stencil;
+        }
+    }
+
+    pub fn bindFramebuffer(self: *@This(), framebuffer: GLuint) void {
+        if (self.needsUpdate(Dirty.framebuffer, self.framebuffer != framebuffer)) {
+            self.framebuffer = framebuffer;
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        }
+    }
+
+    /// returns the bound framebuffer, only querying GL when the shadow value is unknown
+    pub fn currentFramebuffer(self: *@This()) GLuint {
+        if (self.dirty & Dirty.framebuffer != 0) {
+            var fb: GLint = 0;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fb);
+            self.framebuffer = @intCast(GLuint, fb);
+            self.dirty &= ~Dirty.framebuffer;
+        }
+        return self.framebuffer;
+    }
+
+    /// `ebo` is the element buffer recorded in the VAO, which becomes the current element buffer binding
+    pub fn bindVertexArray(self: *@This(), vao: GLuint, ebo: GLuint) void {
+        if (self.needsUpdate(Dirty.vertex_array, self.vao != vao)) {
             self.vao = vao;
             glBindVertexArray(vao);
+
+            self.ebo = ebo;
+            self.dirty &= ~Dirty.element_buffer;
         }
     }
 
@@ -30,12 +246,12 @@ pub const RenderCache = struct {
         std.debug.assert(target == GL_ELEMENT_ARRAY_BUFFER or target == GL_ARRAY_BUFFER);
 
         if (target == GL_ELEMENT_ARRAY_BUFFER) {
-            if (self.ebo != buffer) {
+            if (self.needsUpdate(Dirty.element_buffer, self.ebo != buffer)) {
                 self.ebo = buffer;
                 glBindBuffer(target, buffer);
             }
         } else {
-            if (self.vbo != buffer) {
+            if (self.needsUpdate(Dirty.array_buffer, self.vbo != buffer)) {
                 self.vbo = buffer;
                 glBindBuffer(target, buffer);
             }
@@ -48,9 +264,11 @@ pub const RenderCache = struct {
 
         if (target == GL_ELEMENT_ARRAY_BUFFER) {
             self.ebo = buffer;
+            self.dirty &= ~Dirty.element_buffer;
             glBindBuffer(target, buffer);
         } else {
             self.vbo = buffer;
+            self.dirty &= ~Dirty.array_buffer;
             glBindBuffer(target, buffer);
         }
     }
@@ -66,26 +284,63 @@ pub const RenderCache = struct {
         }
     }
 
+    /// binds a range of `buffer` to the indexed GL_UNIFORM_BUFFER binding point
+    pub fn bindUniformBufferRange(self: *@This(), binding: GLuint, buffer: GLuint, offset: u32, size: u32) void {
+        const range = BufferRange{ .buffer = buffer, .offset = offset, .size = size };
+        const cur = &self.uniform_buffers[binding];
+        if (self.dirty & Dirty.uniform_buffers != 0) {
+            // one bit covers every binding point so they all have to be forgotten together
+            self.uniform_buffers = [_]BufferRange{.{}} ** 4;
+            self.dirty &= ~Dirty.uniform_buffers;
+        }
+
+        if (!std.meta.eql(cur.*, range)) {
+            glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+            cur.* = range;
+        }
+    }
+
+    /// forgets every uniform buffer range, for when the storage behind them was replaced
+    pub fn invalidateUniformBuffers(self: *@This()) void {
+        self.dirty |= Dirty.uniform_buffers;
+    }
+
+    pub fn setActiveTexture(self: *@This(), unit: GLenum) void {
+        if (self.needsUpdate(Dirty.active_texture, self.active_texture != unit)) {
+            self.active_texture = unit;
+            glActiveTexture(unit);
+        }
+    }
+
     pub fn bindImage(self: *@This(), tid: c_uint, slot: c_uint) void {
-        if (self.textures[slot] != tid) {
+        if (self.needsUpdate(Dirty.texture0 << @intCast(u5, slot), self.textures[slot] != tid)) {
             self.textures[slot] = tid;
-            glActiveTexture(GL_TEXTURE0 + slot);
+            self.setActiveTexture(GL_TEXTURE0 + slot);
             glBindTexture(GL_TEXTURE_2D, tid);
         }
     }
 
+    /// binds a sampler object to texture unit `slot`. 0 samples with the texture's own parameters.
+    pub fn bindSampler(self: *@This(), sampler: GLuint, slot: c_uint) void {
+        const bit = @as(u8, 1) << @intCast(u3, slot);
+        if (self.samplers[slot] == sampler and self.dirty_samplers & bit == 0) return;
+        self.dirty_samplers &= ~bit;
+        self.samplers[slot] = sampler;
+        glBindSampler(slot, sampler);
+    }
+
     pub fn invalidateTexture(self: *@This(), tid: c_uint) void {
         for (self.textures) |*tex, i| {
             if (tex.* == tid) {
                 tex.* = 0;
-                glActiveTexture(GL_TEXTURE0 + @intCast(c_uint, i));
-                glBindTexture(GL_TEXTURE_2D, tid);
+                self.setActiveTexture(GL_TEXTURE0 + @intCast(c_uint, i));
+                glBindTexture(GL_TEXTURE_2D, 0);
             }
         }
     }
 
     pub fn useShaderProgram(self: *@This(), program: GLuint) void {
-        if (self.shader != program) {
+        if (self.needsUpdate(Dirty.program, self.shader != program)) {
             self.shader = program;
             glUseProgram(program);
         }
@@ -0,0 +1,43 @@
+const std = @import("std");
+const renderkit = @import("../types.zig");
+const translations = @import("gl_translations.zig");
+usingnamespace @import("gl_decls.zig");
+
+/// GL sampler objects keyed by `SamplerDesc.key`. Samplers are created on first use and live until `deinit`, there are
+/// only a few thousand possible descriptions and real programs use a handful.
+pub const SamplerCache = struct {
+    samplers: std.AutoHashMap(u32, GLuint),
+    /// clamp for `SamplerDesc.max_anisotropy`, 1 when anisotropic filtering is unsupported
+    max_anisotropy: GLint,
+
+    pub fn init(allocator: *std.mem.Allocator, max_anisotropy: GLint) SamplerCache {
+        return .{
+            .samplers = std.AutoHashMap(u32, GLuint).init(allocator),
+            .max_anisotropy = max_anisotropy,
+        };
+    }
+
+    pub fn deinit(self: *SamplerCache) void {
+        var iter = self.samplers.iterator();
+        while (iter.next()) |entry| glDeleteSamplers(1, &entry.value);
+        self.samplers.deinit();
+    }
+
+    pub fn get(self: *SamplerCache, desc: renderkit.SamplerDesc) GLuint {
+        const result = self.samplers.getOrPut(desc.key()) catch unreachable;
+        if (result.found_existing) return result.entry.value;
+
+        var sampler: GLuint = 0;
+        glGenSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, translations.minFilterToGl(desc.min_filter, desc.mip_filter));
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, translations.magFilterToGl(desc.mag_filter));
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, translations.wrapToGl(desc.wrap_u));
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, translations.wrapToGl(desc.wrap_v));
+        if (desc.max_anisotropy > 1 and self.max_anisotropy > 1) {
+            glSamplerParameteri(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, std.math.min(desc.max_anisotropy, self.max_anisotropy));
+        }
+
+        result.entry.value = sampler;
+        return sampler;
+    }
+};
@@ -0,0 +1,148 @@
+const std = @import("std");
+
+/// comptime std140 layout of a uniform struct (GL 4.5 spec 7.6.2.2). Supports the same field types as the glUniform
+/// path: 4 byte scalars, structs of 2-4 f32 (vecN), structs holding a single [4]/[6]/[9]/[16]f32 array (column major
+/// mat2/mat3x2/mat3/mat4) and arrays of 4 byte scalars.
+pub fn Layout(comptime T: type) type {
+    const fields = @typeInfo(T).Struct.fields;
+
+    comptime var offsets: [fields.len]usize = undefined;
+    comptime var offset: usize = 0;
+    inline for (fields) |field, i| {
+        const field_layout = fieldLayout(field.field_type);
+        offset = std.mem.alignForward(offset, field_layout.alignment);
+        offsets[i] = offset;
+        offset += field_layout.size;
+    }
+    const total_size = std.mem.alignForward(offset, 16);
+
+    return struct {
+        pub const size = total_size;
+        pub const field_offsets = offsets;
+
+        /// writes `value` into `out`, zeroing the padding so equal values always produce equal bytes
+        pub fn write(value: *const T, out: *[size]u8) void {
+            std.mem.set(u8, out, 0);
+            inline for (fields) |field, i| {
+                const field_layout = comptime fieldLayout(field.field_type);
+                const dst = out[offsets[i] .. offsets[i] + field_layout.size];
+                const src = @field(value, field.name);
+
+                switch (field_layout.kind) {
+                    .scalar => std.mem.copy(u8, dst, std.mem.asBytes(&src)),
+                    .vector => {
+                        inline for (@typeInfo(field.field_type).Struct.fields) |component, j| {
+                            std.mem.copy(u8, dst[j * 4 ..], std.mem.asBytes(&@field(src, component.name)));
+                        }
+                    },
+                    .matrix => {
+                        const data = @field(src, @typeInfo(field.field_type).Struct.fields[0].name);
+                        const rows = field_layout.components;
+                        comptime var column = 0;
+                        inline while (column < field_layout.count) : (column += 1) {
+                            std.mem.copy(u8, dst[column * 16 ..], std.mem.sliceAsBytes(data[column * rows .. (column + 1) * rows]));
+                        }
+                    },
+                    .array => {
+                        for (src) |element, j| std.mem.copy(u8, dst[j * 16 ..], std.mem.asBytes(&element));
+                    },
+                }
+            }
+        }
+    };
+}
+
+const Kind = enum {
+    scalar,
+    vector,
+    matrix,
+    array,
+};
+
+const FieldLayout = struct {
+    kind: Kind,
+    alignment: usize,
+    size: usize,
+    /// components per vector or rows per matrix column
+    components: usize = 1,
+    /// matrix columns or array elements
+    count: usize = 1,
+};
+
+fn fieldLayout(comptime F: type) FieldLayout {
+    switch (@typeInfo(F)) {
+        .Int, .Float => {
+            if (@sizeOf(F) != 4) @compileError("std140 scalars must be 4 bytes: " ++ @typeName(F));
+            return .{ .kind = .scalar, .alignment = 4, .size = 4 };
+        },
+        .Struct => |type_info| {
+            if (type_info.fields.len == 1 and @typeInfo(type_info.fields[0].field_type) == .Array) {
+                const rows = switch (@typeInfo(type_info.fields[0].field_type).Array.len) {
+                    4, 6 => 2,
+                    9 => 3,
+                    16 => 4,
+                    else => @compileError("Structs with array fields must be 4/6/9/16 elements: " ++ @typeName(F)),
+                };
+                const columns = @typeInfo(type_info.fields[0].field_type).Array.len / rows;
+                // each column is padded out to a vec4
+                return .{ .kind = .matrix, .alignment = 16, .size = 16 * columns, .components = rows, .count = columns };
+            }
+
+            inline for (type_info.fields) |field| {
+                if (field.field_type != f32) @compileError("Structs of f32 must be 2/3/4 elements: " ++ @typeName(F));
+            }
+            return switch (type_info.fields.len) {
+                2 => .{ .kind = .vector, .alignment = 8, .size = 8, .components = 2 },
+                3 => .{ .kind = .vector, .alignment = 16, .size = 12, .components = 3 },
+                4 => .{ .kind = .vector, .alignment = 16, .size = 16, .components = 4 },
+                else => @compileError("Structs of f32 must be 2/3/4 elements: " ++ @typeName(F)),
+            };
+        },
+        .Array => |type_info| {
+            if (@sizeOf(type_info.child) != 4) @compileError("std140 arrays must be of 4 byte scalars: " ++ @typeName(F));
+            // array elements are padded out to a vec4
+            return .{ .kind = .array, .alignment = 16, .size = 16 * type_info.len, .count = type_info.len };
+        },
+        else => @compileError("Need support for uniform type: " ++ @typeName(F)),
+    }
+}
+
+test "std140 layout" {
+    const Vec2 = struct { x: f32, y: f32 };
+    const Vec3 = struct { x: f32, y: f32, z: f32 };
+    const Mat32 = struct { data: [6]f32 };
+    const Uniforms = struct {
+        alpha: f32,
+        offset: Vec2,
+        color: Vec3,
+        transform: Mat32,
+        weights: [2]f32,
+        mode: i32,
+    };
+
+    const L = Layout(Uniforms);
+    std.testing.expectEqual([_]usize{ 0, 8, 16, 32, 80, 112 }, L.field_offsets);
+    std.testing.expectEqual(@as(usize, 128), L.size);
+
+    var value = Uniforms{
+        .alpha = 0.5,
+        .offset = .{ .x = 1, .y = 2 },
+        .color = .{ .x = 3, .y = 4, .z = 5 },
+        .transform = .{ .data = [_]f32{ 1, 2, 3, 4, 5, 6 } },
+        .weights = [_]f32{ 7, 8 },
+        .mode = 9,
+    };
+    var bytes: [L.size]u8 = undefined;
+    L.write(&value, &bytes);
+
+    const floats = std.mem.bytesAsSlice(f32, bytes[0..]);
+    std.testing.expectEqual(@as(f32, 0.5), floats[0]);
+    std.testing.expectEqual(@as(f32, 2), floats[3]);
+    std.testing.expectEqual(@as(f32, 5), floats[6]);
+    // mat3x2 columns start every 16 bytes
+    std.testing.expectEqual(@as(f32, 3), floats[12]);
+    std.testing.expectEqual(@as(f32, 6), floats[17]);
+    std.testing.expectEqual(@as(f32, 0), floats[18]);
+    std.testing.expectEqual(@as(f32, 8), floats[24]);
+    std.testing.expectEqual(@as(i32, 9), std.mem.bytesAsSlice(i32, bytes[0..])[28]);
+}
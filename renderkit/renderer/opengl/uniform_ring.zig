@@ -0,0 +1,70 @@
+const std = @import("std");
+const num_inflight_frames = @import("release_queue.zig").num_inflight_frames;
+usingnamespace @import("gl_decls.zig");
+
+/// one GL_UNIFORM_BUFFER split into a region per in flight frame. Uniform blocks are written into the current frame's
+/// region so the GPU never reads a range that is being overwritten. If a region fills up the whole buffer is orphaned,
+/// which invalidates every earlier `Upload`.
+pub const UniformRing = struct {
+    pub const region_size: u32 = 64 * 1024;
+    const num_regions = num_inflight_frames + 1;
+
+    /// where a block was written. Only valid while `isLive` returns true.
+    pub const Upload = struct {
+        offset: u32 = 0,
+        size: u32 = 0,
+        frame: u32 = 0,
+        generation: u32 = 0,
+    };
+
+    buffer: GLuint = 0,
+    alignment: u32 = 256,
+    cursor: u32 = 0,
+    frame: u32 = 0,
+    generation: u32 = 0,
+
+    pub fn init() UniformRing {
+        var self = UniformRing{};
+
+        var alignment: GLint = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment > 0) self.alignment = @intCast(u32, alignment);
+
+        // the generic binding point is only ever used for this buffer so it is bound once here
+        glGenBuffers(1, &self.buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, self.buffer);
+        glBufferData(GL_UNIFORM_BUFFER, region_size * num_regions, null, GL_STREAM_DRAW);
+        return self;
+    }
+
+    pub fn isLive(self: UniformRing, upload: Upload, frame_index: u32) bool {
+        return upload.size > 0 and upload.generation == self.generation and frame_index - upload.frame < num_regions;
+    }
+
+    pub fn upload(self: *UniformRing, bytes: []const u8, frame_index: u32) Upload {
+        std.debug.assert(bytes.len <= region_size);
+
+        const region = frame_index % num_regions;
+        if (self.frame != frame_index) {
+            self.frame = frame_index;
+            self.cursor = region * region_size;
+        }
+
+        var offset = std.mem.alignForwardGeneric(u32, self.cursor, self.alignment);
+        if (offset + bytes.len > (region + 1) * region_size) {
+            glBufferData(GL_UNIFORM_BUFFER, region_size * num_regions, null, GL_STREAM_DRAW);
+            self.generation += 1;
+            offset = region * region_size;
+        }
+
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, @intCast(GLsizeiptr, bytes.len), bytes.ptr);
+        self.cursor = offset + @intCast(u32, bytes.len);
+
+        return .{
+            .offset = offset,
+            .size = @intCast(u32, bytes.len),
+            .frame = frame_index,
+            .generation = self.generation,
+        };
+    }
+};
@@ -0,0 +1,111 @@
+const std = @import("std");
+usingnamespace @import("gl_decls.zig");
+
+/// the active uniforms of a program, enumerated once at link time. Lookups are keyed by a hash of the uniform name that
+/// callers compute at comptime so finding a location never touches a string. Two names of one program hashing the same
+/// would make one of them resolve to the other's location, so that panics at link time. Each slot also shadows the
+/// last value uploaded to its location so redundant glUniform calls can be skipped.
+pub const UniformTable = struct {
+    /// values larger than this (big arrays) are always uploaded
+    pub const max_shadow_size = 64;
+
+    pub const Slot = struct {
+        hash: u32 = 0, // 0 marks an empty slot
+        location: GLint = -1,
+        shadow_len: u8 = 0, // 0 means the value at the location is unknown
+        shadow: [max_shadow_size]u8 = undefined,
+
+        /// returns true if `bytes` differ from the last upload and remembers them
+        pub fn changed(self: *Slot, bytes: []const u8) bool {
+            if (bytes.len > max_shadow_size) return true;
+            if (self.shadow_len == bytes.len and std.mem.eql(u8, self.shadow[0..bytes.len], bytes)) return false;
+
+            std.mem.copy(u8, &self.shadow, bytes);
+            self.shadow_len = @intCast(u8, bytes.len);
+            return true;
+        }
+    };
+
+    slots: []Slot,
+
+    pub fn hashName(name: []const u8) u32 {
+        const hash = std.hash.Fnv1a_32.hash(name);
+        return if (hash == 0) 1 else hash;
+    }
+
+    pub fn init(allocator: *std.mem.Allocator, program: GLuint) UniformTable {
+        var count: GLint = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+
+        var self = initCapacity(allocator, @intCast(usize, count));
+        var i: GLuint = 0;
+        while (i < @intCast(GLuint, count)) : (i += 1) {
+            var name_buf: [256]GLchar = undefined;
+            var name_len: GLsizei = 0;
+            var size: GLint = 0;
+            var kind: GLenum = 0;
+            glGetActiveUniform(program, i, name_buf.len, &name_len, &size, &kind, &name_buf);
+
+            const location = glGetUniformLocation(program, @ptrCast([*:0]const GLchar, &name_buf));
+            // uniforms in blocks have no location
+            if (location == -1) continue;
+
+            // arrays are reported as "name[0]" but looked up by their plain name
+            var name = name_buf[0..@intCast(usize, name_len)];
+            if (std.mem.endsWith(u8, name, "[0]")) name = name[0 .. name.len - 3];
+            self.insert(name, location);
+        }
+        return self;
+    }
+
+    /// an empty table with room for `count` uniforms at 50% load
+    pub fn initCapacity(allocator: *std.mem.Allocator, count: usize) UniformTable {
+        const capacity = std.math.ceilPowerOfTwo(usize, std.math.max(count * 2, 8)) catch unreachable;
+        var slots = allocator.alloc(Slot, capacity) catch unreachable;
+        for (slots) |*slot| slot.* = .{};
+        return .{ .slots = slots };
+    }
+
+    pub fn deinit(self: UniformTable, allocator: *std.mem.Allocator) void {
+        allocator.free(self.slots);
+    }
+
+    pub fn insert(self: *UniformTable, name: []const u8, location: GLint) void {
+        const hash = hashName(name);
+        var index = hash & (self.slots.len - 1);
+        while (self.slots[index].hash != 0) : (index = (index + 1) & (self.slots.len - 1)) {
+            if (self.slots[index].hash == hash) std.debug.panic("uniform {} has the same name hash as the uniform at location {}, rename one of them", .{ name, self.slots[index].location });
+        }
+        self.slots[index] = .{ .hash = hash, .location = location };
+    }
+
+    pub fn find(self: UniformTable, hash: u32) ?*Slot {
+        var index = hash & (self.slots.len - 1);
+        while (self.slots[index].hash != 0) : (index = (index + 1) & (self.slots.len - 1)) {
+            if (self.slots[index].hash == hash) return &self.slots[index];
+        }
+        return null;
+    }
+
+    /// forgets all shadowed values, for when something outside of RenderKit may have changed them
+    pub fn resetShadows(self: UniformTable) void {
+        for (self.slots) |*slot| slot.shadow_len = 0;
+    }
+};
+
+test "uniform table" {
+    var table = UniformTable.initCapacity(std.testing.allocator, 3);
+    defer table.deinit(std.testing.allocator);
+
+    const names = [_][]const u8{ "u_transform", "u_time", "u_palette" };
+    for (names) |name, i| table.insert(name, @intCast(GLint, i));
+
+    for (names) |name, i| std.testing.expectEqual(@intCast(GLint, i), table.find(UniformTable.hashName(name)).?.location);
+    std.testing.expect(table.find(UniformTable.hashName("u_missing")) == null);
+
+    var slot = table.find(comptime UniformTable.hashName("u_time")).?;
+    const value: f32 = 2;
+    std.testing.expect(slot.changed(std.mem.asBytes(&value)));
+    std.testing.expect(!slot.changed(std.mem.asBytes(&value)));
+    std.testing.expect(slot.changed(std.mem.asBytes(&@as(f32, 3))));
+}
@@ -0,0 +1,189 @@
+const std = @import("std");
+const renderkit = @import("../types.zig");
+usingnamespace @import("gl_decls.zig");
+
+/// fixed size cache of Vertex Array Objects keyed by the buffer part of `BufferBindings`. Lookups use open addressing
+/// with linear probing. When full, the least recently used VAO is evicted and handed back so the caller can queue it for
+/// deletion.
+pub const VertexArrayCache = struct {
+    pub const capacity = 128;
+    /// keeps the load factor at 50% so probe sequences stay short
+    pub const max_entries = capacity / 2;
+
+    pub const Key = struct {
+        index_buffer: renderkit.Buffer,
+        vert_buffers: [4]renderkit.Buffer,
+        vertex_buffer_offsets: [4]u32,
+
+        /// with the vertex attrib binding path offsets are set with glBindVertexBuffer and are not part of the key
+        pub fn init(bindings: renderkit.BufferBindings, with_offsets: bool) Key {
+            return .{
+                .index_buffer = bindings.index_buffer,
+                .vert_buffers = bindings.vert_buffers,
+                .vertex_buffer_offsets = if (with_offsets) bindings.vertex_buffer_offsets else [_]u32{0} ** 4,
+            };
+        }
+
+        fn eq(self: Key, other: Key) bool {
+            return self.index_buffer == other.index_buffer and
+                std.mem.eql(renderkit.Buffer, &self.vert_buffers, &other.vert_buffers) and
+                std.mem.eql(u32, &self.vertex_buffer_offsets, &other.vertex_buffer_offsets);
+        }
+
+        fn hash(self: Key) u32 {
+            var hasher = std.hash.Wyhash.init(0);
+            std.hash.autoHash(&hasher, self.index_buffer);
+            std.hash.autoHash(&hasher, self.vert_buffers);
+            std.hash.autoHash(&hasher, self.vertex_buffer_offsets);
+            return @truncate(u32, hasher.final());
+        }
+
+        fn references(self: Key, buffer: renderkit.Buffer) bool {
+            if (self.index_buffer == buffer) return true;
+            for (self.vert_buffers) |vb| {
+                if (vb == buffer) return true;
+            }
+            return false;
+        }
+    };
+
+    pub const Entry = struct {
+        key: Key,
+        vao: GLuint = 0, // 0 marks an empty slot
+        last_used: u32 = 0,
+        /// offsets last passed to glBindVertexBuffer for this VAO
+        offsets: [4]u32 = [_]u32{0} ** 4,
+    };
+
+    entries: [capacity]Entry = undefined,
+    count: u32 = 0,
+    tick: u32 = 0,
+    stats: renderkit.VertexArrayCacheStats = .{},
+
+    pub fn init() VertexArrayCache {
+        var self = VertexArrayCache{};
+        for (self.entries) |*entry| entry.vao = 0;
+        return self;
+    }
+
+    pub fn get(self: *VertexArrayCache, key: Key) ?*Entry {
+        self.tick += 1;
+
+        var slot = key.hash() & (capacity - 1);
+        while (self.entries[slot].vao != 0) : (slot = (slot + 1) & (capacity - 1)) {
+            if (self.entries[slot].key.eq(key)) {
+                self.entries[slot].last_used = self.tick;
+                self.stats.hits += 1;
+                return &self.entries[slot];
+            }
+        }
+
+        self.stats.misses += 1;
+        return null;
+    }
+
+    /// adds a VAO for a key that `get` just missed. Returns the evicted VAO (or 0) which the caller must delete.
+    pub fn put(self: *VertexArrayCache, key: Key, vao: GLuint, offsets: [4]u32) GLuint {
+        var evicted: GLuint = 0;
+        if (self.count == max_entries) {
+            var lru: usize = 0;
+            for (self.entries) |entry, i| {
+                if (entry.vao != 0 and (self.entries[lru].vao == 0 or entry.last_used < self.entries[lru].last_used)) lru = i;
+            }
+            evicted = self.entries[lru].vao;
+            self.remove(lru);
+            self.stats.evictions += 1;
+        }
+
+        var slot = key.hash() & (capacity - 1);
+        while (self.entries[slot].vao != 0) slot = (slot + 1) & (capacity - 1);
+        self.entries[slot] = .{ .key = key, .vao = vao, .last_used = self.tick, .offsets = offsets };
+        self.count += 1;
+        self.stats.live = self.count;
+
+        return evicted;
+    }
+
+    /// removes every VAO that references `buffer`, calling `release` with each one
+    pub fn invalidateBuffer(self: *VertexArrayCache, buffer: renderkit.Buffer, release: fn (vao: GLuint) void) void {
+        var i: usize = 0;
+        while (i < capacity) {
+            const entry = self.entries[i];
+            if (entry.vao != 0 and entry.key.references(buffer)) {
+                release(entry.vao);
+                // removal shifts a later entry into this slot so it has to be checked again
+                self.remove(i);
+            } else {
+                i += 1;
+            }
+        }
+        self.stats.live = self.count;
+    }
+
+    /// removes every VAO, calling `release` with each one
+    pub fn clear(self: *VertexArrayCache, release: fn (vao: GLuint) void) void {
+        for (self.entries) |*entry| {
+            if (entry.vao != 0) release(entry.vao);
+            entry.vao = 0;
+        }
+        self.count = 0;
+        self.stats.live = 0;
+    }
+
+    /// backward shift deletion so probe sequences never hit a hole
+    fn remove(self: *VertexArrayCache, slot: usize) void {
+        var hole = slot;
+        var next = (slot + 1) & (capacity - 1);
+        while (self.entries[next].vao != 0) : (next = (next + 1) & (capacity - 1)) {
+            const home = self.entries[next].key.hash() & (capacity - 1);
+            // move the entry into the hole unless its home slot lies cyclically in (hole, next]
+            const in_range = if (hole <= next) (home > hole and home <= next) else (home > hole or home <= next);
+            if (!in_range) {
+                self.entries[hole] = self.entries[next];
+                hole = next;
+            }
+        }
+        self.entries[hole].vao = 0;
+        self.count -= 1;
+    }
+};
+
+const TestRelease = struct {
+    var released: u32 = 0;
+
+    fn release(vao: GLuint) void {
+        released += 1;
+    }
+};
+
+fn testKey(index_buffer: renderkit.Buffer, vert_buffer: renderkit.Buffer) VertexArrayCache.Key {
+    var vert_buffers = [_]renderkit.Buffer{vert_buffer};
+    return VertexArrayCache.Key.init(renderkit.BufferBindings.init(index_buffer, &vert_buffers), true);
+}
+
+test "vao cache hits, evicts and invalidates" {
+    var cache = VertexArrayCache.init();
+
+    var i: u32 = 1;
+    while (i <= VertexArrayCache.max_entries) : (i += 1) {
+        std.testing.expect(cache.get(testKey(1000, i)) == null);
+        std.testing.expectEqual(@as(GLuint, 0), cache.put(testKey(1000, i), i, [_]u32{0} ** 4));
+    }
+
+    // touch everything but the first so it becomes the lru
+    i = 2;
+    while (i <= VertexArrayCache.max_entries) : (i += 1) std.testing.expectEqual(@as(GLuint, i), cache.get(testKey(1000, i)).?.vao);
+    std.testing.expectEqual(@as(GLuint, 1), cache.put(testKey(1000, 999), 999, [_]u32{0} ** 4));
+    std.testing.expect(cache.get(testKey(1000, 1)) == null);
+    std.testing.expectEqual(@as(u32, 1), cache.stats.evictions);
+
+    cache.invalidateBuffer(5, TestRelease.release);
+    std.testing.expectEqual(@as(u32, 1), TestRelease.released);
+    std.testing.expect(cache.get(testKey(1000, 5)) == null);
+    std.testing.expectEqual(@as(GLuint, 6), cache.get(testKey(1000, 6)).?.vao);
+
+    // the shared index buffer takes everything with it
+    cache.invalidateBuffer(1000, TestRelease.release);
+    std.testing.expectEqual(@as(u32, 0), cache.count);
+    std.testing.expectEqual(@as(u32, VertexArrayCache.max_entries), TestRelease.released);
+}
@@ -0,0 +1,214 @@
+const std = @import("std");
+usingnamespace @import("types.zig");
+usingnamespace @import("descriptions.zig");
+const HandledCache = @import("handles.zig").HandledCache;
+
+/// deduplicates pipeline state objects. Every distinct `PipelineDesc` gets one `Pipeline` handle and one backend state
+/// object built by `Backend.createPipeline`. Descs are hashed once when the pipeline is requested, after that the
+/// handle resolves the backend state with a single index so there is no per-draw hashing or comparing. Lookups use
+/// open addressing with linear probing and the table doubles before it gets more than half full.
+/// Backend is the namespace that builds the state objects, its createPipeline and destroyPipeline are all that is used.
+pub fn PipelineCache(comptime Backend: type) type {
+    return struct {
+        const Self = @This();
+        const initial_capacity = 32;
+
+        pub const State = struct {
+            desc: PipelineDesc,
+            /// the backend's handle for its prebuilt state object
+            native: u32,
+            hash: u32,
+        };
+
+        const Entry = struct {
+            hash: u32 = 0,
+            pipeline: Pipeline = 0, // 0 marks an empty slot
+        };
+
+        pub const Stats = struct {
+            hits: u32 = 0,
+            misses: u32 = 0,
+            live: u32 = 0,
+        };
+
+        allocator: *std.mem.Allocator,
+        entries: []Entry,
+        states: HandledCache(State),
+        stats: Stats = .{},
+
+        pub fn init(allocator: *std.mem.Allocator) Self {
+            var entries = allocator.alloc(Entry, initial_capacity) catch unreachable;
+            for (entries) |*entry| entry.* = .{};
+            return .{
+                .allocator = allocator,
+                .entries = entries,
+                .states = HandledCache(State).init(allocator, initial_capacity),
+            };
+        }
+
+        /// destroys every backend pipeline
+        pub fn deinit(self: *Self) void {
+            for (self.entries) |entry| {
+                if (entry.pipeline != 0) Backend.destroyPipeline(self.states.get(entry.pipeline).native);
+            }
+            self.allocator.free(self.entries);
+            self.states.deinit();
+        }
+
+        /// returns the pipeline for `desc`, building the backend state object the first time a desc is seen
+        pub fn get(self: *Self, desc: PipelineDesc) Pipeline {
+            const hash = hashDesc(desc);
+            const mask = self.entries.len - 1;
+
+            var slot = @as(usize, hash) & mask;
+            while (self.entries[slot].pipeline != 0) : (slot = (slot + 1) & mask) {
+                const entry = self.entries[slot];
+                if (entry.hash == hash and std.meta.eql(self.states.get(entry.pipeline).desc, desc)) {
+                    self.stats.hits += 1;
+                    return entry.pipeline;
+                }
+            }
+
+            self.stats.misses += 1;
+            if ((self.stats.live + 1) * 2 > self.entries.len) {
+                self.grow();
+                return self.insert(desc, hash);
+            }
+            return self.insertAt(slot, desc, hash);
+        }
+
+        /// builds the backend state objects for `descs` ahead of time, for example behind a loading screen, so the
+        /// first frame that uses them doesn't stall on pipeline compilation
+        pub fn precompile(self: *Self, descs: []const PipelineDesc) void {
+            for (descs) |desc| _ = self.get(desc);
+        }
+
+        pub fn getState(self: Self, pipeline: Pipeline) *State {
+            return self.states.get(pipeline);
+        }
+
+        /// destroys every pipeline built with `shader`. Their handles become invalid.
+        pub fn removeShader(self: *Self, shader: ShaderProgram) void {
+            var i: usize = 0;
+            while (i < self.entries.len) {
+                const entry = self.entries[i];
+                if (entry.pipeline != 0 and self.states.get(entry.pipeline).desc.shader == shader) {
+                    Backend.destroyPipeline(self.states.free(entry.pipeline).native);
+                    // removal shifts a later entry into this slot so it has to be checked again
+                    self.remove(i);
+                } else {
+                    i += 1;
+                }
+            }
+        }
+
+        fn insert(self: *Self, desc: PipelineDesc, hash: u32) Pipeline {
+            const mask = self.entries.len - 1;
+            var slot = @as(usize, hash) & mask;
+            while (self.entries[slot].pipeline != 0) slot = (slot + 1) & mask;
+            return self.insertAt(slot, desc, hash);
+        }
+
+        fn insertAt(self: *Self, slot: usize, desc: PipelineDesc, hash: u32) Pipeline {
+            const pipeline = self.states.append(.{ .desc = desc, .native = Backend.createPipeline(desc), .hash = hash });
+            self.entries[slot] = .{ .hash = hash, .pipeline = pipeline };
+            self.stats.live += 1;
+            return pipeline;
+        }
+
+        fn grow(self: *Self) void {
+            const old = self.entries;
+            self.entries = self.allocator.alloc(Entry, old.len * 2) catch unreachable;
+            for (self.entries) |*entry| entry.* = .{};
+
+            const mask = self.entries.len - 1;
+            for (old) |entry| {
+                if (entry.pipeline == 0) continue;
+                var slot = @as(usize, entry.hash) & mask;
+                while (self.entries[slot].pipeline != 0) slot = (slot + 1) & mask;
+                self.entries[slot] = entry;
+            }
+            self.allocator.free(old);
+        }
+
+        /// backward shift deletion so probe sequences never hit a hole
+        fn remove(self: *Self, slot: usize) void {
+            const mask = self.entries.len - 1;
+            var hole = slot;
+            var next = (slot + 1) & mask;
+            while (self.entries[next].pipeline != 0) : (next = (next + 1) & mask) {
+                const home = @as(usize, self.entries[next].hash) & mask;
+                // move the entry into the hole unless its home slot lies cyclically in (hole, next]
+                const in_range = if (hole <= next) (home > hole and home <= next) else (home > hole or home <= next);
+                if (!in_range) {
+                    self.entries[hole] = self.entries[next];
+                    hole = next;
+                }
+            }
+            self.entries[hole] = .{};
+            self.stats.live -= 1;
+        }
+    };
+}
+
+/// hashes every field of the desc. The blend color is hashed by its bits since floats can't go through autoHash.
+fn hashDesc(desc: PipelineDesc) u32 {
+    var hasher = std.hash.Wyhash.init(0);
+    std.hash.autoHash(&hasher, desc.shader);
+    std.hash.autoHash(&hasher, desc.layout);
+    std.hash.autoHash(&hasher, desc.render_state.depth);
+    std.hash.autoHash(&hasher, desc.render_state.stencil);
+    std.hash.autoHash(&hasher, desc.render_state.scissor);
+
+    const blend = desc.render_state.blend;
+    inline for (std.meta.fields(@TypeOf(blend))) |field| {
+        if (comptime std.mem.eql(u8, field.name, "color")) {
+            std.hash.autoHash(&hasher, @bitCast([4]u32, blend.color));
+        } else {
+            std.hash.autoHash(&hasher, @field(blend, field.name));
+        }
+    }
+    return @truncate(u32, hasher.final());
+}
+
+const TestVertex = extern struct {
+    pos: extern struct { x: f32, y: f32 },
+    uv: extern struct { x: f32, y: f32 },
+    col: u32,
+};
+
+test "pipeline cache dedupes and removes by shader" {
+    const Cache = PipelineCache(@import("dummy/backend.zig"));
+    var cache = Cache.init(std.testing.allocator);
+    defer cache.deinit();
+
+    const layout = VertexLayout.init(&[_]type{TestVertex});
+    std.testing.expectEqual(@as(u32, 3), layout.num_attributes);
+    std.testing.expectEqual(VertexFormat.u_byte_4n, layout.attributes[2].format);
+    std.testing.expectEqual(@as(u32, 16), layout.attributes[2].offset);
+
+    const solid = PipelineDesc{ .shader = 1, .layout = layout, .render_state = .{ .blend = .{ .enabled = false } } };
+    const blended = PipelineDesc{ .shader = 1, .layout = layout };
+    const a = cache.get(solid);
+    const b = cache.get(blended);
+    std.testing.expect(a != b);
+    std.testing.expectEqual(a, cache.get(solid));
+    std.testing.expectEqual(@as(u32, 1), cache.stats.hits);
+
+    var blend_color = blended;
+    blend_color.render_state.blend.color = [_]f32{ 1, 0, 0, 1 };
+    std.testing.expect(cache.get(blend_color) != b);
+
+    // enough shaders to grow the table a few times
+    var descs: [100]PipelineDesc = undefined;
+    for (descs) |*desc, i| desc.* = .{ .shader = @intCast(ShaderProgram, i + 2), .layout = layout };
+    cache.precompile(&descs);
+    std.testing.expectEqual(@as(u32, 103), cache.stats.live);
+    for (descs) |desc| std.testing.expectEqual(desc.shader, cache.getState(cache.get(desc)).desc.shader);
+    std.testing.expectEqual(a, cache.get(solid));
+
+    cache.removeShader(1);
+    std.testing.expectEqual(@as(u32, 100), cache.stats.live);
+    for (descs) |desc| std.testing.expectEqual(desc.shader, cache.getState(cache.get(desc)).desc.shader);
+    std.testing.expectEqual(@as(u32, 100), cache.stats.live);
+}
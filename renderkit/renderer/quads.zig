@@ -0,0 +1,218 @@
+const std = @import("std");
+
+// CPU quad expansion for 2D geometry: sprites stored as separate arrays of floats are transformed by a `Mat32` and
+// written out as four `Vertex`es each, ready for appendBuffer. The vector path handles four sprites at a time and
+// produces exactly the same bits as the scalar path, which handles the leftovers.
+
+/// column major 3x2 matrix, as uploaded with glUniformMatrix3x2fv. data[4] and data[5] are the translation.
+pub const Mat32 = extern struct {
+    data: [6]f32,
+
+    pub const identity = Mat32{ .data = [_]f32{ 1, 0, 0, 1, 0, 0 } };
+
+    /// pixels to clip space for a `width` x `height` target with 0,0 in the top left corner
+    pub fn ortho(width: f32, height: f32) Mat32 {
+        return .{ .data = [_]f32{ 2 / width, 0, 0, -2 / height, -1, 1 } };
+    }
+};
+
+pub const Vertex = extern struct {
+    pos: extern struct { x: f32, y: f32 },
+    uv: extern struct { x: f32, y: f32 },
+    col: u32,
+};
+
+/// sprites as one array per field, all the same length. Colors are 0-1 floats and get clamped when packed.
+pub const Sprites = struct {
+    x: []const f32,
+    y: []const f32,
+    width: []const f32,
+    height: []const f32,
+    uv_x: []const f32,
+    uv_y: []const f32,
+    uv_width: []const f32,
+    uv_height: []const f32,
+    r: []const f32,
+    g: []const f32,
+    b: []const f32,
+    a: []const f32,
+
+    pub fn len(self: Sprites) usize {
+        return self.x.len;
+    }
+};
+
+pub const lanes = 4;
+const F = @Vector(lanes, f32);
+const I = @Vector(lanes, i32);
+
+// adding 1.5 * 2^23 pushes the fraction out of the mantissa so the low bits hold the value rounded to nearest. Both
+// paths convert this way since @floatToInt doesn't take vectors. The bias is subtracted with wrapping so a huge, infinite
+// or NaN color can't trip the overflow check, it just clamps to some channel value.
+const round_magic: f32 = 12582912.0;
+const round_bias: i32 = 0x4B400000;
+
+/// packs 0-1 floats into the u32 a `u_byte_4n` attribute reads as normalized rgba
+pub fn packColor(r: f32, g: f32, b: f32, a: f32) u32 {
+    return channel(r) | channel(g) << 8 | channel(b) << 16 | channel(a) << 24;
+}
+
+fn channel(value: f32) u32 {
+    const rounded = @bitCast(i32, value * 255 + round_magic) -% round_bias;
+    return @intCast(u32, std.math.clamp(rounded, 0, 255));
+}
+
+fn channels(value: F) @Vector(lanes, u32) {
+    var rounded = @bitCast(I, value * @splat(lanes, @as(f32, 255)) + @splat(lanes, round_magic)) -% @splat(lanes, round_bias);
+    // branchless clamp to 0-255, the sign bit masks out negatives
+    const sign = @splat(lanes, @as(u5, 31));
+    rounded &= ~(rounded >> sign);
+    const over = @splat(lanes, @as(i32, 255)) - rounded;
+    rounded = @splat(lanes, @as(i32, 255)) - (over & ~(over >> sign));
+    return @bitCast(@Vector(lanes, u32), rounded);
+}
+
+fn packColors(r: F, g: F, b: F, a: F) @Vector(lanes, u32) {
+    return channels(r) | channels(g) << @splat(lanes, @as(u5, 8)) | channels(b) << @splat(lanes, @as(u5, 16)) | channels(a) << @splat(lanes, @as(u5, 24));
+}
+
+/// writes four vertices per sprite into `verts`, corners in the order top left, top right, bottom right, bottom left
+pub fn transform(matrix: Mat32, sprites: Sprites, verts: []Vertex) void {
+    std.debug.assert(verts.len >= sprites.len() * 4);
+    const m = matrix.data;
+    const m0 = @splat(lanes, m[0]);
+    const m1 = @splat(lanes, m[1]);
+    const m2 = @splat(lanes, m[2]);
+    const m3 = @splat(lanes, m[3]);
+    const m4 = @splat(lanes, m[4]);
+    const m5 = @splat(lanes, m[5]);
+
+    var i: usize = 0;
+    while (i + lanes <= sprites.len()) : (i += lanes) {
+        const x: F = sprites.x[i..][0..lanes].*;
+        const y: F = sprites.y[i..][0..lanes].*;
+        const w: F = sprites.width[i..][0..lanes].*;
+        const h: F = sprites.height[i..][0..lanes].*;
+
+        // the matrix is linear so the corners are the transformed origin plus the transformed edges
+        const ox = m0 * x + m2 * y + m4;
+        const oy = m1 * x + m3 * y + m5;
+        const wx = m0 * w;
+        const wy = m1 * w;
+        const hx = m2 * h;
+        const hy = m3 * h;
+        const xs = [4][lanes]f32{ ox, ox + wx, ox + wx + hx, ox + hx };
+        const ys = [4][lanes]f32{ oy, oy + wy, oy + wy + hy, oy + hy };
+
+        const u0: F = sprites.uv_x[i..][0..lanes].*;
+        const v0: F = sprites.uv_y[i..][0..lanes].*;
+        const u1 = u0 + @as(F, sprites.uv_width[i..][0..lanes].*);
+        const v1 = v0 + @as(F, sprites.uv_height[i..][0..lanes].*);
+        const us = [4][lanes]f32{ u0, u1, u1, u0 };
+        const vs = [4][lanes]f32{ v0, v0, v1, v1 };
+
+        const cols: [lanes]u32 = packColors(
+            sprites.r[i..][0..lanes].*,
+            sprites.g[i..][0..lanes].*,
+            sprites.b[i..][0..lanes].*,
+            sprites.a[i..][0..lanes].*,
+        );
+
+        comptime var lane = 0;
+        inline while (lane < lanes) : (lane += 1) {
+            comptime var corner = 0;
+            inline while (corner < 4) : (corner += 1) {
+                verts[(i + lane) * 4 + corner] = .{
+                    .pos = .{ .x = xs[corner][lane], .y = ys[corner][lane] },
+                    .uv = .{ .x = us[corner][lane], .y = vs[corner][lane] },
+                    .col = cols[lane],
+                };
+            }
+        }
+    }
+
+    transformRange(matrix, sprites, i, verts);
+}
+
+/// the scalar fallback, one sprite at a time
+pub fn transformScalar(matrix: Mat32, sprites: Sprites, verts: []Vertex) void {
+    std.debug.assert(verts.len >= sprites.len() * 4);
+    transformRange(matrix, sprites, 0, verts);
+}
+
+fn transformRange(matrix: Mat32, sprites: Sprites, first: usize, verts: []Vertex) void {
+    const m = matrix.data;
+    var i = first;
+    while (i < sprites.len()) : (i += 1) {
+        const ox = m[0] * sprites.x[i] + m[2] * sprites.y[i] + m[4];
+        const oy = m[1] * sprites.x[i] + m[3] * sprites.y[i] + m[5];
+        const wx = m[0] * sprites.width[i];
+        const wy = m[1] * sprites.width[i];
+        const hx = m[2] * sprites.height[i];
+        const hy = m[3] * sprites.height[i];
+        const u0 = sprites.uv_x[i];
+        const v0 = sprites.uv_y[i];
+        const u1 = u0 + sprites.uv_width[i];
+        const v1 = v0 + sprites.uv_height[i];
+        const col = packColor(sprites.r[i], sprites.g[i], sprites.b[i], sprites.a[i]);
+
+        const quad = verts[i * 4 ..][0..4];
+        quad[0] = .{ .pos = .{ .x = ox, .y = oy }, .uv = .{ .x = u0, .y = v0 }, .col = col };
+        quad[1] = .{ .pos = .{ .x = ox + wx, .y = oy + wy }, .uv = .{ .x = u1, .y = v0 }, .col = col };
+        quad[2] = .{ .pos = .{ .x = ox + wx + hx, .y = oy + wy + hy }, .uv = .{ .x = u1, .y = v1 }, .col = col };
+        quad[3] = .{ .pos = .{ .x = ox + hx, .y = oy + hy }, .uv = .{ .x = u0, .y = v1 }, .col = col };
+    }
+}
+
+test "pack color rounds and clamps" {
+    std.testing.expectEqual(@as(u32, 0xFFFFFFFF), packColor(1, 1, 1, 1));
+    std.testing.expectEqual(@as(u32, 0xFF000080), packColor(0.5, 0, 0, 1));
+    std.testing.expectEqual(@as(u32, 0x00FF00FF), packColor(7, -3, 1.5, -0.001));
+
+    const vector: [lanes]u32 = packColors(
+        [_]f32{ 1, 0.5, 7, 0.2 },
+        [_]f32{ 1, 0, -3, 0.4 },
+        [_]f32{ 1, 0, 1.5, 0.6 },
+        [_]f32{ 1, 1, -0.001, 0.8 },
+    );
+    std.testing.expectEqual(packColor(1, 1, 1, 1), vector[0]);
+    std.testing.expectEqual(packColor(0.5, 0, 0, 1), vector[1]);
+    std.testing.expectEqual(packColor(7, -3, 1.5, -0.001), vector[2]);
+    std.testing.expectEqual(packColor(0.2, 0.4, 0.6, 0.8), vector[3]);
+}
+
+test "vector transform matches the scalar path" {
+    // not a multiple of the lane count so the tail is covered too
+    const count = 37;
+    var fields: [12][count]f32 = undefined;
+    var rng = std.rand.DefaultPrng.init(3);
+    for (fields) |*field| {
+        for (field) |*value| value.* = rng.random.float(f32) * 2 - 0.5;
+    }
+    const sprites = Sprites{
+        .x = &fields[0],
+        .y = &fields[1],
+        .width = &fields[2],
+        .height = &fields[3],
+        .uv_x = &fields[4],
+        .uv_y = &fields[5],
+        .uv_width = &fields[6],
+        .uv_height = &fields[7],
+        .r = &fields[8],
+        .g = &fields[9],
+        .b = &fields[10],
+        .a = &fields[11],
+    };
+
+    const matrix = Mat32{ .data = [_]f32{ 0.8, 0.6, -0.6, 0.8, 12, -4 } };
+    var expected: [count * 4]Vertex = undefined;
+    var actual: [count * 4]Vertex = undefined;
+    transformScalar(matrix, sprites, &expected);
+    transform(matrix, sprites, &actual);
+    std.testing.expectEqualSlices(u8, std.mem.sliceAsBytes(&expected), std.mem.sliceAsBytes(&actual));
+
+    // the identity leaves the top left corner where it was
+    transform(Mat32.identity, sprites, &actual);
+    std.testing.expectEqual(sprites.x[5], actual[20].pos.x);
+    std.testing.expectEqual(sprites.y[5] + sprites.height[5], actual[23].pos.y);
+}
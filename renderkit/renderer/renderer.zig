@@ -20,27 +20,85 @@ pub const Renderer = enum {
 // import our chosen backend renderer
 const backend = @import(@tagName(@import("../renderkit.zig").current_renderer) ++ "/backend.zig");
 
+// draws are recorded here when the draw order is not immediate and replayed at endPass
+const CommandQueue = @import("command_queue.zig").CommandQueue(backend);
+var queue: CommandQueue = undefined;
+var draw_order: DrawOrder = .immediate;
+
+// decodes createImageAsync images on worker threads and uploads them from commitFrame
+const TextureStreamer = @import("texture_streamer.zig").TextureStreamer(backend);
+var streamer: TextureStreamer = undefined;
+
+// dedupes PipelineDescs into backend pipeline state objects
+const PipelineCache = @import("pipeline.zig").PipelineCache(backend);
+var pipelines: PipelineCache = undefined;
+
+const texture_file = @import("texture_file.zig");
+var allocator: *std.mem.Allocator = undefined;
+
 // setup and state
 pub fn setup(desc: RendererDesc) void {
+    allocator = desc.allocator;
     backend.setup(desc);
+    queue = CommandQueue.init(desc.allocator);
+    streamer = TextureStreamer.init(desc.allocator);
+    pipelines = PipelineCache.init(desc.allocator);
 }
 
 pub fn shutdown() void {
+    streamer.deinit();
+    queue.deinit();
+    pipelines.deinit();
     backend.shutdown();
 }
 
+/// sets how draws are submitted, see `DrawOrder`. Any shader, render state and bindings set while in `.immediate` mode
+/// must be set again after switching to a deferred mode.
+pub fn setDrawOrder(order: DrawOrder) void {
+    if (order == draw_order) return;
+    if (draw_order != .immediate) queue.flush();
+    // immediate mode changed the backend state behind the queue's back
+    if (draw_order == .immediate) queue.resetApplied();
+    if (order != .immediate) queue.setOrder(order);
+    draw_order = order;
+}
+
 pub fn setRenderState(state: RenderState) void {
-    backend.setRenderState(state);
+    if (draw_order == .immediate) return backend.setRenderState(state);
+    queue.setRenderState(state);
+}
+
+/// forces all cached backend state to be resent. Call after code outside of RenderKit has changed graphics state.
+pub fn resetStateCache() void {
+    flushQueue();
+    queue.resetApplied();
+    backend.resetStateCache();
+}
+
+/// hit/miss counters for the Vertex Array Object cache (OpenGL only)
+pub fn getVertexArrayCacheStats() VertexArrayCacheStats {
+    return backend.getVertexArrayCacheStats();
+}
+
+/// program binary cache hits and time spent building shader programs, see `RendererDesc.shader_cache_dir`
+pub fn getShaderCacheStats() ShaderCacheStats {
+    return backend.getShaderCacheStats();
 }
 
 pub fn viewport(x: c_int, y: c_int, width: c_int, height: c_int) void {
+    flushQueue();
     backend.viewport(x, y, width, height);
 }
 
 pub fn scissor(x: c_int, y: c_int, width: c_int, height: c_int) void {
+    flushQueue();
     backend.scissor(x, y, width, height);
 }
 
+/// replays any recorded draws. Called before anything that can't be reordered with the draws recorded so far.
+fn flushQueue() void {
+    if (draw_order != .immediate) queue.flush();
+}
 
 // textures
 pub fn createImage(desc: ImageDesc) Image {
@@ -48,14 +106,104 @@ pub fn createImage(desc: ImageDesc) Image {
 }
 
 pub fn destroyImage(image: Image) void {
+    flushQueue();
+    queue.forgetBindings();
+    streamer.cancel(image);
     backend.destroyImage(image);
 }
 
+/// returns the image handle right away and decodes or converts the pixels from `source` on a worker thread. Until they
+/// are uploaded, which happens within the streaming budget in `commitFrame`, a transparent placeholder is bound in its
+/// place. The image is always created as `.dynamic`.
+pub fn createImageAsync(desc: ImageDesc, source: ImageSource) Image {
+    return streamer.createImageAsync(desc, source);
+}
+
+/// true once the pixels of a `createImageAsync` image are uploaded
+pub fn isImageReady(image: Image) bool {
+    return streamer.isReady(image);
+}
+
+/// maximum bytes of streamed image data uploaded per frame. At least one row is uploaded every frame.
+pub fn setTextureStreamingBudget(bytes_per_frame: u32) void {
+    streamer.upload_budget = bytes_per_frame;
+}
+
 pub fn updateImage(comptime T: type, image: Image, content: []const T) void {
     std.debug.assert(T == u8 or T == u32);
+    flushQueue();
     backend.updateImage(T, image, content);
 }
 
+/// replaces the `width` x `height` rectangle at `x`, `y`. `row_pitch` is the number of bytes between rows of `content`,
+/// 0 if they are tightly packed.
+pub fn updateImageRegion(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) void {
+    std.debug.assert(T == u8 or T == u32);
+    flushQueue();
+    backend.updateImageRegion(T, image, x, y, width, height, row_pitch, content);
+}
+
+/// like `updateImageRegion` but the transfer happens in the background. `content` can be reused as soon as this
+/// returns. Poll `isUploadComplete` with the token to know when the GPU is done with the upload. GL polls a fence
+/// signaled at the end of the upload's frame. Contexts without GL 3.2 or ARB_sync can only assume the upload is done
+/// after a couple of frames.
+pub fn updateImageRegionAsync(comptime T: type, image: Image, x: i32, y: i32, width: i32, height: i32, row_pitch: u32, content: []const T) UploadToken {
+    std.debug.assert(T == u8 or T == u32);
+    flushQueue();
+    return backend.updateImageRegionAsync(T, image, x, y, width, height, row_pitch, content);
+}
+
+pub fn isUploadComplete(token: UploadToken) bool {
+    return backend.isUploadComplete(token);
+}
+
+/// replaces mip level `level` of an image created with `num_mipmaps` > 1. `row_pitch` is the number of bytes between
+/// rows of `content`, 0 if they are tightly packed. Compressed levels are always tightly packed.
+pub fn updateImageLevel(comptime T: type, image: Image, level: i32, row_pitch: u32, content: []const T) void {
+    std.debug.assert(T == u8 or T == u32);
+    flushQueue();
+    backend.updateImageLevel(T, image, level, row_pitch, content);
+}
+
+/// fills every mip level below level 0 on the GPU. Not available for compressed formats.
+pub fn generateMipmaps(image: Image) void {
+    flushQueue();
+    backend.generateMipmaps(image);
+}
+
+/// false for the compressed and compact formats the GPU or driver can't sample
+pub fn isPixelFormatSupported(format: PixelFormat) bool {
+    return backend.isPixelFormatSupported(format);
+}
+
+/// creates an image from a KTX or DDS file. The file is memory mapped and every mip level is uploaded straight from the
+/// mapping, without an intermediate copy or decode.
+pub fn createImageFromFile(path: []const u8, desc: ImageFileDesc) !Image {
+    const mapped = try texture_file.MappedFile.open(allocator, path);
+    defer mapped.close();
+
+    const file = try texture_file.TextureFile.parse(mapped.bytes);
+    if (!backend.isPixelFormatSupported(file.format)) return error.UnsupportedFormat;
+
+    flushQueue();
+    const image = backend.createImage(.{
+        .width = file.width,
+        .height = file.height,
+        .num_mipmaps = @intCast(i32, file.num_levels),
+        .pixel_format = file.format,
+        .min_filter = desc.min_filter,
+        .mag_filter = desc.mag_filter,
+        .mip_filter = desc.mip_filter,
+        .wrap_u = desc.wrap_u,
+        .wrap_v = desc.wrap_v,
+        .max_anisotropy = desc.max_anisotropy,
+    });
+    for (file.levels[0..file.num_levels]) |level, i| {
+        backend.updateImageLevel(u8, image, @intCast(i32, i), level.row_pitch, level.data);
+    }
+    return image;
+}
+
 pub fn getImageNativeId(image: Image) u32 {
     return backend.getImageNativeId(image);
 }
@@ -66,22 +214,27 @@ pub fn createPass(desc: PassDesc) Pass {
 }
 
 pub fn destroyPass(pass: Pass) void {
+    flushQueue();
     backend.destroyPass(pass);
 }
 
 pub fn beginDefaultPass(action: ClearCommand, width: c_int, height: c_int) void {
     backend.beginDefaultPass(action, width, height);
+    if (draw_order != .immediate) queue.beginPass();
 }
 
 pub fn beginPass(pass: Pass, action: ClearCommand) void {
     backend.beginPass(pass, action);
+    if (draw_order != .immediate) queue.beginPass();
 }
 
 pub fn endPass() void {
+    if (draw_order != .immediate) queue.endPass();
     backend.endPass();
 }
 
 pub fn commitFrame() void {
+    streamer.update();
     backend.commitFrame();
 }
 
@@ -91,10 +244,13 @@ pub fn createBuffer(comptime T: type, desc: BufferDesc(T)) Buffer {
 }
 
 pub fn destroyBuffer(buffer: Buffer) void {
+    flushQueue();
+    queue.forgetBindings();
     backend.destroyBuffer(buffer);
 }
 
 pub fn updateBuffer(comptime T: type, buffer: Buffer, verts: []const T) void {
+    flushQueue();
     backend.updateBuffer(T, buffer, verts);
 }
 
@@ -102,13 +258,52 @@ pub fn appendBuffer(comptime T: type, buffer: Buffer, verts: []const T) u32 {
     return backend.appendBuffer(T, buffer, verts);
 }
 
+/// returns room for `count` elements at the append cursor of `buffer`, in GPU visible memory where the backend allows
+/// it. Write the vertices into the slice and hand them over with `commitAppend` before drawing from the buffer.
+pub fn reserveAppend(comptime T: type, buffer: Buffer, count: usize) []T {
+    return backend.reserveAppend(T, buffer, count);
+}
+
+/// appends the first `count` elements of the reserved slice and returns their byte offset, the same as `appendBuffer`
+pub fn commitAppend(comptime T: type, buffer: Buffer, count: usize) u32 {
+    return backend.commitAppend(T, buffer, count);
+}
+
+/// size, high-water mark and overflow counters of a buffer's appends
+pub fn getBufferStats(buffer: Buffer) BufferStats {
+    return backend.getBufferStats(buffer);
+}
+
 // bindings and drawing
 pub fn applyBindings(bindings: BufferBindings) void {
-    backend.applyBindings(bindings);
+    var resolved = bindings;
+    for (resolved.images) |*image| image.* = streamer.resolve(image.*);
+
+    if (draw_order == .immediate) return backend.applyBindings(resolved);
+    queue.applyBindings(resolved);
 }
 
+/// draws triangles, see `drawElements` for the other primitives and base vertex/instance offsets
 pub fn draw(base_element: c_int, element_count: c_int, instance_count: c_int) void {
-    backend.draw(base_element, element_count, instance_count);
+    drawElements(.{ .base_element = base_element, .element_count = element_count, .instance_count = instance_count });
+}
+
+pub fn drawElements(cmd: DrawCommand) void {
+    if (draw_order == .immediate) return backend.draw(cmd);
+    queue.draw(cmd);
+}
+
+/// draws up to the matching `endDrawBatch` are collected and every run of them sharing bindings, shader, uniforms and
+/// render state goes to the driver as one multi draw call where the backend supports it. Changing any of those in the
+/// middle of a batch is fine, it just starts a new run. Batches nest. Deferred draw orders batch their replays anyway.
+/// Shaders can get the index of a draw within its run from gl_DrawID (GL 4.6 or ARB_shader_draw_parameters). On older
+/// drivers a program declaring `uniform int rk_DrawID;` gets it there instead, its runs are then issued draw by draw.
+pub fn beginDrawBatch() void {
+    backend.beginDrawBatch();
+}
+
+pub fn endDrawBatch() void {
+    backend.endDrawBatch();
 }
 
 // shaders
@@ -116,18 +311,66 @@ pub fn createShaderProgram(comptime FragUniformT: type, desc: ShaderDesc) Shader
     return backend.createShaderProgram(FragUniformT, desc);
 }
 
+/// creates a program per desc, letting the driver compile them side by side where it can. Programs may still be building
+/// when this returns, they can be used right away (the first use waits for them) or polled with `isShaderProgramReady`.
+/// `programs` must be at least as long as `descs`.
+pub fn createShaderPrograms(comptime FragUniformT: type, descs: []const ShaderDesc, programs: []ShaderProgram) void {
+    backend.createShaderPrograms(FragUniformT, descs, programs);
+}
+
+/// false while a program from `createShaderPrograms` is still being compiled. Never blocks.
+pub fn isShaderProgramReady(shader: ShaderProgram) bool {
+    return backend.isShaderProgramReady(shader);
+}
+
 pub fn destroyShaderProgram(shader: ShaderProgram) void {
+    flushQueue();
+    queue.forgetShader(shader);
+    pipelines.removeShader(shader);
     return backend.destroyShaderProgram(shader);
 }
 
 pub fn useShaderProgram(shader: ShaderProgram) void {
-    backend.useShaderProgram(shader);
+    if (draw_order == .immediate) return backend.useShaderProgram(shader);
+    queue.useShaderProgram(shader);
 }
 
 pub fn setShaderProgramUniformBlock(comptime UniformT: type, shader: ShaderProgram, stage: ShaderStage, value: *UniformT) void {
-    backend.setShaderProgramUniformBlock(UniformT, shader, stage, value);
+    if (draw_order == .immediate) return backend.setShaderProgramUniformBlock(UniformT, shader, stage, value);
+    queue.setShaderProgramUniformBlock(UniformT, shader, stage, value);
 }
 
-pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, name: [:0]const u8, value: T) void {
+/// sets a uniform block shared by every shader program, such as the projection matrix. GLSL shaders declare it as a
+/// std140 uniform block named after UniformT, Metal shaders take it as `[[buffer(2)]]` in either stage. On GL contexts
+/// without uniform buffers GLSL shaders declare the fields as plain uniforms of the same names instead.
+pub fn setFrameUniformBlock(comptime UniformT: type, value: *UniformT) void {
+    flushQueue();
+    backend.setFrameUniformBlock(UniformT, value);
+}
+
+pub fn setShaderProgramUniform(comptime T: type, shader: ShaderProgram, comptime name: [:0]const u8, value: T) void {
+    flushQueue();
     backend.setShaderProgramUniform(T, shader, name, value);
 }
+
+// pipelines
+/// returns the pipeline for a shader, vertex layout and render state. Equal descs share one pipeline, so this can be
+/// called every frame, but the returned handle is cheaper to keep around. The backend state object is built on first
+/// use, see `precompilePipelines` to build it earlier. Pipelines live until their shader is destroyed.
+pub fn createPipeline(desc: PipelineDesc) Pipeline {
+    return pipelines.get(desc);
+}
+
+/// builds the backend state objects of `descs` now, behind a loading screen for example, instead of at first use
+pub fn precompilePipelines(descs: []const PipelineDesc) void {
+    pipelines.precompile(descs);
+}
+
+/// sets the shader and render state of `pipeline` in one go. On Metal the prebuilt pipeline state object is used
+/// directly instead of being looked up from the bindings at every applyBindings.
+pub fn usePipeline(pipeline: Pipeline) void {
+    const state = pipelines.getState(pipeline);
+    if (draw_order == .immediate) return backend.usePipeline(state.native);
+    queue.useShaderProgram(state.desc.shader);
+    queue.setRenderState(state.desc.render_state);
+}
@@ -0,0 +1,230 @@
+const std = @import("std");
+usingnamespace @import("types.zig");
+usingnamespace @import("descriptions.zig");
+
+/// per instance record the vertex shader expands into a quad. 52 bytes per sprite instead of four full vertices.
+pub const SpriteInstance = extern struct {
+    /// position of the origin and the origin as a fraction of the size, 0,0 is the top left corner
+    pos: extern struct { x: f32, y: f32, origin_x: f32, origin_y: f32 },
+    /// size in pixels, rotation around the origin in radians and the texture slot the sprite samples
+    size: extern struct { width: f32, height: f32, rotation: f32, slot: f32 },
+    /// top left corner and size of the sprite in its image, in uv space
+    uv: extern struct { x: f32, y: f32, width: f32, height: f32 },
+    color: u32,
+};
+
+/// corner of the unit quad, the only per vertex data
+const Corner = extern struct {
+    pos: extern struct { x: f32, y: f32 },
+};
+
+pub const Sprite = struct {
+    x: f32,
+    y: f32,
+    width: f32,
+    height: f32,
+    rotation: f32 = 0,
+    origin_x: f32 = 0,
+    origin_y: f32 = 0,
+    uv: [4]f32 = [_]f32{ 0, 0, 1, 1 },
+    color: u32 = 0xFFFFFFFF,
+};
+
+/// GLSL 3.30 shaders for the sprite batch. The program needs `image_names` as its images and a `u_transform` mat3x2
+/// set with setShaderProgramUniform that maps pixels to clip space.
+pub const glsl_vs =
+    \\#version 330
+    \\uniform mat3x2 u_transform;
+    \\layout(location = 0) in vec2 a_corner;
+    \\layout(location = 1) in vec4 a_pos;
+    \\layout(location = 2) in vec4 a_size;
+    \\layout(location = 3) in vec4 a_uv;
+    \\layout(location = 4) in vec4 a_color;
+    \\out vec2 v_uv;
+    \\out vec4 v_color;
+    \\flat out int v_slot;
+    \\void main() {
+    \\    vec2 local = (a_corner - a_pos.zw) * a_size.xy;
+    \\    float c = cos(a_size.z);
+    \\    float s = sin(a_size.z);
+    \\    vec2 world = a_pos.xy + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+    \\    gl_Position = vec4(u_transform * vec3(world, 1.0), 0.0, 1.0);
+    \\    v_uv = a_uv.xy + a_corner * a_uv.zw;
+    \\    v_color = a_color;
+    \\    v_slot = int(a_size.w);
+    \\}
+;
+
+pub const glsl_fs =
+    \\#version 330
+    \\uniform sampler2D u_textures[8];
+    \\in vec2 v_uv;
+    \\in vec4 v_color;
+    \\flat in int v_slot;
+    \\out vec4 frag_color;
+    \\vec4 sampleSlot(vec2 uv) {
+    \\    // sampler arrays can only be indexed by constants before GLSL 4.00
+    \\    if (v_slot == 0) return texture(u_textures[0], uv);
+    \\    if (v_slot == 1) return texture(u_textures[1], uv);
+    \\    if (v_slot == 2) return texture(u_textures[2], uv);
+    \\    if (v_slot == 3) return texture(u_textures[3], uv);
+    \\    if (v_slot == 4) return texture(u_textures[4], uv);
+    \\    if (v_slot == 5) return texture(u_textures[5], uv);
+    \\    if (v_slot == 6) return texture(u_textures[6], uv);
+    \\    return texture(u_textures[7], uv);
+    \\}
+    \\void main() {
+    \\    frag_color = sampleSlot(v_uv) * v_color;
+    \\}
+;
+
+pub const image_names = [_][:0]const u8{ "u_textures[0]", "u_textures[1]", "u_textures[2]", "u_textures[3]", "u_textures[4]", "u_textures[5]", "u_textures[6]", "u_textures[7]" };
+
+/// instanced 2D sprite batcher. Sprites are collected as `SpriteInstance` records, appended to a stream buffer on
+/// `flush` and drawn with one instanced draw of a static unit quad. Each image gets one of the 8 texture slots of
+/// `BufferBindings`. A sprite with a ninth image, or a full batch, flushes first. The caller binds the shader (see
+/// `glsl_vs`/`glsl_fs`) and its uniforms before drawing and calls `flush` before changing them.
+/// Renderer is `renderkit.renderer` or anything else with its createBuffer, destroyBuffer, appendBuffer, applyBindings
+/// and drawElements.
+pub fn SpriteBatch(comptime Renderer: type) type {
+    return struct {
+        const Self = @This();
+        const max_slots = 8;
+
+        pub const Stats = struct {
+            sprites: u32 = 0,
+            flushes: u32 = 0,
+            /// flushes caused by running out of texture slots
+            slot_flushes: u32 = 0,
+        };
+
+        allocator: *std.mem.Allocator,
+        index_buffer: Buffer,
+        corner_buffer: Buffer,
+        instance_buffer: Buffer,
+        instances: []SpriteInstance,
+        count: usize = 0,
+        images: [max_slots]Image = [_]Image{0} ** max_slots,
+        stats: Stats = .{},
+
+        /// `max_sprites` is the most sprites drawn with a single draw. The stream buffer starts with room for one
+        /// batch per frame and grows when a frame draws more.
+        pub fn init(allocator: *std.mem.Allocator, max_sprites: usize) Self {
+            const corners = [_]Corner{
+                .{ .pos = .{ .x = 0, .y = 0 } },
+                .{ .pos = .{ .x = 1, .y = 0 } },
+                .{ .pos = .{ .x = 1, .y = 1 } },
+                .{ .pos = .{ .x = 0, .y = 1 } },
+            };
+            const indices = [_]u16{ 0, 1, 2, 2, 3, 0 };
+
+            return .{
+                .allocator = allocator,
+                .index_buffer = Renderer.createBuffer(u16, .{ .type = .index, .content = &indices }),
+                .corner_buffer = Renderer.createBuffer(Corner, .{ .content = &corners }),
+                .instance_buffer = Renderer.createBuffer(SpriteInstance, .{
+                    .usage = .stream,
+                    .size = @intCast(c_long, max_sprites * @sizeOf(SpriteInstance)),
+                    .step_func = .per_instance,
+                    .grow = true,
+                }),
+                .instances = allocator.alloc(SpriteInstance, max_sprites) catch unreachable,
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            Renderer.destroyBuffer(self.index_buffer);
+            Renderer.destroyBuffer(self.corner_buffer);
+            Renderer.destroyBuffer(self.instance_buffer);
+            self.allocator.free(self.instances);
+        }
+
+        pub fn draw(self: *Self, image: Image, sprite: Sprite) void {
+            // flush before picking a slot, flushing clears them
+            if (self.count == self.instances.len) self.flush();
+            const slot = self.slotFor(image);
+
+            self.instances[self.count] = .{
+                .pos = .{ .x = sprite.x, .y = sprite.y, .origin_x = sprite.origin_x, .origin_y = sprite.origin_y },
+                .size = .{ .width = sprite.width, .height = sprite.height, .rotation = sprite.rotation, .slot = @intToFloat(f32, slot) },
+                .uv = .{ .x = sprite.uv[0], .y = sprite.uv[1], .width = sprite.uv[2], .height = sprite.uv[3] },
+                .color = sprite.color,
+            };
+            self.count += 1;
+            self.stats.sprites += 1;
+        }
+
+        /// the texture slot of `image` in the current batch, flushing when all slots are taken
+        fn slotFor(self: *Self, image: Image) usize {
+            for (self.images) |bound, slot| {
+                if (bound == image) return slot;
+                if (bound == 0) {
+                    self.images[slot] = image;
+                    return slot;
+                }
+            }
+
+            self.stats.slot_flushes += 1;
+            self.flush();
+            self.images[0] = image;
+            return 0;
+        }
+
+        /// uploads and draws the collected sprites
+        pub fn flush(self: *Self) void {
+            if (self.count == 0) return;
+
+            const offset = Renderer.appendBuffer(SpriteInstance, self.instance_buffer, self.instances[0..self.count]);
+            // every append is whole instances so the offset always lands on one
+            std.debug.assert(offset % @sizeOf(SpriteInstance) == 0);
+
+            var vert_buffers = [_]Buffer{ self.corner_buffer, self.instance_buffer };
+            var bindings = BufferBindings.init(self.index_buffer, &vert_buffers);
+            bindings.images = self.images;
+            Renderer.applyBindings(bindings);
+            Renderer.drawElements(.{
+                .element_count = 6,
+                .instance_count = @intCast(c_int, self.count),
+                .base_instance = @intCast(c_int, offset / @sizeOf(SpriteInstance)),
+            });
+
+            self.count = 0;
+            self.images = [_]Image{0} ** max_slots;
+            self.stats.flushes += 1;
+        }
+    };
+}
+
+const Recording = @import("dummy/recording.zig");
+
+test "sprite batch flushes on full batches and texture slot exhaustion" {
+    Recording.reset();
+    var batch = SpriteBatch(Recording).init(std.testing.allocator, 100);
+    defer batch.deinit();
+
+    var i: u32 = 0;
+    while (i < 250) : (i += 1) batch.draw(1, .{ .x = 0, .y = 0, .width = 16, .height = 16 });
+    batch.flush();
+    std.testing.expectEqual(@as(u32, 3), Recording.draws);
+    std.testing.expectEqual(@as(c_int, 50), Recording.last_cmd.instance_count);
+    std.testing.expectEqual(@as(c_int, 200), Recording.last_cmd.base_instance);
+
+    // eight images share a batch, the ninth starts a new one in slot 0
+    var image: Image = 1;
+    while (image <= 9) : (image += 1) batch.draw(image, .{ .x = 0, .y = 0, .width = 16, .height = 16 });
+    std.testing.expectEqual(@as(u32, 4), Recording.draws);
+    std.testing.expectEqual(@as(u32, 1), batch.stats.slot_flushes);
+    std.testing.expectEqual(@as(Image, 8), Recording.last_bindings.images[7]);
+    std.testing.expectEqual(@as(Image, 9), batch.images[0]);
+    std.testing.expectEqual(@as(f32, 0), batch.instances[0].size.slot);
+
+    // the sprite that overflows a full batch starts the next one with its own image
+    batch.flush();
+    i = 0;
+    while (i < 100) : (i += 1) batch.draw(1, .{ .x = 0, .y = 0, .width = 16, .height = 16 });
+    batch.draw(2, .{ .x = 0, .y = 0, .width = 16, .height = 16 });
+    std.testing.expectEqual(@as(usize, 1), batch.count);
+    std.testing.expectEqual(@as(Image, 2), batch.images[0]);
+    std.testing.expectEqual(@as(Image, 0), batch.images[1]);
+    std.testing.expectEqual(@as(f32, 0), batch.instances[0].size.slot);
+}
@@ -0,0 +1,521 @@
+const std = @import("std");
+usingnamespace @import("types.zig");
+usingnamespace @import("descriptions.zig");
+
+/// skyline bottom-left rectangle packer. The skyline is the top edge of everything placed so far, stored as horizontal
+/// segments from left to right. A rectangle goes where its top edge ends up lowest, the narrower segment wins ties.
+pub const Skyline = struct {
+    const Node = struct {
+        x: u32,
+        y: u32,
+        width: u32,
+    };
+
+    nodes: std.ArrayList(Node),
+    width: u32,
+    height: u32,
+
+    pub fn init(allocator: *std.mem.Allocator, width: u32, height: u32) Skyline {
+        var self = Skyline{ .nodes = std.ArrayList(Node).init(allocator), .width = width, .height = height };
+        self.reset();
+        return self;
+    }
+
+    pub fn deinit(self: Skyline) void {
+        self.nodes.deinit();
+    }
+
+    pub fn reset(self: *Skyline) void {
+        self.nodes.items.len = 0;
+        self.nodes.append(.{ .x = 0, .y = 0, .width = self.width }) catch unreachable;
+    }
+
+    /// returns the top left corner of a free `width` x `height` rectangle, null if there is no room left
+    pub fn insert(self: *Skyline, width: u32, height: u32) ?[2]u32 {
+        // covers nothing, so it fits anywhere and must not leave a zero width segment behind
+        if (width == 0 or height == 0) return [2]u32{ 0, 0 };
+
+        var best: ?usize = null;
+        var best_top: u32 = std.math.maxInt(u32);
+        var best_width: u32 = std.math.maxInt(u32);
+        var best_y: u32 = 0;
+
+        for (self.nodes.items) |node, i| {
+            const y = self.fits(i, width, height) orelse continue;
+            if (y + height < best_top or (y + height == best_top and node.width < best_width)) {
+                best = i;
+                best_top = y + height;
+                best_width = node.width;
+                best_y = y;
+            }
+        }
+
+        const index = best orelse return null;
+        const x = self.nodes.items[index].x;
+        self.nodes.insert(index, .{ .x = x, .y = best_y + height, .width = width }) catch unreachable;
+
+        // the new segment covers the start of the ones after it
+        var i = index + 1;
+        while (i < self.nodes.items.len) {
+            const prev = self.nodes.items[i - 1];
+            const node = &self.nodes.items[i];
+            if (node.x >= prev.x + prev.width) break;
+
+            const covered = prev.x + prev.width - node.x;
+            if (node.width <= covered) {
+                _ = self.nodes.orderedRemove(i);
+                continue;
+            }
+            node.x += covered;
+            node.width -= covered;
+            break;
+        }
+
+        // neighbours at the same height become one segment
+        i = 0;
+        while (i + 1 < self.nodes.items.len) {
+            if (self.nodes.items[i].y == self.nodes.items[i + 1].y) {
+                self.nodes.items[i].width += self.nodes.items[i + 1].width;
+                _ = self.nodes.orderedRemove(i + 1);
+            } else {
+                i += 1;
+            }
+        }
+
+        return [2]u32{ x, best_y };
+    }
+
+    /// the y a rectangle placed at the start of node `index` rests at, null if it sticks out of the page
+    fn fits(self: Skyline, index: usize, width: u32, height: u32) ?u32 {
+        const nodes = self.nodes.items;
+        if (nodes[index].x + width > self.width) return null;
+
+        var y: u32 = 0;
+        var remaining = width;
+        var i = index;
+        while (true) : (i += 1) {
+            y = std.math.max(y, nodes[i].y);
+            if (y + height > self.height) return null;
+            if (nodes[i].width >= remaining) return y;
+            remaining -= nodes[i].width;
+        }
+    }
+};
+
+/// packs many small, changing images (glyphs, avatars, generated icons) into a few large rgba8 pages so they share
+/// bindings and batch together. Entries are looked up by a caller chosen key and drawn with the page image and the uv
+/// rect of the returned `Region`. Pixels are kept on the CPU and the rectangles touched since the last `update` are
+/// uploaded with updateImageRegion, so call `update` once per frame after adding and before drawing.
+/// When every page is full the least recently used entries are evicted and their page is compacted by repacking the
+/// survivors. Entries used this frame are never picked for eviction and are repacked first, so compaction only loses
+/// one of them if the page can't fit this frame's entries together. Compaction moves entries, so look regions up
+/// every frame instead of keeping them.
+/// Backend is anything with createImage, destroyImage and updateImageRegion, usually `renderkit.renderer`.
+pub fn TextureAtlas(comptime Backend: type) type {
+    return struct {
+        const Self = @This();
+        /// past this many dirty rectangles a page uploads their bounding box instead
+        const max_dirty_rects = 16;
+
+        pub const Options = struct {
+            page_size: u32 = 1024,
+            max_pages: usize = 4,
+            /// transparent texels right and below each entry so filtering doesn't bleed into the neighbours
+            padding: u32 = 1,
+            filter: TextureFilter = .linear,
+        };
+
+        pub const Region = struct {
+            image: Image,
+            /// top left corner and size in uv space, like `Sprite.uv`
+            uv: [4]f32,
+        };
+
+        pub const Stats = struct {
+            entries: u32 = 0,
+            evictions: u32 = 0,
+            compactions: u32 = 0,
+            uploaded_bytes: u64 = 0,
+        };
+
+        const Rect = struct {
+            x: u32,
+            y: u32,
+            width: u32,
+            height: u32,
+
+            fn merge(self: Rect, other: Rect) Rect {
+                const x = std.math.min(self.x, other.x);
+                const y = std.math.min(self.y, other.y);
+                return .{
+                    .x = x,
+                    .y = y,
+                    .width = std.math.max(self.x + self.width, other.x + other.width) - x,
+                    .height = std.math.max(self.y + self.height, other.y + other.height) - y,
+                };
+            }
+        };
+
+        const Entry = struct {
+            page: usize,
+            rect: Rect,
+            last_used: u32,
+        };
+
+        const Page = struct {
+            image: Image,
+            pixels: []u32,
+            skyline: Skyline,
+            dirty: std.ArrayList(Rect),
+        };
+
+        allocator: *std.mem.Allocator,
+        options: Options,
+        pages: std.ArrayList(Page),
+        entries: std.AutoHashMap(u64, Entry),
+        /// advanced by `update`, entries remember the frame they were last used in
+        frame: u32 = 1,
+        stats: Stats = .{},
+
+        pub fn init(allocator: *std.mem.Allocator, options: Options) Self {
+            return .{
+                .allocator = allocator,
+                .options = options,
+                .pages = std.ArrayList(Page).init(allocator),
+                .entries = std.AutoHashMap(u64, Entry).init(allocator),
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            for (self.pages.items) |page| {
+                Backend.destroyImage(page.image);
+                self.allocator.free(page.pixels);
+                page.skyline.deinit();
+                page.dirty.deinit();
+            }
+            self.pages.deinit();
+            self.entries.deinit();
+        }
+
+        /// returns the region of `key` and marks it used this frame
+        pub fn get(self: *Self, key: u64) ?Region {
+            const entry = self.entries.getEntry(key) orelse return null;
+            entry.value.last_used = self.frame;
+            return self.region(entry.value);
+        }
+
+        /// copies `pixels` into the atlas under `key`. `row_pitch` is the number of bytes between rows of `pixels`, 0 if
+        /// they are tightly packed. Returns the existing region if `key` is already in the atlas and null if the image is
+        /// larger than a page or no room can be made.
+        pub fn add(self: *Self, key: u64, width: u32, height: u32, row_pitch: u32, pixels: []const u32) ?Region {
+            if (self.get(key)) |existing| return existing;
+
+            const pitch = if (row_pitch == 0) width else row_pitch / @sizeOf(u32);
+            std.debug.assert(height == 0 or pixels.len >= (height - 1) * pitch + width);
+
+            const slot = self.place(width + self.options.padding, height + self.options.padding) orelse return null;
+            const page = &self.pages.items[slot.page];
+            const rect = Rect{ .x = slot.x, .y = slot.y, .width = width, .height = height };
+
+            var y: u32 = 0;
+            while (y < height) : (y += 1) {
+                std.mem.copy(u32, page.pixels[(rect.y + y) * self.options.page_size + rect.x ..][0..width], pixels[y * pitch ..][0..width]);
+            }
+            self.markDirty(page, .{ .x = rect.x, .y = rect.y, .width = width + self.options.padding, .height = height + self.options.padding });
+
+            const entry = Entry{ .page = slot.page, .rect = rect, .last_used = self.frame };
+            self.entries.putNoClobber(key, entry) catch unreachable;
+            self.stats.entries += 1;
+            return self.region(entry);
+        }
+
+        /// frees the space of `key` at the next compaction of its page
+        pub fn remove(self: *Self, key: u64) void {
+            if (self.entries.remove(key) != null) self.stats.entries -= 1;
+        }
+
+        /// uploads the rectangles changed since the last call and starts a new frame for the LRU
+        pub fn update(self: *Self) void {
+            for (self.pages.items) |*page| {
+                for (page.dirty.items) |rect| {
+                    const first = rect.y * self.options.page_size + rect.x;
+                    const last = (rect.y + rect.height - 1) * self.options.page_size + rect.x + rect.width;
+                    Backend.updateImageRegion(
+                        u32,
+                        page.image,
+                        @intCast(i32, rect.x),
+                        @intCast(i32, rect.y),
+                        @intCast(i32, rect.width),
+                        @intCast(i32, rect.height),
+                        self.options.page_size * @sizeOf(u32),
+                        page.pixels[first..last],
+                    );
+                    self.stats.uploaded_bytes += rect.width * rect.height * @sizeOf(u32);
+                }
+                page.dirty.items.len = 0;
+            }
+            self.frame += 1;
+        }
+
+        fn region(self: Self, entry: Entry) Region {
+            const size = @intToFloat(f32, self.options.page_size);
+            return .{
+                .image = self.pages.items[entry.page].image,
+                .uv = [_]f32{
+                    @intToFloat(f32, entry.rect.x) / size,
+                    @intToFloat(f32, entry.rect.y) / size,
+                    @intToFloat(f32, entry.rect.width) / size,
+                    @intToFloat(f32, entry.rect.height) / size,
+                },
+            };
+        }
+
+        fn markDirty(self: *Self, page: *Page, rect: Rect) void {
+            const size = self.options.page_size;
+            const clipped = Rect{
+                .x = rect.x,
+                .y = rect.y,
+                .width = std.math.min(rect.width, size - rect.x),
+                .height = std.math.min(rect.height, size - rect.y),
+            };
+            // an empty image without padding, like the space glyph of a font, has nothing to upload
+            if (clipped.width == 0 or clipped.height == 0) return;
+
+            if (page.dirty.items.len == max_dirty_rects) {
+                var bounds = clipped;
+                for (page.dirty.items) |dirty| bounds = bounds.merge(dirty);
+                page.dirty.items.len = 0;
+                page.dirty.append(bounds) catch unreachable;
+            } else {
+                page.dirty.append(clipped) catch unreachable;
+            }
+        }
+
+        const Slot = struct {
+            page: usize,
+            x: u32,
+            y: u32,
+        };
+
+        /// finds room in an existing page, then in a new page, then by evicting
+        fn place(self: *Self, width: u32, height: u32) ?Slot {
+            // the padding of entries on the right and bottom edge may fall off the page
+            const size = self.options.page_size + self.options.padding;
+            if (width > size or height > size) return null;
+
+            for (self.pages.items) |*page, i| {
+                if (page.skyline.insert(width, height)) |pos| return Slot{ .page = i, .x = pos[0], .y = pos[1] };
+            }
+
+            if (self.pages.items.len < self.options.max_pages) {
+                self.addPage();
+                const pos = self.pages.items[self.pages.items.len - 1].skyline.insert(width, height).?;
+                return Slot{ .page = self.pages.items.len - 1, .x = pos[0], .y = pos[1] };
+            }
+
+            return self.evict(width, height);
+        }
+
+        fn addPage(self: *Self) void {
+            const size = self.options.page_size;
+            var pixels = self.allocator.alloc(u32, size * size) catch unreachable;
+            std.mem.set(u32, pixels, 0);
+
+            const page = Page{
+                .image = Backend.createImage(.{
+                    .width = @intCast(i32, size),
+                    .height = @intCast(i32, size),
+                    .usage = .dynamic,
+                    .min_filter = self.options.filter,
+                    .mag_filter = self.options.filter,
+                }),
+                .pixels = pixels,
+                // the skyline includes the padding of the last row and column which is allowed to fall off the page
+                .skyline = Skyline.init(self.allocator, size + self.options.padding, size + self.options.padding),
+                .dirty = std.ArrayList(Rect).init(self.allocator),
+            };
+            self.pages.append(page) catch unreachable;
+            self.markDirty(&self.pages.items[self.pages.items.len - 1], .{ .x = 0, .y = 0, .width = size, .height = size });
+        }
+
+        const Candidate = struct {
+            key: u64,
+            last_used: u32,
+        };
+
+        fn olderThan(context: void, a: Candidate, b: Candidate) bool {
+            return a.last_used < b.last_used;
+        }
+
+        /// evicts entries not used this frame, oldest first, until a compacted page has room
+        fn evict(self: *Self, width: u32, height: u32) ?Slot {
+            var candidates = std.ArrayList(Candidate).init(self.allocator);
+            defer candidates.deinit();
+            var iter = self.entries.iterator();
+            while (iter.next()) |kv| {
+                if (kv.value.last_used < self.frame) candidates.append(.{ .key = kv.key, .last_used = kv.value.last_used }) catch unreachable;
+            }
+            std.sort.sort(Candidate, candidates.items, {}, olderThan);
+
+            var freed = self.allocator.alloc(u64, self.pages.items.len) catch unreachable;
+            defer self.allocator.free(freed);
+            std.mem.set(u64, freed, 0);
+
+            const needed = @as(u64, width) * height;
+            for (candidates.items) |candidate| {
+                // an earlier compact may already have lost it
+                const entry = (self.entries.remove(candidate.key) orelse continue).value;
+                self.stats.entries -= 1;
+                self.stats.evictions += 1;
+
+                const page = entry.page;
+                freed[page] += @as(u64, entry.rect.width + self.options.padding) * (entry.rect.height + self.options.padding);
+                if (freed[page] < needed) continue;
+
+                freed[page] = 0;
+                self.compact(page);
+                if (self.pages.items[page].skyline.insert(width, height)) |pos| return Slot{ .page = page, .x = pos[0], .y = pos[1] };
+            }
+
+            // out of candidates, the space freed so far may still add up
+            for (freed) |area, page| {
+                if (area == 0) continue;
+                self.compact(page);
+                if (self.pages.items[page].skyline.insert(width, height)) |pos| return Slot{ .page = page, .x = pos[0], .y = pos[1] };
+            }
+            return null;
+        }
+
+        /// repacks the entries of a page into fresh pixels and reuploads the whole page. Entries used this frame go
+        /// first, each group tallest first, so an entry that no longer fits and gets evicted is an older one.
+        fn compact(self: *Self, page_index: usize) void {
+            const page = &self.pages.items[page_index];
+            const size = self.options.page_size;
+            self.stats.compactions += 1;
+
+            var moved = std.ArrayList(*std.AutoHashMap(u64, Entry).Entry).init(self.allocator);
+            defer moved.deinit();
+            var iter = self.entries.iterator();
+            while (iter.next()) |kv| {
+                if (kv.value.page == page_index) moved.append(kv) catch unreachable;
+            }
+            std.sort.sort(*std.AutoHashMap(u64, Entry).Entry, moved.items, self.frame, placedBefore);
+
+            var pixels = self.allocator.alloc(u32, size * size) catch unreachable;
+            std.mem.set(u32, pixels, 0);
+
+            var lost = std.ArrayList(u64).init(self.allocator);
+            defer lost.deinit();
+
+            page.skyline.reset();
+            for (moved.items) |kv| {
+                const old = kv.value.rect;
+                const pos = page.skyline.insert(old.width + self.options.padding, old.height + self.options.padding) orelse {
+                    lost.append(kv.key) catch unreachable;
+                    continue;
+                };
+
+                var y: u32 = 0;
+                while (y < old.height) : (y += 1) {
+                    std.mem.copy(u32, pixels[(pos[1] + y) * size + pos[0] ..][0..old.width], page.pixels[(old.y + y) * size + old.x ..][0..old.width]);
+                }
+                kv.value.rect.x = pos[0];
+                kv.value.rect.y = pos[1];
+            }
+
+            for (lost.items) |key| {
+                _ = self.entries.remove(key);
+                self.stats.entries -= 1;
+                self.stats.evictions += 1;
+            }
+
+            self.allocator.free(page.pixels);
+            page.pixels = pixels;
+            page.dirty.items.len = 0;
+            self.markDirty(page, .{ .x = 0, .y = 0, .width = size, .height = size });
+        }
+
+        fn placedBefore(frame: u32, a: *std.AutoHashMap(u64, Entry).Entry, b: *std.AutoHashMap(u64, Entry).Entry) bool {
+            const a_current = a.value.last_used == frame;
+            if (a_current != (b.value.last_used == frame)) return a_current;
+            return a.value.rect.height > b.value.rect.height;
+        }
+    };
+}
+
+test "skyline packs without overlap" {
+    var skyline = Skyline.init(std.testing.allocator, 64, 64);
+    defer skyline.deinit();
+
+    var rects: [64][4]u32 = undefined;
+    var count: usize = 0;
+    var rng = std.rand.DefaultPrng.init(5);
+    while (count < rects.len) : (count += 1) {
+        const width = rng.random.intRangeAtMost(u32, 1, 12);
+        const height = rng.random.intRangeAtMost(u32, 1, 12);
+        const pos = skyline.insert(width, height) orelse break;
+        std.testing.expect(pos[0] + width <= 64 and pos[1] + height <= 64);
+        rects[count] = [_]u32{ pos[0], pos[1], width, height };
+    }
+    std.testing.expect(count > 16);
+
+    for (rects[0..count]) |a, i| {
+        for (rects[i + 1 .. count]) |b| {
+            const apart = a[0] + a[2] <= b[0] or b[0] + b[2] <= a[0] or a[1] + a[3] <= b[1] or b[1] + b[3] <= a[1];
+            std.testing.expect(apart);
+        }
+    }
+
+    skyline.reset();
+    std.testing.expectEqual([2]u32{ 0, 0 }, skyline.insert(0, 12).?);
+    std.testing.expectEqual(@as(usize, 1), skyline.nodes.items.len);
+    std.testing.expect(skyline.insert(65, 1) == null);
+    std.testing.expectEqual([2]u32{ 0, 0 }, skyline.insert(64, 64).?);
+    std.testing.expect(skyline.insert(1, 1) == null);
+}
+
+const Recording = @import("dummy/recording.zig");
+
+test "atlas evicts the least recently used and compacts" {
+    Recording.reset();
+    var atlas = TextureAtlas(Recording).init(std.testing.allocator, .{ .page_size = 64, .max_pages = 1, .padding = 0 });
+    defer atlas.deinit();
+
+    // sixteen 16x16 tiles fill the page
+    var tile = [_]u32{0xFF0000FF} ** (16 * 16);
+    var key: u64 = 0;
+    while (key < 16) : (key += 1) std.testing.expect(atlas.add(key, 16, 16, 0, &tile) != null);
+    std.testing.expectEqual(Usage.dynamic, Recording.last_image_desc.usage);
+    const first = atlas.get(0).?;
+    std.testing.expectEqual([4]f32{ 0, 0, 0.25, 0.25 }, first.uv);
+
+    // nothing can be evicted while every entry was used this frame
+    std.testing.expect(atlas.add(100, 16, 16, 0, &tile) == null);
+    // an empty image takes no space and marks nothing dirty
+    std.testing.expectEqual(@as(f32, 0), atlas.add(200, 0, 16, 0, &tile).?.uv[2]);
+    atlas.remove(200);
+
+    atlas.update();
+    std.testing.expectEqual(@as(u32, 1), Recording.uploads);
+    std.testing.expectEqual(@as(usize, 64 * 64 * 4), Recording.uploaded_bytes);
+
+    // keep all but key 3 alive, which leaves it the one to go
+    key = 0;
+    while (key < 16) : (key += 1) {
+        if (key != 3) _ = atlas.get(key);
+    }
+    atlas.update();
+    var blue = [_]u32{0xFFFF0000} ** (16 * 16);
+    const added = atlas.add(100, 16, 16, 0, &blue).?;
+    std.testing.expect(atlas.get(3) == null);
+    std.testing.expectEqual(@as(u32, 1), atlas.stats.evictions);
+    std.testing.expectEqual(@as(u32, 1), atlas.stats.compactions);
+    std.testing.expectEqual(@as(u32, 16), atlas.stats.entries);
+
+    // the new tile's texels landed where its region points
+    const page = atlas.pages.items[0];
+    const x = @floatToInt(u32, added.uv[0] * 64);
+    const y = @floatToInt(u32, added.uv[1] * 64);
+    std.testing.expectEqual(@as(u32, 0xFFFF0000), page.pixels[y * 64 + x]);
+    std.testing.expectEqual(@as(u32, 0xFF0000FF), page.pixels[(y + 16) % 64 * 64 + x]);
+}
@@ -0,0 +1,270 @@
+const std = @import("std");
+const renderkit = @import("types.zig");
+const PixelFormat = renderkit.PixelFormat;
+
+/// a 2D texture stored in a KTX (version 1) or DDS container. Parsing copies nothing: every level points into the file
+/// bytes so the levels can be uploaded straight from a memory mapping.
+pub const TextureFile = struct {
+    pub const max_levels = 16;
+    pub const max_size = 16384;
+    pub const Error = error{ InvalidFile, UnsupportedFormat };
+
+    pub const Level = struct {
+        data: []const u8,
+        row_pitch: u32 = 0, // bytes between rows, 0 if tightly packed
+    };
+
+    format: PixelFormat,
+    width: i32,
+    height: i32,
+    num_levels: u32 = 0,
+    levels: [max_levels]Level = undefined,
+
+    pub fn parse(bytes: []const u8) Error!TextureFile {
+        if (std.mem.startsWith(u8, bytes, &ktx_identifier)) return parseKtx(bytes);
+        if (std.mem.startsWith(u8, bytes, "DDS ")) return parseDds(bytes);
+        return error.InvalidFile;
+    }
+
+    fn init(format: PixelFormat, width: u32, height: u32) Error!TextureFile {
+        if (width == 0 or height == 0 or width > max_size or height > max_size) return error.InvalidFile;
+        return TextureFile{ .format = format, .width = @intCast(i32, width), .height = @intCast(i32, height) };
+    }
+
+    /// adds the next mip level, `size` bytes at `offset`, after checking it covers the whole level
+    fn addLevel(self: *TextureFile, bytes: []const u8, offset: usize, size: usize, row_pitch: u32) Error!void {
+        if (self.num_levels == max_levels) return error.InvalidFile;
+
+        const level = @intCast(i32, self.num_levels);
+        const width = renderkit.mipSize(self.width, level);
+        const height = renderkit.mipSize(self.height, level);
+        const min_size = if (row_pitch == 0)
+            self.format.imageSize(width, height)
+        else
+            row_pitch * @intCast(u32, height - 1) + self.format.rowPitch(width);
+
+        if (size < min_size or offset + size > bytes.len) return error.InvalidFile;
+        self.levels[self.num_levels] = .{ .data = bytes[offset .. offset + size], .row_pitch = row_pitch };
+        self.num_levels += 1;
+    }
+};
+
+fn readU32(bytes: []const u8, offset: usize) u32 {
+    return std.mem.readIntSliceLittle(u32, bytes[offset .. offset + 4]);
+}
+
+fn fourCC(comptime code: *const [4]u8) u32 {
+    return std.mem.readIntLittle(u32, code);
+}
+
+// KTX 1: a 64 byte header of u32s, key/value data and then every level prefixed with its size
+const ktx_identifier = [12]u8{ 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+const ktx_header_size = 64;
+
+fn parseKtx(bytes: []const u8) TextureFile.Error!TextureFile {
+    if (bytes.len < ktx_header_size) return error.InvalidFile;
+    // files written big endian would need every word swapped
+    if (readU32(bytes, 12) != 0x04030201) return error.UnsupportedFormat;
+    // 3D textures, arrays and cube maps
+    if (readU32(bytes, 44) > 1 or readU32(bytes, 48) != 0 or readU32(bytes, 52) != 1) return error.UnsupportedFormat;
+
+    const format = ktxFormat(readU32(bytes, 28)) orelse return error.UnsupportedFormat;
+    // 1D textures have a height of 0
+    var file = try TextureFile.init(format, readU32(bytes, 36), std.math.max(1, readU32(bytes, 40)));
+
+    // 0 levels asks the loader to generate the mipmaps, only the base level is stored
+    const num_levels = std.math.max(1, readU32(bytes, 56));
+    var offset: usize = ktx_header_size + @as(usize, readU32(bytes, 60));
+    var level: u32 = 0;
+    while (level < num_levels) : (level += 1) {
+        if (offset + 4 > bytes.len) return error.InvalidFile;
+        const size = readU32(bytes, offset);
+        offset += 4;
+
+        // uncompressed rows are padded to 4 bytes, GL's default unpack alignment
+        const width = renderkit.mipSize(file.width, @intCast(i32, level));
+        const row_pitch = if (format.isCompressed()) 0 else std.mem.alignForwardGeneric(u32, format.rowPitch(width), 4);
+        try file.addLevel(bytes, offset, size, row_pitch);
+        offset += std.mem.alignForward(size, 4);
+    }
+
+    return file;
+}
+
+/// the GL internal formats are spelled out so this stays independent of the backends
+fn ktxFormat(gl_internal_format: u32) ?PixelFormat {
+    return switch (gl_internal_format) {
+        0x8058 => .rgba8, // GL_RGBA8
+        0x8229 => .r8, // GL_R8
+        0x822B => .rg8, // GL_RG8
+        0x8D62 => .rgb565, // GL_RGB565
+        0x83F0, 0x83F1 => .bc1, // GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+        0x83F3 => .bc3, // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+        0x8E8C => .bc7, // GL_COMPRESSED_RGBA_BPTC_UNORM
+        0x9274 => .etc2_rgb8, // GL_COMPRESSED_RGB8_ETC2
+        0x9278 => .etc2_rgba8, // GL_COMPRESSED_RGBA8_ETC2_EAC
+        0x93B0 => .astc_4x4, // GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+        else => null,
+    };
+}
+
+// DDS: the magic, a 124 byte header, an optional 20 byte DX10 header and then the tightly packed levels
+const dds_header_size = 128;
+const dds_dx10_header_size = 20;
+const ddsd_mipmapcount = 0x20000;
+const ddscaps2_cubemap = 0x200;
+const ddpf_alphapixels = 0x1;
+const ddpf_fourcc = 0x4;
+const ddpf_rgb = 0x40;
+const ddpf_luminance = 0x20000;
+
+fn parseDds(bytes: []const u8) TextureFile.Error!TextureFile {
+    if (bytes.len < dds_header_size or readU32(bytes, 4) != 124) return error.InvalidFile;
+    if (readU32(bytes, 112) & ddscaps2_cubemap != 0 or readU32(bytes, 24) > 1) return error.UnsupportedFormat;
+
+    var offset: usize = dds_header_size;
+    const pf_flags = readU32(bytes, 80);
+    const maybe_format: ?PixelFormat = if (pf_flags & ddpf_fourcc == 0) ddsMaskFormat(bytes, pf_flags) else switch (readU32(bytes, 84)) {
+        fourCC("DXT1") => PixelFormat.bc1,
+        fourCC("DXT5") => PixelFormat.bc3,
+        fourCC("DX10") => blk: {
+            if (bytes.len < dds_header_size + dds_dx10_header_size) return error.InvalidFile;
+            // only plain 2D textures, dimension 3 is D3D10_RESOURCE_DIMENSION_TEXTURE2D
+            if (readU32(bytes, 132) != 3 or readU32(bytes, 136) & 0x4 != 0 or readU32(bytes, 140) > 1) return error.UnsupportedFormat;
+            offset += dds_dx10_header_size;
+            break :blk dxgiFormat(readU32(bytes, 128));
+        },
+        else => null,
+    };
+
+    const format = maybe_format orelse return error.UnsupportedFormat;
+    var file = try TextureFile.init(format, readU32(bytes, 16), readU32(bytes, 12));
+
+    const num_levels = if (readU32(bytes, 8) & ddsd_mipmapcount != 0) std.math.max(1, readU32(bytes, 28)) else 1;
+    var level: u32 = 0;
+    while (level < num_levels) : (level += 1) {
+        const size = format.imageSize(renderkit.mipSize(file.width, @intCast(i32, level)), renderkit.mipSize(file.height, @intCast(i32, level)));
+        try file.addLevel(bytes, offset, size, 0);
+        offset += size;
+    }
+
+    return file;
+}
+
+/// uncompressed legacy formats are described by their channel masks
+fn ddsMaskFormat(bytes: []const u8, pf_flags: u32) ?PixelFormat {
+    const bit_count = readU32(bytes, 88);
+    const r = readU32(bytes, 92);
+    const g = readU32(bytes, 96);
+    const b = readU32(bytes, 100);
+    const a = readU32(bytes, 104);
+
+    if (pf_flags & ddpf_rgb != 0) {
+        if (bit_count == 32 and r == 0xFF and g == 0xFF00 and b == 0xFF0000 and a == 0xFF000000) return .rgba8;
+        if (bit_count == 16 and r == 0xF800 and g == 0x7E0 and b == 0x1F and a == 0) return .rgb565;
+    } else if (pf_flags & ddpf_luminance != 0) {
+        if (bit_count == 8 and r == 0xFF) return .r8;
+        if (bit_count == 16 and r == 0xFF and pf_flags & ddpf_alphapixels != 0 and a == 0xFF00) return .rg8;
+    }
+    return null;
+}
+
+fn dxgiFormat(format: u32) ?PixelFormat {
+    return switch (format) {
+        28 => .rgba8, // DXGI_FORMAT_R8G8B8A8_UNORM
+        49 => .rg8, // DXGI_FORMAT_R8G8_UNORM
+        61 => .r8, // DXGI_FORMAT_R8_UNORM
+        71 => .bc1, // DXGI_FORMAT_BC1_UNORM
+        77 => .bc3, // DXGI_FORMAT_BC3_UNORM
+        85 => .rgb565, // DXGI_FORMAT_B5G6R5_UNORM
+        98 => .bc7, // DXGI_FORMAT_BC7_UNORM
+        else => null,
+    };
+}
+
+/// a read only view of a whole file. Memory mapped where the OS supports it and read into memory otherwise.
+pub const MappedFile = struct {
+    bytes: []align(std.mem.page_size) const u8,
+    allocator: ?*std.mem.Allocator = null,
+
+    pub fn open(allocator: *std.mem.Allocator, path: []const u8) !MappedFile {
+        const file = try std.fs.cwd().openFile(path, .{});
+        defer file.close();
+
+        const size = @intCast(usize, try file.getEndPos());
+        if (size == 0) return error.InvalidFile;
+
+        if (std.builtin.os.tag == .windows) {
+            const bytes = try allocator.allocAdvanced(u8, std.mem.page_size, size, .exact);
+            errdefer allocator.free(bytes);
+            if ((try file.readAll(bytes)) != size) return error.InvalidFile;
+            return MappedFile{ .bytes = bytes, .allocator = allocator };
+        }
+
+        const bytes = try std.os.mmap(null, size, std.os.PROT_READ, std.os.MAP_PRIVATE, file.handle, 0);
+        return MappedFile{ .bytes = bytes };
+    }
+
+    pub fn close(self: MappedFile) void {
+        if (self.allocator) |allocator| {
+            allocator.free(self.bytes);
+        } else {
+            std.os.munmap(self.bytes);
+        }
+    }
+};
+
+test "parse ktx" {
+    // 3x2 r8 with two levels. Rows are padded to 4 bytes.
+    var bytes = [_]u8{0} ** (ktx_header_size + 4 + 8 + 4 + 4);
+    std.mem.copy(u8, &bytes, &ktx_identifier);
+    const header = [_]u32{ 0x04030201, 0x1401, 1, 0x1903, 0x8229, 0x1903, 3, 2, 0, 0, 1, 2, 0 };
+    for (header) |word, i| std.mem.writeIntLittle(u32, bytes[12 + i * 4 ..][0..4], word);
+    std.mem.writeIntLittle(u32, bytes[ktx_header_size..][0..4], 8);
+    std.mem.writeIntLittle(u32, bytes[ktx_header_size + 12 ..][0..4], 1);
+
+    const file = try TextureFile.parse(&bytes);
+    std.testing.expectEqual(PixelFormat.r8, file.format);
+    std.testing.expectEqual(@as(i32, 3), file.width);
+    std.testing.expectEqual(@as(i32, 2), file.height);
+    std.testing.expectEqual(@as(u32, 2), file.num_levels);
+    std.testing.expectEqual(@as(usize, 8), file.levels[0].data.len);
+    std.testing.expectEqual(@as(u32, 4), file.levels[0].row_pitch);
+    std.testing.expectEqual(@as(usize, ktx_header_size + 16), @ptrToInt(file.levels[1].data.ptr) - @ptrToInt(&bytes));
+
+    // a level running past the end of the file
+    std.mem.writeIntLittle(u32, bytes[ktx_header_size + 12 ..][0..4], 5);
+    std.testing.expectError(error.InvalidFile, TextureFile.parse(&bytes));
+}
+
+test "parse dds" {
+    // 8x8 DXT1 with the full chain of 4 levels: 4 blocks, then 1 block for each level down to 1x1
+    var bytes = [_]u8{0} ** (dds_header_size + 4 * 8 + 3 * 8);
+    std.mem.copy(u8, &bytes, "DDS ");
+    std.mem.writeIntLittle(u32, bytes[4..8], 124);
+    std.mem.writeIntLittle(u32, bytes[8..12], ddsd_mipmapcount);
+    std.mem.writeIntLittle(u32, bytes[12..16], 8);
+    std.mem.writeIntLittle(u32, bytes[16..20], 8);
+    std.mem.writeIntLittle(u32, bytes[28..32], 4);
+    std.mem.writeIntLittle(u32, bytes[80..84], ddpf_fourcc);
+    std.mem.copy(u8, bytes[84..88], "DXT1");
+
+    const file = try TextureFile.parse(&bytes);
+    std.testing.expectEqual(PixelFormat.bc1, file.format);
+    std.testing.expectEqual(@as(u32, 4), file.num_levels);
+    std.testing.expectEqual(@as(usize, 32), file.levels[0].data.len);
+    for (file.levels[1..4]) |level| std.testing.expectEqual(@as(usize, 8), level.data.len);
+    std.testing.expectEqual(@as(usize, bytes.len - 8), @ptrToInt(file.levels[3].data.ptr) - @ptrToInt(&bytes));
+
+    std.mem.copy(u8, bytes[84..88], "ATI2");
+    std.testing.expectError(error.UnsupportedFormat, TextureFile.parse(&bytes));
+    std.testing.expectError(error.InvalidFile, TextureFile.parse("PNG"));
+}
+
+test "pixel format sizes" {
+    std.testing.expectEqual(@as(u32, 6), PixelFormat.rg8.rowPitch(3));
+    std.testing.expectEqual(@as(u32, 16), PixelFormat.bc1.rowPitch(5));
+    std.testing.expectEqual(@as(u32, 64), PixelFormat.bc3.imageSize(7, 5));
+    std.testing.expectEqual(@as(u32, 16), PixelFormat.astc_4x4.imageSize(1, 1));
+    std.testing.expectEqual(@as(i32, 1), renderkit.mipSize(8, 5));
+}
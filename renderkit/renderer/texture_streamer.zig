@@ -0,0 +1,330 @@
+const std = @import("std");
+usingnamespace @import("types.zig");
+usingnamespace @import("descriptions.zig");
+
+/// creates images whose pixels are decoded or converted on a pool of worker threads. The image handle is created right
+/// away and `resolve` swaps in a transparent placeholder until its pixels are uploaded. Uploads happen in `update`,
+/// once per frame, in row bands limited by `upload_budget` so streaming many textures never causes a large hitch.
+/// Everything except decoding runs on the render thread. Backend only needs createImage, destroyImage and
+/// updateImageRegion, the tests count the bytes that reach it to check the budget.
+pub fn TextureStreamer(comptime Backend: type) type {
+    return struct {
+        const Self = @This();
+        pub const default_upload_budget: u32 = 2 * 1024 * 1024;
+
+        const Job = struct {
+            image: Image,
+            width: u32,
+            height: u32,
+            source: ImageSource,
+            /// allocated and freed on the render thread, only written by the worker that decodes the job
+            pixels: []u32,
+            failed: bool = false,
+            cancelled: bool = false,
+            uploaded_rows: u32 = 0,
+        };
+
+        const Worker = struct {
+            streamer: *Self,
+            thread: *std.Thread = undefined,
+            event: std.AutoResetEvent = .{},
+        };
+
+        allocator: *std.mem.Allocator,
+        upload_budget: u32 = default_upload_budget,
+        placeholder: Image = 0,
+        started: bool = false,
+        workers: []Worker = undefined,
+        quit: bool = false,
+        mutex: std.Mutex = .{},
+        /// jobs waiting for a worker and jobs a worker finished, both guarded by `mutex`
+        queued: std.ArrayList(*Job),
+        decoded: std.ArrayList(*Job),
+        /// decoded jobs in upload order, render thread only
+        ready: std.ArrayList(*Job),
+        /// images that are not uploaded yet, render thread only
+        pending: std.AutoHashMap(Image, *Job),
+
+        pub fn init(allocator: *std.mem.Allocator) Self {
+            return .{
+                .allocator = allocator,
+                .queued = std.ArrayList(*Job).init(allocator),
+                .decoded = std.ArrayList(*Job).init(allocator),
+                .ready = std.ArrayList(*Job).init(allocator),
+                .pending = std.AutoHashMap(Image, *Job).init(allocator),
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            if (self.started) {
+                @atomicStore(bool, &self.quit, true, .SeqCst);
+                for (self.workers) |*worker| {
+                    worker.event.set();
+                    worker.thread.wait();
+                }
+                self.allocator.free(self.workers);
+                Backend.destroyImage(self.placeholder);
+            }
+
+            for (self.queued.items) |job| self.freeJob(job);
+            for (self.decoded.items) |job| self.freeJob(job);
+            for (self.ready.items) |job| self.freeJob(job);
+            self.queued.deinit();
+            self.decoded.deinit();
+            self.ready.deinit();
+            self.pending.deinit();
+        }
+
+        /// creates the placeholder and spawns one worker per core, leaving a core to the render thread
+        fn start(self: *Self) void {
+            self.started = true;
+
+            const transparent: u32 = 0;
+            self.placeholder = Backend.createImage(.{ .width = 1, .height = 1, .content = &transparent });
+
+            const cpu_count = std.Thread.cpuCount() catch 1;
+            const num_workers = if (std.builtin.single_threaded) 0 else std.math.max(1, cpu_count - 1);
+            self.workers = self.allocator.alloc(Worker, num_workers) catch unreachable;
+            if (!std.builtin.single_threaded) {
+                for (self.workers) |*worker| {
+                    worker.* = .{ .streamer = self };
+                    worker.thread = std.Thread.spawn(worker, workerMain) catch unreachable;
+                }
+            }
+        }
+
+        /// creates a dynamic image without content and queues its pixels for decoding
+        pub fn createImageAsync(self: *Self, desc: ImageDesc, source: ImageSource) Image {
+            // sources are always converted to rgba8
+            std.debug.assert(desc.pixel_format == .rgba8);
+            if (!self.started) self.start();
+
+            var image_desc = desc;
+            image_desc.usage = .dynamic;
+            image_desc.content = null;
+            const image = Backend.createImage(image_desc);
+
+            const width = @intCast(u32, desc.width);
+            const height = @intCast(u32, desc.height);
+            const job = self.allocator.create(Job) catch unreachable;
+            job.* = .{
+                .image = image,
+                .width = width,
+                .height = height,
+                .source = source,
+                .pixels = self.allocator.alloc(u32, width * height) catch unreachable,
+            };
+            self.pending.put(image, job) catch unreachable;
+
+            {
+                const held = self.mutex.acquire();
+                defer held.release();
+                self.queued.append(job) catch unreachable;
+            }
+            // idle workers go back to sleep if another one got to the job first
+            for (self.workers) |*worker| worker.event.set();
+
+            return image;
+        }
+
+        /// the placeholder while `image` is streaming, `image` otherwise
+        pub fn resolve(self: Self, image: Image) Image {
+            if (image == 0 or self.pending.count() == 0) return image;
+            return if (self.pending.contains(image)) self.placeholder else image;
+        }
+
+        pub fn isReady(self: Self, image: Image) bool {
+            return !self.pending.contains(image);
+        }
+
+        /// stops streaming into `image`, which is about to be destroyed. The job is freed once no worker holds it.
+        pub fn cancel(self: *Self, image: Image) void {
+            const entry = self.pending.remove(image) orelse return;
+            @atomicStore(bool, &entry.value.cancelled, true, .SeqCst);
+        }
+
+        /// uploads decoded pixels in order, at most `upload_budget` bytes per call but always at least one row. Call
+        /// once per frame.
+        pub fn update(self: *Self) void {
+            if (!self.started) return;
+
+            {
+                const held = self.mutex.acquire();
+                defer held.release();
+                self.ready.appendSlice(self.decoded.items) catch unreachable;
+                self.decoded.items.len = 0;
+            }
+
+            // without workers the render thread decodes one image per frame
+            if (self.workers.len == 0) {
+                if (self.takeJob()) |job| {
+                    if (!job.cancelled) job.failed = !decode(job);
+                    self.ready.append(job) catch unreachable;
+                }
+            }
+
+            var budget = self.upload_budget;
+            var uploaded_any = false;
+            while (self.ready.items.len > 0) {
+                const job = self.ready.items[0];
+                if (!job.cancelled) {
+                    if (job.failed) {
+                        if (std.builtin.mode == .Debug) std.debug.print("failed to decode streamed image {}\n", .{job.image});
+                        std.mem.set(u32, job.pixels, 0);
+                        job.failed = false;
+                    }
+
+                    const row_bytes = job.width * 4;
+                    var rows = std.math.min(job.height - job.uploaded_rows, budget / row_bytes);
+                    if (rows == 0) {
+                        if (uploaded_any) break;
+                        rows = 1;
+                    }
+
+                    const first = job.uploaded_rows * job.width;
+                    const pixels = job.pixels[first .. first + rows * job.width];
+                    Backend.updateImageRegion(u32, job.image, 0, @intCast(i32, job.uploaded_rows), @intCast(i32, job.width), @intCast(i32, rows), 0, pixels);
+                    job.uploaded_rows += rows;
+                    budget -= std.math.min(budget, rows * row_bytes);
+                    uploaded_any = true;
+
+                    if (job.uploaded_rows < job.height) break;
+                    _ = self.pending.remove(job.image);
+                }
+
+                _ = self.ready.orderedRemove(0);
+                self.freeJob(job);
+            }
+        }
+
+        fn takeJob(self: *Self) ?*Job {
+            const held = self.mutex.acquire();
+            defer held.release();
+            if (self.queued.items.len == 0) return null;
+            return self.queued.orderedRemove(0);
+        }
+
+        fn workerMain(worker: *Worker) void {
+            const self = worker.streamer;
+            while (!@atomicLoad(bool, &self.quit, .SeqCst)) {
+                const job = self.takeJob() orelse {
+                    worker.event.wait();
+                    continue;
+                };
+
+                // a job cancelled while decoding is still decoded, it is skipped when uploading
+                const failed = if (@atomicLoad(bool, &job.cancelled, .SeqCst)) false else !decode(job);
+
+                const held = self.mutex.acquire();
+                defer held.release();
+                job.failed = failed;
+                self.decoded.append(job) catch unreachable;
+            }
+        }
+
+        fn decode(job: *Job) bool {
+            switch (job.source) {
+                .pixels => |src| convertPixels(src.format, src.data, src.row_pitch, job.width, job.height, job.pixels),
+                .decoder => |decoder| return decoder.decodeFn(decoder.context, job.pixels),
+            }
+            return true;
+        }
+
+        fn freeJob(self: *Self, job: *Job) void {
+            self.allocator.free(job.pixels);
+            self.allocator.destroy(job);
+        }
+    };
+}
+
+/// converts `width` x `height` pixels of `format` to rgba8. `row_pitch` is the number of bytes between rows of `src`, 0
+/// if they are tightly packed.
+pub fn convertPixels(format: SourceFormat, src: []const u8, row_pitch: u32, width: u32, height: u32, out: []u32) void {
+    const bpp = format.bytesPerPixel();
+    const pitch = if (row_pitch == 0) width * bpp else row_pitch;
+    std.debug.assert(src.len >= pitch * (height - 1) + width * bpp and out.len >= width * height);
+
+    var y: u32 = 0;
+    while (y < height) : (y += 1) {
+        const row = src[y * pitch .. y * pitch + width * bpp];
+        const dst = std.mem.sliceAsBytes(out[y * width .. (y + 1) * width]);
+
+        switch (format) {
+            .rgba8 => std.mem.copy(u8, dst, row),
+            .bgra8 => {
+                var x: u32 = 0;
+                while (x < width) : (x += 1) {
+                    dst[x * 4 + 0] = row[x * 4 + 2];
+                    dst[x * 4 + 1] = row[x * 4 + 1];
+                    dst[x * 4 + 2] = row[x * 4 + 0];
+                    dst[x * 4 + 3] = row[x * 4 + 3];
+                }
+            },
+            .rgb8 => {
+                var x: u32 = 0;
+                while (x < width) : (x += 1) {
+                    std.mem.copy(u8, dst[x * 4 .. x * 4 + 3], row[x * 3 .. x * 3 + 3]);
+                    dst[x * 4 + 3] = 255;
+                }
+            },
+            .luminance8 => {
+                for (row) |l, x| {
+                    std.mem.set(u8, dst[x * 4 .. x * 4 + 3], l);
+                    dst[x * 4 + 3] = 255;
+                }
+            },
+            .alpha8 => {
+                for (row) |a, x| {
+                    std.mem.set(u8, dst[x * 4 .. x * 4 + 3], 255);
+                    dst[x * 4 + 3] = a;
+                }
+            },
+        }
+    }
+}
+
+test "convert pixels" {
+    var out: [4]u32 = undefined;
+    const bytes = std.mem.sliceAsBytes(out[0..]);
+
+    // 2x2 with a padded row pitch
+    const bgra = [_]u8{ 1, 2, 3, 4, 5, 6, 7, 8, 0, 0, 9, 10, 11, 12, 13, 14, 15, 16, 0, 0 };
+    convertPixels(.bgra8, &bgra, 10, 2, 2, &out);
+    std.testing.expectEqualSlices(u8, &[_]u8{ 3, 2, 1, 4, 7, 6, 5, 8, 11, 10, 9, 12, 15, 14, 13, 16 }, bytes);
+
+    const rgb = [_]u8{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    convertPixels(.rgb8, &rgb, 0, 2, 2, &out);
+    std.testing.expectEqualSlices(u8, &[_]u8{ 1, 2, 3, 255, 4, 5, 6, 255, 7, 8, 9, 255, 10, 11, 12, 255 }, bytes);
+
+    const alpha = [_]u8{ 0, 64, 128, 255 };
+    convertPixels(.alpha8, &alpha, 0, 2, 2, &out);
+    std.testing.expectEqualSlices(u8, &[_]u8{ 255, 255, 255, 0, 255, 255, 255, 64, 255, 255, 255, 128, 255, 255, 255, 255 }, bytes);
+}
+
+const Recording = @import("dummy/recording.zig");
+
+test "streamer substitutes a placeholder and uploads within the budget" {
+    Recording.reset();
+    var streamer = TextureStreamer(Recording).init(std.testing.allocator);
+    defer streamer.deinit();
+    streamer.upload_budget = 64 * 4 * 8; // 8 rows of a 64 pixel wide image
+
+    var gray = [_]u8{128} ** (64 * 64);
+    const a = streamer.createImageAsync(.{ .width = 64, .height = 64 }, .{ .pixels = .{ .data = &gray, .format = .luminance8 } });
+    const b = streamer.createImageAsync(.{ .width = 64, .height = 64 }, .{ .pixels = .{ .data = &gray, .format = .luminance8 } });
+    std.testing.expect(streamer.resolve(a) == streamer.placeholder);
+    std.testing.expect(!streamer.isReady(b));
+
+    var frames: u32 = 0;
+    while (!streamer.isReady(a) or !streamer.isReady(b)) : (frames += 1) {
+        std.testing.expect(frames < 100_000);
+        streamer.update();
+        std.time.sleep(10_000);
+    }
+
+    std.testing.expect(streamer.resolve(a) == a);
+    std.testing.expectEqual(@as(usize, 2 * 64 * 64 * 4), Recording.uploaded_bytes);
+    std.testing.expect(Recording.max_upload <= streamer.upload_budget);
+    // at 8 rows per frame each image needs at least 8 frames
+    std.testing.expect(frames >= 16);
+}
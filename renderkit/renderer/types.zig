@@ -1,29 +1,117 @@
 const std = @import("std");
 
-/// all resources are guaranteed to never have a handle of 0
-pub const invalid_resource_id: u16 = 0;
+/// all resources are guaranteed to never have a handle of 0. Handles match the layout of `HandledCache`.
+pub const invalid_resource_id: u32 = 0;
 
-pub const Image = u16;
-pub const ShaderProgram = u16;
-pub const Pass = u16;
-pub const Buffer = u16;
+pub const Image = u32;
+pub const ShaderProgram = u32;
+pub const Pass = u32;
+pub const Buffer = u32;
+pub const Pipeline = u32;
 
 pub const TextureFilter = extern enum {
     nearest,
     linear,
 };
 
+/// how the mip level is picked when minifying. `.none` always samples level 0.
+pub const MipFilter = extern enum {
+    none,
+    nearest,
+    linear,
+};
+
 pub const TextureWrap = extern enum {
     clamp,
     repeat,
 };
 
+/// how an image is sampled. Images get theirs from `ImageDesc`, `BufferBindings.samplers` overrides it per slot so one
+/// image can be sampled several ways.
+pub const SamplerDesc = extern struct {
+    min_filter: TextureFilter = .nearest,
+    mag_filter: TextureFilter = .nearest,
+    mip_filter: MipFilter = .none,
+    wrap_u: TextureWrap = .clamp,
+    wrap_v: TextureWrap = .clamp,
+    max_anisotropy: i32 = 1,
+
+    /// packs every field into 10 bits, equal keys mean equal samplers
+    pub fn key(self: SamplerDesc) u32 {
+        const anisotropy = @intCast(u32, std.math.clamp(self.max_anisotropy, 1, 16) - 1);
+        return @intCast(u32, @enumToInt(self.min_filter)) |
+            @intCast(u32, @enumToInt(self.mag_filter)) << 1 |
+            @intCast(u32, @enumToInt(self.mip_filter)) << 2 |
+            @intCast(u32, @enumToInt(self.wrap_u)) << 4 |
+            @intCast(u32, @enumToInt(self.wrap_v)) << 5 |
+            anisotropy << 6;
+    }
+};
+
+/// texel layouts. Compressed formats are stored in 4x4 blocks, check `renderer.isPixelFormatSupported` before using them.
 pub const PixelFormat = extern enum {
     rgba8,
     stencil,
     depth_stencil,
+    r8,
+    rg8,
+    rgb565,
+    bc1, // DXT1, rgb with 1 bit alpha
+    bc3, // DXT5, rgba
+    bc7,
+    etc2_rgb8,
+    etc2_rgba8,
+    astc_4x4,
+
+    pub fn isCompressed(self: PixelFormat) bool {
+        return self.blockDim() > 1;
+    }
+
+    /// width and height in texels of a block, 1 for uncompressed formats
+    pub fn blockDim(self: PixelFormat) u32 {
+        return switch (self) {
+            .bc1, .bc3, .bc7, .etc2_rgb8, .etc2_rgba8, .astc_4x4 => 4,
+            else => 1,
+        };
+    }
+
+    /// bytes per block, which is bytes per texel for uncompressed formats
+    pub fn bytesPerBlock(self: PixelFormat) u32 {
+        return switch (self) {
+            .r8 => 1,
+            .rg8, .rgb565 => 2,
+            .rgba8, .stencil, .depth_stencil => 4,
+            .bc1, .etc2_rgb8 => 8,
+            .bc3, .bc7, .etc2_rgba8, .astc_4x4 => 16,
+        };
+    }
+
+    /// bytes of a tightly packed row of blocks
+    pub fn rowPitch(self: PixelFormat, width: i32) u32 {
+        const dim = self.blockDim();
+        return (@intCast(u32, width) + dim - 1) / dim * self.bytesPerBlock();
+    }
+
+    /// bytes of a tightly packed width x height image, which is what glCompressedTexImage2D expects as image size
+    pub fn imageSize(self: PixelFormat, width: i32, height: i32) u32 {
+        const dim = self.blockDim();
+        return self.rowPitch(width) * ((@intCast(u32, height) + dim - 1) / dim);
+    }
 };
 
+/// size of mip level `level` of an image `size` texels wide or high
+pub fn mipSize(size: i32, level: i32) i32 {
+    return std.math.max(1, size >> @intCast(u5, level));
+}
+
+/// number of levels in a full mip chain, down to 1x1
+pub fn mipCount(width: i32, height: i32) i32 {
+    var count: i32 = 1;
+    var size = std.math.max(width, height);
+    while (size > 1) : (size >>= 1) count += 1;
+    return count;
+}
+
 pub const Usage = extern enum {
     immutable,
     dynamic,
@@ -150,6 +238,50 @@ pub const RenderState = extern struct {
     scissor: bool = false,
 };
 
+/// how draws within a pass are submitted. `sorted` and `stable` record draws and replay them at `endPass`, merging
+/// adjacent draws that share state. `sorted` reorders by shader, render state, texture and buffer while `stable` keeps
+/// submission order for layers where it matters (transparency, UI).
+pub const DrawOrder = enum {
+    immediate,
+    sorted,
+    stable,
+};
+
+/// counters for the OpenGL Vertex Array Object cache. Backends without one report zeros.
+pub const VertexArrayCacheStats = struct {
+    hits: u32 = 0,
+    misses: u32 = 0,
+    evictions: u32 = 0,
+    live: u32 = 0,
+};
+
+/// shader program creation counters. `cold_ns` is time spent compiling and linking from source, `warm_ns` time spent
+/// loading programs from the program binary cache. `rejected` binaries were refused by the driver and rebuilt.
+pub const ShaderCacheStats = struct {
+    hits: u32 = 0,
+    misses: u32 = 0,
+    rejected: u32 = 0,
+    cold_ns: u64 = 0,
+    warm_ns: u64 = 0,
+};
+
+/// appendBuffer telemetry for a single buffer. `high_water` is the most bytes a single frame tried to append, including
+/// bytes that didn't fit. Spilled bytes went to the overflow block of a growable buffer, dropped bytes were lost.
+pub const BufferStats = extern struct {
+    size: u32 = 0,
+    high_water: u32 = 0,
+    overflow_frames: u32 = 0,
+    grow_count: u32 = 0,
+    spilled_bytes: u64 = 0,
+    dropped_bytes: u64 = 0,
+};
+
+/// identifies an asynchronous image upload. See `isUploadComplete`.
+pub const UploadToken = extern struct {
+    /// frame_index of the frame the upload was issued in
+    frame: u32 = 0,
+};
+
 pub const ClearCommand = extern struct {
     color_action: ClearAction = .clear,
     color: [4]f32 = [_]f32{ 0.8, 0.2, 0.3, 1.0 },
@@ -159,11 +291,25 @@ pub const ClearCommand = extern struct {
     depth: f64 = 0,
 };
 
+/// an indexed draw from the bound buffers. `base_vertex` is added to every index and `base_instance` offsets the per
+/// instance buffers, so many meshes can be sub-allocated in one shared buffer and drawn under a single binding with
+/// indices relative to their own first vertex.
+pub const DrawCommand = extern struct {
+    primitive_type: PrimitiveType = .triangles,
+    base_element: c_int = 0,
+    element_count: c_int,
+    instance_count: c_int = 1,
+    base_vertex: c_int = 0,
+    base_instance: c_int = 0,
+};
+
 pub const BufferBindings = struct {
     index_buffer: Buffer,
     vert_buffers: [4]Buffer,
     vertex_buffer_offsets: [4]u32 = [_]u32{0} ** 4,
     images: [8]Image = [_]Image{0} ** 8,
+    /// null samples the image with the sampler from its `ImageDesc`
+    samplers: [8]?SamplerDesc = [_]?SamplerDesc{null} ** 8,
 
     pub fn init(index_buffer: Buffer, vert_buffers: []Buffer) BufferBindings {
         var vbuffers: [4]Buffer = [_]Buffer{0} ** 4;
@@ -179,10 +325,24 @@ pub const BufferBindings = struct {
         self.images[slot] = image;
     }
 
+    /// samples the image in `slot` with `sampler` instead of its own
+    pub fn bindSampler(self: *BufferBindings, sampler: SamplerDesc, slot: c_uint) void {
+        self.samplers[slot] = sampler;
+    }
+
     pub fn eq(self: BufferBindings, other: BufferBindings) bool {
         return self.index_buffer == other.index_buffer and
             std.mem.eql(Buffer, &self.vert_buffers, &other.vert_buffers) and
             std.mem.eql(u32, &self.vertex_buffer_offsets, &other.vertex_buffer_offsets) and
-            std.mem.eql(Image, &self.images, &other.images);
+            std.mem.eql(Image, &self.images, &other.images) and
+            samplersEql(self.samplers, other.samplers);
+    }
+
+    fn samplersEql(a: [8]?SamplerDesc, b: [8]?SamplerDesc) bool {
+        for (a) |sampler, i| {
+            if ((sampler == null) != (b[i] == null)) return false;
+            if (sampler != null and sampler.?.key() != b[i].?.key()) return false;
+        }
+        return true;
     }
 };
\ No newline at end of file
@@ -15,6 +15,16 @@ pub const current_renderer: Renderer = if (@hasDecl(@import("root"), "build_opti
 // export the backend only explicitly (leaving gfx object methods only accessible via renderer.METHOD)
 // and some select, higher level types and methods
 pub const Renderer = renderer.Renderer;
+pub const Handles = @import("renderer/handles.zig").Handles;
+pub const HandledCache = @import("renderer/handles.zig").HandledCache;
+pub const TextureStreamer = @import("renderer/texture_streamer.zig").TextureStreamer;
+pub const TextureFile = @import("renderer/texture_file.zig").TextureFile;
+pub const TextureAtlas = @import("renderer/texture_atlas.zig").TextureAtlas;
+pub const SpriteBatch = @import("renderer/sprite_batch.zig").SpriteBatch;
+pub const Sprite = @import("renderer/sprite_batch.zig").Sprite;
+pub const mipmaps = @import("renderer/mipmaps.zig");
+pub const quads = @import("renderer/quads.zig");
 pub const setRenderState = renderer.setRenderState;
+pub const resetStateCache = renderer.resetStateCache;
 pub const viewport = renderer.viewport;
 pub const scissor = renderer.scissor;